@@ -0,0 +1,133 @@
+#ifndef LSM9DS1_FIFO_H_
+#define LSM9DS1_FIFO_H_
+
+#include <Wire.h>
+
+#include "air_mouse.h"
+
+/*
+ * Minimal driver of the LSM9DS1 accelerometer and gyroscope of the
+ * Nano 33 BLE (rev1), on its internal I2C bus.
+ *
+ * Both sensors run at 238Hz into the 32 samples FIFO of the IMU, in continuous
+ * mode : the samples gathered since the last call are read in a single burst,
+ * so the MCU can sleep between bursts instead of waking up for each sample.
+ */
+class LSM9DS1Fifo {
+ public:
+  static const int kFifoSize = 32;
+
+  // Output rate and sensitivities of the configuration below.
+  static constexpr float kSampleRate       = 238.0f;      // in Hz.
+  static constexpr float kGyroSensitivity  = 0.0175f;     // in dps per LSB (500dps full scale).
+  static constexpr float kAccelSensitivity = 0.000122f;   // in g per LSB (4g full scale).
+
+ private:
+  static const uint8_t kAddress       = 0x6B;
+
+  static const uint8_t WHO_AM_I       = 0x0F;
+  static const uint8_t CTRL_REG1_G    = 0x10;
+  static const uint8_t OUT_X_L_G      = 0x18;
+  static const uint8_t CTRL_REG6_XL   = 0x20;
+  static const uint8_t CTRL_REG8      = 0x22;
+  static const uint8_t CTRL_REG9      = 0x23;
+  static const uint8_t OUT_X_L_XL     = 0x28;
+  static const uint8_t FIFO_CTRL      = 0x2E;
+  static const uint8_t FIFO_SRC       = 0x2F;
+
+  static const uint8_t kWhoAmI        = 0x68;
+
+ public:
+  LSM9DS1Fifo() :
+    overruns_(0)
+  {}
+
+  /* Configure the IMU, return false when it does not answer. */
+  bool initialize()
+  {
+    Wire1.begin();
+    Wire1.setClock(400000);
+
+    if (readRegister(WHO_AM_I) != kWhoAmI) {
+      return false;
+    }
+
+    writeRegister(CTRL_REG8,    0x05);  // software reset.
+    delay(10);
+    writeRegister(CTRL_REG8,    0x44);  // block data update, address auto-increment.
+    writeRegister(CTRL_REG1_G,  0x88);  // gyro 238Hz, 500dps.
+    writeRegister(CTRL_REG6_XL, 0x90);  // accelerometer 238Hz, 4g.
+    writeRegister(FIFO_CTRL,    0x00);  // bypass mode, emptying the FIFO.
+    writeRegister(CTRL_REG9,    0x02);  // FIFO enabled.
+    writeRegister(FIFO_CTRL,    0xC0);  // continuous mode.
+    return true;
+  }
+
+  /* Read up to maxSamples samples from the FIFO, oldest first, and return
+   * their number. */
+  int read(AirMouse::sample_t *samples, int maxSamples)
+  {
+    const uint8_t status = readRegister(FIFO_SRC);
+    overruns_ += (status & 0x40) ? 1 : 0;
+
+    int count = status & 0x3F;
+    count = (count < maxSamples) ? count : maxSamples;
+    for (int i = 0; i < count; ++i) {
+      // (the FIFO moves to the next sample once its accelerometer is read)
+      readVector(OUT_X_L_G, samples[i].gyro);
+      readVector(OUT_X_L_XL, samples[i].accel);
+    }
+    return count;
+  }
+
+  /* Number of reads which found the FIFO overrun, samples being lost. */
+  unsigned overruns() const {
+    return overruns_;
+  }
+
+ private:
+  void writeRegister(uint8_t reg, uint8_t value)
+  {
+    Wire1.beginTransmission(kAddress);
+    Wire1.write(reg);
+    Wire1.write(value);
+    Wire1.endTransmission();
+  }
+
+  uint8_t readRegister(uint8_t reg)
+  {
+    uint8_t value = 0;
+    readRegisters(reg, &value, 1);
+    return value;
+  }
+
+  bool readRegisters(uint8_t reg, uint8_t *data, size_t size)
+  {
+    Wire1.beginTransmission(kAddress);
+    Wire1.write(reg);
+    if (Wire1.endTransmission(false) != 0) {
+      return false;
+    }
+    if (Wire1.requestFrom(kAddress, size) != size) {
+      return false;
+    }
+    for (size_t i = 0; i < size; ++i) {
+      data[i] = Wire1.read();
+    }
+    return true;
+  }
+
+  /* Read the X, Y and Z little-endian outputs from reg. */
+  void readVector(uint8_t reg, int16_t v[3])
+  {
+    uint8_t data[6] = {};
+    readRegisters(reg, data, sizeof(data));
+    for (int i = 0; i < 3; ++i) {
+      v[i] = static_cast<int16_t>(data[2*i] | (data[2*i + 1] << 8));
+    }
+  }
+
+  unsigned overruns_;
+};
+
+#endif // LSM9DS1_FIFO_H_
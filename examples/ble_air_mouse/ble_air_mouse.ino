@@ -0,0 +1,105 @@
+///
+///   ble_air_mouse.ino
+///
+///   created: 2026-10
+///
+///  Turn the Arduino nano 33 BLE into a wireless air mouse : the pointer follows
+///  the rotations of the board, measured by its LSM9DS1 IMU and sent with the
+///  BLE HID-over-GATT Profile (HOGP) on a mbed stack.
+///
+///  Hold the board still for half a second after power-up, while the gyroscope
+///  bias is measured, then point with the X axis of the IMU.
+///
+
+#include "Nano33BleHID.h"
+#include "LSM9DS1Fifo.h"
+#include "air_mouse.h"
+#include "signal_utils.h"
+
+// Print the raw IMU samples on the serial port, to be replayed on the host
+// with extras/host imu_replay.
+#define AIR_MOUSE_RECORD_SERIAL         0
+
+/* -------------------------------------------------------------------------- */
+
+Nano33BleMouse bleMouse("nano33BLE Air Mouse");
+
+// IMU read by bursts, and the pointer pipeline fed with its samples.
+LSM9DS1Fifo gImu;
+AirMouse gAirMouse(LSM9DS1Fifo::kSampleRate,
+                   LSM9DS1Fifo::kGyroSensitivity,
+                   LSM9DS1Fifo::kAccelSensitivity);
+
+// Left button, to ground.
+static const int kButtonPin = 2;
+
+// Builtin LED animation delays when disconnect.
+static const int kLedBeaconDelayMilliseconds = 1250;
+static const int kLedErrorDelayMilliseconds = kLedBeaconDelayMilliseconds / 10;
+
+// Builtin LED intensity when connected.
+static const int kLedConnectedIntensity = 30;
+
+static bool sImuReady = false;
+
+/* -------------------------------------------------------------------------- */
+
+void setup()
+{
+  // General setup.
+  pinMode(LED_BUILTIN, OUTPUT);
+  pinMode(kButtonPin, INPUT_PULLUP);
+#if AIR_MOUSE_RECORD_SERIAL
+  Serial.begin(115200);
+#endif
+  sImuReady = gImu.initialize();
+
+  // Initialize both BLE and the HID.
+  bleMouse.initialize();
+
+  // Launch the event queue that will manage both BLE events and the loop.
+  // After this call the main thread will be halted.
+  MbedBleHID_RunEventThread();
+}
+
+void loop()
+{
+  // Process the samples gathered in the IMU FIFO since the last loop, the MCU
+  // sleeping in between. This also runs while disconnected, so the gyro bias
+  // is known by the time the host connects.
+  AirMouse::sample_t samples[LSM9DS1Fifo::kFifoSize];
+  const int numSamples = sImuReady ? gImu.read(samples, LSM9DS1Fifo::kFifoSize) : 0;
+  for (int i = 0; i < numSamples; ++i) {
+    gAirMouse.update(samples[i]);
+#if AIR_MOUSE_RECORD_SERIAL
+    const int16_t *values[] = { samples[i].accel, samples[i].gyro };
+    for (int j = 0; j < 6; ++j) {
+      Serial.print(static_cast<long>(values[j / 3][j % 3]));
+      Serial.print((j < 5) ? "," : "\n");
+    }
+#endif
+  }
+  int dx, dy;
+  gAirMouse.takeMotion(&dx, &dy);
+
+  // When disconnected, we animate the builtin LED to indicate the device state.
+  if (bleMouse.connected() == false) {
+    animateLED(LED_BUILTIN, (bleMouse.has_error() || !sImuReady) ? kLedErrorDelayMilliseconds
+                                                                 : kLedBeaconDelayMilliseconds);
+    return;
+  }
+
+  // When connected, we slightly dim the builtin LED.
+  analogWrite(LED_BUILTIN, kLedConnectedIntensity);
+
+  auto buttons = !digitalRead(kButtonPin) ? HIDMouseService::BUTTON_LEFT
+                                          : HIDMouseService::BUTTON_NONE;
+
+  // Update the HID report.
+  auto *mouse = bleMouse.hid();
+  mouse->motionCounts(dx, dy);
+  mouse->button(buttons);
+  mouse->SendReport();
+}
+
+/* -------------------------------------------------------------------------- */
@@ -1,63 +1,240 @@
 #ifndef ANALOG_JOYSTICK_H_
 #define ANALOG_JOYSTICK_H_
 
+#include <atomic>
+
+#include "adc_scanner.h"
+#include "axis_calibration.h"
+#include "calibration_store.h"
 #include "signal_utils.h"
+#include "one_euro_filter.h"
 
 
 class AnalogJoystick {  
  private:
-  static const int kDefaultCalibrationSamples = 8;
-  static const int kDefaultCalibrationSamplingDelay = 50;
+  // Scanner buffers averaged as the rest position (64ms at the default period),
+  // when there is no stored calibration.
+  static const int kDefaultCalibrationBuffers = AdcScanner::kDefaultCalibrationBuffers;
 
   static constexpr float MAX_POWER_SUPPLY  = 5.0f;
   static constexpr float POWER_SUPPLY      = 5.0f;
   static constexpr float kPSUFactor = POWER_SUPPLY / MAX_POWER_SUPPLY;
+  static constexpr float kFullScale = AdcScanner::kMaxValue * kPSUFactor;
+
+  // Stored calibration, saved again when it moved by more than the tolerance
+  // (in ADC units), at most once per interval.
+  static constexpr const char *kCalibrationKey        = "/kv/joystick";
+  static const uint16_t kCalibrationVersion           = 1;
+  static constexpr float kCalibrationSaveTolerance    = 8.0f;
+  static const unsigned long kCalibrationSaveInterval = 60000;  // in ms.
+
+  // Longest interval between updates still filtered, longer ones (eg. while
+  // disconnected) restarting the filters from the current sample.
+  static const unsigned long kMaxUpdateInterval = 100000;       // in us.
+
+  // State of the calibration handed over for saving.
+  enum SaveState : uint8_t {
+    SAVE_IDLE,
+    SAVE_PENDING,
+    SAVE_DONE,
+    SAVE_FAILED,
+  };
+
+  // One Euro filter of the axes, tuned with extras/host filter_eval to add no
+  // lag over the previous constant damping (0.1 to 0.4ms on the synthetic
+  // traces) while reducing the jitter at rest by about 15%. The speed estimate
+  // must follow the motion onsets closely (derivative cutoff), and the cutoff
+  // rise with it steeply (beta) : a lower beta halves the jitter at rest, but
+  // at the cost of a few milliseconds of lag on fast motions.
+  static constexpr float kDefaultMinCutoff        = 1.0f;     // in Hz.
+  static constexpr float kDefaultBeta             = 128.0f;
+  static constexpr float kDefaultDerivativeCutoff = 32.0f;    // in Hz.
 
  public:
+  struct calibration_record_t {
+    AxisCalibration::data_t x;
+    AxisCalibration::data_t y;
+  };
+
   AnalogJoystick(int pin_x, int pin_y, int pin_button) :
     pin_x_(pin_x),
     pin_y_(pin_y),
     pin_button_(pin_button),
+    channel_x_(-1),
+    channel_y_(-1),
+    calibration_x_(kFullScale),
+    calibration_y_(kFullScale),
+    calibrated_(false),
+    saved_(false),
+    last_save_time_(0ul - kCalibrationSaveInterval),  // (first save right away)
+    save_state_(SAVE_IDLE),
+    filter_x_(kDefaultMinCutoff, kDefaultBeta, kDefaultDerivativeCutoff),
+    filter_y_(kDefaultMinCutoff, kDefaultBeta, kDefaultDerivativeCutoff),
+    last_update_time_(0),
+    updating_(false),
     x_(0.0f),
     y_(0.0f),
     button_(0)
   {}
 
-  /* To call once to calibrate joysticks. */
-  void initialize(int numSamples = kDefaultCalibrationSamples,
-                  int samplingDelay = kDefaultCalibrationSamplingDelay)
+  /* Set the One Euro filter parameters of both axes (see OneEuroFilter). */
+  void setFilterParameters(float minCutoff, float beta, float derivativeCutoff = kDefaultDerivativeCutoff)
+  {
+    filter_x_.setParameters(minCutoff, beta, derivativeCutoff);
+    filter_y_.setParameters(minCutoff, beta, derivativeCutoff);
+  }
+
+  /* To call once : start the acquisition and load the stored calibration,
+   * or measure the rest position in the background when there is none. */
+  void initialize(int numCalibrationBuffers = kDefaultCalibrationBuffers)
   {
-    calibration_x_ = 0.0f;
-    calibration_y_ = 0.0f;
-    for (int i = 0; i < numSamples; ++i)
-    {
-      update(false);
-      calibration_x_ += x_;
-      calibration_y_ += y_;
-      delay(samplingDelay);
+    auto &adc = AdcScanner::Get();
+    channel_x_ = adc.addPin(pin_x_);
+    channel_y_ = adc.addPin(pin_y_);
+    MBED_ASSERT((channel_x_ >= 0) && (channel_y_ >= 0));
+    adc.start();
+
+    saved_ = calibration_store::Load(kCalibrationKey, kCalibrationVersion, &saved_calibration_)
+          && calibration_x_.load(saved_calibration_.x)
+          && calibration_y_.load(saved_calibration_.y);
+    calibrated_ = saved_;
+    if (!calibrated_) {
+      adc.calibrate(numCalibrationBuffers);
     }
-    calibration_x_ /= numSamples;
-    calibration_y_ /= numSamples;
-    // save calibration as default value if filtering is used afterwards.
-    x_ = calibration_x_;
-    y_ = calibration_y_;
+
+    x_ = 0.0f;
+    y_ = 0.0f;
+    filter_x_.reset();
+    filter_y_.reset();
+    updating_ = false;
+  }
+
+  /* Is the rest position known ? The axes stay centered until then. */
+  bool calibrated() const {
+    return calibrated_;
   }
 
   void update(bool bFilter=true)
-  {    
-    x_ = analogRead(pin_x_);
-    y_ = analogRead(pin_y_);
-
-    const float minValue = 0.0f;
-    const float maxValue = lerp(0.0f, 1023.0f, kPSUFactor);
-    x_ = mmap(x_, minValue, maxValue, -1.0f, 1.0f);
-    y_ = mmap(y_, minValue, maxValue, -1.0f, 1.0f);
-    
+  {
+    // Latest values averaged by the scanner, this never waits for a conversion.
+    auto &adc = AdcScanner::Get();
+    uint16_t values[AdcScanner::kMaxChannels];
+    adc.read(values);
+    const float sample_x = values[channel_x_];
+    const float sample_y = values[channel_y_];
+
     button_ = !digitalRead(pin_button_);
 
+    // Updates resuming after a pause restart the filters rather than
+    // spanning it, the rest position not drifting over it either.
+    const unsigned long now = micros();
+    const bool resumed = !updating_ || (now - last_update_time_ > kMaxUpdateInterval);
+    const float dt = resumed ? 0.0f : (now - last_update_time_) * 1.0e-6f;
+    last_update_time_ = now;
+    updating_ = true;
+    if (resumed) {
+      filter_x_.reset();
+      filter_y_.reset();
+    }
+
+    if (!calibrated_) {
+      if (!adc.calibrated()) {
+        x_ = 0.0f;
+        y_ = 0.0f;
+        return;
+      }
+      calibration_x_.reset(adc.calibration(channel_x_));
+      calibration_y_.reset(adc.calibration(channel_y_));
+      calibrated_ = true;
+    }
+
+    // Follow the range and the drift of the rest position.
+    calibration_x_.track(sample_x, dt);
+    calibration_y_.track(sample_y, dt);
+
+    x_ = calibration_x_.normalize(sample_x);
+    y_ = calibration_y_.normalize(sample_y);
+
     if (bFilter) {
-      filter();
+      filter(dt);
+    }
+  }
+
+  /* Copy to @p record the calibration to store, when it moved since it was
+   * last stored, no save is pending and the last attempt is older than the
+   * save interval. To call from the thread updating the joystick, then hand
+   * the record to saveCalibration().
+   * Return false when there is nothing to store. */
+  bool calibrationToSave(calibration_record_t *record)
+  {
+    const unsigned long now = millis();
+    const uint8_t state = save_state_.load(std::memory_order_acquire);
+    if (state == SAVE_PENDING) {
+      return false;
+    }
+    if (state == SAVE_DONE) {
+      saved_calibration_ = pending_calibration_;
+      saved_ = true;
+    }
+    if (state != SAVE_IDLE) {
+      // (failed attempts wait too, not to write a failing store on every loop)
+      last_save_time_ = now;
     }
+    save_state_.store(SAVE_IDLE, std::memory_order_relaxed);
+
+    if (!calibrated_ || (now - last_save_time_ < kCalibrationSaveInterval)) {
+      return false;
+    }
+    if (saved_ && !calibration_x_.differs(saved_calibration_.x, kCalibrationSaveTolerance)
+               && !calibration_y_.differs(saved_calibration_.y, kCalibrationSaveTolerance)) {
+      return false;
+    }
+
+    pending_calibration_.x = calibration_x_.data();
+    pending_calibration_.y = calibration_y_.data();
+    *record = pending_calibration_;
+    save_state_.store(SAVE_PENDING, std::memory_order_release);
+    return true;
+  }
+
+  /* Store @p record, given by calibrationToSave(). Writing the flash takes a
+   * while : call it from a low priority thread, not from the BLE events one.
+   * Return true when the calibration was written. */
+  bool saveCalibration(const calibration_record_t &record)
+  {
+    const bool saved = calibration_store::Save(kCalibrationKey, kCalibrationVersion, record);
+    save_state_.store(saved ? SAVE_DONE : SAVE_FAILED, std::memory_order_release);
+    return saved;
+  }
+
+  /* Give up the save started by calibrationToSave(), when its record could
+   * not be handed to saveCalibration(). Counts as a failed attempt. */
+  void cancelCalibrationSave()
+  {
+    save_state_.store(SAVE_FAILED, std::memory_order_release);
+  }
+
+  /* Use a known calibration of the axes, eg. measured by the application.
+   * Return false when it is not consistent. */
+  bool setCalibration(const AxisCalibration::data_t &x, const AxisCalibration::data_t &y)
+  {
+    AxisCalibration calibration_x(kFullScale);
+    AxisCalibration calibration_y(kFullScale);
+    if (!calibration_x.load(x) || !calibration_y.load(y)) {
+      return false;
+    }
+    calibration_x_ = calibration_x;
+    calibration_y_ = calibration_y;
+    calibrated_ = true;
+    return true;
+  }
+
+  const AxisCalibration& calibration_x() const {
+    return calibration_x_;
+  }
+
+  const AxisCalibration& calibration_y() const {
+    return calibration_y_;
   }
 
   float x() const {
@@ -72,41 +249,39 @@ class AnalogJoystick {
     return button_;
   }
 
- private:
-  void filter()
+  /* Filter the last sampled values, taken dt seconds after the previous ones. */
+  void filter(float dt)
   {
-    float last_x = x_;
-    float last_y = y_;
-
-    const float eps = 0.001f;
-    if (fabs(x_ - calibration_x_) < eps) {
-      x_ = mmap(x_, -1.0f, calibration_x_, -1.0f, 0.0f);
-    } else {
-      x_ = mmap(x_, calibration_x_, 1.0f, 0.0f, 1.0f);
-    }
-
-    if (fabs(y_ - calibration_y_) < eps) {
-      y_ = mmap(y_, -1.0f, calibration_y_, -1.0f, 0.0f);
-    } else {
-      y_ = mmap(y_, calibration_y_, 1.0f, 0.0f, 1.0f);
-    }
+    // Remove the jitter at rest while following fast motions closely.
+    x_ = filter_x_.filter(x_, dt);
+    y_ = filter_y_.filter(y_, dt);
 
     const float l = 0.01f;
     x_ *= smoothstep(l, 1.0f-l, fabs(x_));
     y_ *= smoothstep(l, 1.0f-l, fabs(y_));
-
-    const float damp_factor = 0.96f;
-    x_ = lerp( last_x, x_, damp_factor);
-    y_ = lerp( last_y, y_, damp_factor);
   }
 
-
+ private:
   int pin_x_;
   int pin_y_;
   int pin_button_;
+  int channel_x_;
+  int channel_y_;
+
+  AxisCalibration calibration_x_;
+  AxisCalibration calibration_y_;
+  bool calibrated_;
+
+  calibration_record_t saved_calibration_;
+  bool saved_;
+  unsigned long last_save_time_;
+  calibration_record_t pending_calibration_;
+  std::atomic<uint8_t> save_state_;
 
-  float calibration_x_;
-  float calibration_y_;
+  OneEuroFilter filter_x_;
+  OneEuroFilter filter_y_;
+  unsigned long last_update_time_;
+  bool updating_;
 
   float x_;
   float y_;
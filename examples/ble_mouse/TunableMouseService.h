@@ -0,0 +1,96 @@
+#ifndef TUNABLE_MOUSE_SERVICE_H_
+#define TUNABLE_MOUSE_SERVICE_H_
+
+#include "services/HIDMouseService.h"
+
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+// Mouse report map with a vendor-defined feature report, the pointer speed.
+// Once a map declares a Report ID, every report must have one.
+uint8_t sTunableMouseReportMap[] =
+{
+  USAGE_PAGE(1),      0x01,       // Usage Page (Generic Desktop)
+  USAGE(1),           0x02,       // Usage (Mouse)
+  COLLECTION(1),      0x01,       // Collection (Application)
+    REPORT_ID(1),       0x01,       // Report ID (1)
+    USAGE(1),           0x01,       // Usage (Pointer)
+    COLLECTION(1),      0x00,       // Collection (Physical)
+      // Buttons
+      USAGE_PAGE(1),      0x09,       // Usage Page (Buttons)
+      USAGE_MINIMUM(1),   0x01,       // Usage Minimum (1)
+      USAGE_MAXIMUM(1),   0x03,       // Usage Maximum (3)
+      LOGICAL_MINIMUM(1), 0x00,       // Logical Minimum (0)
+      LOGICAL_MAXIMUM(1), 0x01,       // Logical Maximum (1)
+      REPORT_COUNT(1),    0x03,       // Report Count (3)
+      REPORT_SIZE(1),     0x01,       // Report Size (1)
+      INPUT(1),           0x02,       // Input (Data, Variable, Absolute)
+      // (padding)
+      REPORT_COUNT(1),    0x01,       // Report Count (1)
+      REPORT_SIZE(1),     0x05,       // Report Size (5)
+      INPUT(1),           0x01,       // Input (Constant) for padding
+      // Coordinates
+      USAGE_PAGE(1),      0x01,       // Usage Page (Generic Desktop)
+      USAGE(1),           0x30,       // Usage (X)
+      USAGE(1),           0x31,       // Usage (Y)
+      LOGICAL_MINIMUM(1), 0x81,       // Logical Minimum (-127)
+      LOGICAL_MAXIMUM(1), 0x7f,       // Logical Maximum (+127)
+      REPORT_SIZE(1),     0x08,       // Report Size (8)
+      REPORT_COUNT(1),    0x02,       // Report Count (2)
+      INPUT(1),           0x06,       // Input (Data, Variable, Relative)
+    END_COLLECTION(0),              // End Collection (Physical)
+    // Pointer speed, in percent
+    REPORT_ID(1),       0x02,       // Report ID (2)
+    USAGE_PAGE(2),      0x00, 0xFF, // Usage Page (Vendor Defined 0xFF00)
+    USAGE(1),           0x01,       // Usage (Vendor Usage 1)
+    LOGICAL_MINIMUM(1), 0x00,       // Logical Minimum (0)
+    LOGICAL_MAXIMUM(2), 0xFF, 0x00, // Logical Maximum (255)
+    REPORT_SIZE(1),     0x08,       // Report Size (8)
+    REPORT_COUNT(1),    0x01,       // Report Count (1)
+    FEATURE(1),         0x02,       // Feature (Data, Variable, Absolute)
+  END_COLLECTION(0),              // End Collection (Application)
+};
+
+} // namespace ""
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Mouse service whose pointer speed is read and set by the host through a
+ * feature report (eg. with the HIDIOCSFEATURE ioctl of hidraw on Linux).
+ */
+class TunableMouseService : public HIDMouseService {
+  public:
+    static const uint8_t kInputReportID    = 1;
+    static const uint8_t kSettingsReportID = 2;
+
+    struct Settings {
+      uint8_t speed;   // in percent.
+    };
+
+    TunableMouseService(BLE &ble) :
+      HIDMouseService(ble, sTunableMouseReportMap, sizeof(sTunableMouseReportMap), kInputReportID),
+      settings_{ 100 }
+    {
+      // The settings are constructed : expose them to the host.
+      addFeatureReport(kSettingsReportID, &settings_);
+    }
+
+    /** Pointer speed factor, as last set by the host or the device. */
+    inline float speed() const { return settings_.speed / 100.0f; }
+
+    /** Change the pointer speed from the device, in percent, as read by the host. */
+    ble_error_t setSpeed(uint8_t speed)
+    {
+      settings_.speed = speed;
+      return updateFeatureReport(kSettingsReportID);
+    }
+
+  private:
+    Settings settings_;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // TUNABLE_MOUSE_SERVICE_H_
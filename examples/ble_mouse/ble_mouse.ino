@@ -9,6 +9,7 @@
 
 #include "Nano33BleHID.h"
 #include "AnalogJoystick.h"
+#include "TunableMouseService.h"
 #include "signal_utils.h"
 
 #define DEMO_ENABLE_RANDOM_INPUT        1
@@ -16,12 +17,22 @@
 
 /* -------------------------------------------------------------------------- */
 
-Nano33BleMouse bleMouse("nano33BLE Mouse");
+// Mouse whose pointer speed can be set by the host, through a feature report.
+Nano33BleHID<TunableMouseService> bleMouse("nano33BLE Mouse");
 
 // Analog Joystick wrapper, used to simulate a mouse.
 AnalogJoystick gJoystick(A7, A6, 2);
 static const float kJoystickSensibility = 0.125f;
 
+// Low priority thread writing the joystick calibration to the flash, which
+// takes a while, off the BLE events thread running loop().
+static const int kStorageStackSize = 4096;
+static const int kStorageQueueSize = 4 * EVENTS_EVENT_SIZE;
+MBED_ALIGN(8) static unsigned char sStorageStack[kStorageStackSize];
+static unsigned char sStorageQueueBuffer[kStorageQueueSize];
+events::EventQueue gStorageQueue(kStorageQueueSize, sStorageQueueBuffer);
+rtos::Thread gStorageThread(osPriorityLow, kStorageStackSize, sStorageStack, "storage");
+
 // Builtin LED animation delays when disconnect. 
 static const int kLedBeaconDelayMilliseconds = 1250;
 static const int kLedErrorDelayMilliseconds = kLedBeaconDelayMilliseconds / 10;
@@ -36,6 +47,7 @@ void setup()
   // General setup.
   pinMode(LED_BUILTIN, OUTPUT);
   gJoystick.initialize();
+  gStorageThread.start(mbed::callback(&gStorageQueue, &events::EventQueue::dispatch_forever));
 
   // Initialize both BLE and the HID.
   bleMouse.initialize();
@@ -51,6 +63,13 @@ void loop()
   if (bleMouse.connected() == false) {
     animateLED(LED_BUILTIN, (bleMouse.has_error()) ? kLedErrorDelayMilliseconds 
                                                    : kLedBeaconDelayMilliseconds);
+
+    // Store the joystick calibration refined while connected, if it moved.
+    AnalogJoystick::calibration_record_t record;
+    if (gJoystick.calibrationToSave(&record)
+     && !gStorageQueue.call([record]() { gJoystick.saveCalibration(record); })) {
+      gJoystick.cancelCalibrationSave();
+    }
     return;
   }
 
@@ -81,9 +100,9 @@ void loop()
   }
 #endif
 
-  // Update the HID report.
+  // Update the HID report, at the speed set by the host.
   auto *mouse = bleMouse.hid();
-  mouse->motion(fx, fy);
+  mouse->motion(mouse->speed() * fx, mouse->speed() * fy);
   mouse->button(buttons);
   mouse->SendReport();
 }
@@ -0,0 +1,103 @@
+///
+///   ble_raw_stream.ino
+///
+///   created: 2026-10
+///
+///  Stream blobs of data through a vendor-defined HID channel, and echo back
+///  messages sent by the host.
+///  Use extras/raw_throughput.py on the host to measure the throughput.
+///
+
+#include "Nano33BleHID.h"
+#include "signal_utils.h"
+
+/* -------------------------------------------------------------------------- */
+
+Nano33BleRaw bleRaw("nano33BLE Raw");
+
+// Size of the streamed blob.
+static const int kBlobSize = 240;
+
+// Blob being streamed, filled with a rolling pattern the host can check.
+static uint8_t sBlob[kBlobSize];
+static uint8_t sBlobCounter = 0;
+
+// Last message received from the host, echoed back before the next blob.
+static uint8_t sReceived[HIDRawService::kMaxMessageSize];
+static size_t sReceivedSize = 0;
+
+// Copy of the message being echoed, as sent buffers must stay untouched.
+static uint8_t sEcho[HIDRawService::kMaxMessageSize];
+
+// Builtin LED animation delays when disconnect.
+static const int kLedBeaconDelayMilliseconds = 1250;
+static const int kLedErrorDelayMilliseconds = kLedBeaconDelayMilliseconds / 10;
+
+// Builtin LED intensity when connected.
+static const int kLedConnectedIntensity = 30;
+
+/* -------------------------------------------------------------------------- */
+
+void onHostMessage(const uint8_t *data, size_t size)
+{
+  memcpy(sReceived, data, size);
+  sReceivedSize = size;
+}
+
+void setup()
+{
+  // General setup.
+  pinMode(LED_BUILTIN, OUTPUT);
+
+  // Initialize both BLE and the HID.
+  bleRaw.initialize();
+
+  // Launch the event queue that will manage both BLE events and the loop.
+  // After this call the main thread will be halted.
+  MbedBleHID_RunEventThread();
+}
+
+void loop()
+{
+  // When disconnected, we animate the builtin LED to indicate the device state.
+  if (bleRaw.connected() == false) {
+    animateLED(LED_BUILTIN, (bleRaw.has_error()) ? kLedErrorDelayMilliseconds
+                                                 : kLedBeaconDelayMilliseconds);
+    return;
+  }
+
+  // When connected, we slightly dim the builtin LED.
+  analogWrite(LED_BUILTIN, kLedConnectedIntensity);
+
+  // Retrieve the HIDService to update.
+  auto *raw = bleRaw.hid();
+
+  // Listen to the host messages (the service exists once connected).
+  static bool sListening = false;
+  if (!sListening) {
+    raw->onReceive(onHostMessage);
+    sListening = true;
+  }
+
+  // The service sends the pending chunks by itself as the stack frees buffers.
+  if (raw->busy()) {
+    return;
+  }
+
+  // Echo the last host message first.
+  if (sReceivedSize > 0) {
+    memcpy(sEcho, sReceived, sReceivedSize);
+    raw->send(sEcho, sReceivedSize);
+    sReceivedSize = 0;
+    return;
+  }
+
+  // Stream a new blob.
+  for (int i = 0; i < kBlobSize; ++i) {
+    sBlob[i] = sBlobCounter + i;
+  }
+  ++sBlobCounter;
+  raw->send(sBlob, kBlobSize);
+}
+
+/* -------------------------------------------------------------------------- */
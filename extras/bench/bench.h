@@ -0,0 +1,92 @@
+#ifndef BENCH_H_
+#define BENCH_H_
+
+/* -------------------------------------------------------------------------- */
+//
+// Minimal micro-benchmark harness, shared by the host runner (extras/host,
+// `make bench`) and the on-target sketch (extras/bench/bench.ino).
+//
+// Time is measured in nanoseconds on the host, and in CPU cycles with the DWT
+// cycle counter on Cortex-M targets.
+//
+/* -------------------------------------------------------------------------- */
+
+#include <cstdint>
+#include <cfloat>
+
+#if defined(__arm__)
+#include <mbed.h>
+#else
+#include <chrono>
+#endif
+
+namespace bench {
+
+#if defined(__arm__)
+
+static constexpr const char* kUnit = "cycles";
+
+/* Start the DWT cycle counter, to call once before measuring. */
+inline void Initialize() {
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL  |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+inline uint32_t Now() {
+  return DWT->CYCCNT;
+}
+
+#else
+
+static constexpr const char* kUnit = "ns";
+
+inline void Initialize() {}
+
+inline uint64_t Now() {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+#endif
+
+/* Keep @p value alive, so the computation producing it is not optimized out. */
+template<typename T>
+inline void DoNotOptimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * Return the time per call of fn(i), for i in [0, iterations), as the best of
+ * @p repetitions runs : the minimum is the least disturbed by interrupts and
+ * by the host scheduler.
+ *
+ * The time of an empty loop is subtracted, so trivial functions may read 0.
+ */
+template<typename Fn>
+float Measure(Fn fn, uint32_t iterations, int repetitions = 5)
+{
+  float best     = FLT_MAX;
+  float overhead = FLT_MAX;
+  for (int r = 0; r < repetitions; ++r) {
+    auto t0 = Now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+      DoNotOptimize(i);
+    }
+    auto t1 = Now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+      fn(i);
+    }
+    auto t2 = Now();
+    overhead = (t1 - t0 < overhead) ? t1 - t0 : overhead;
+    best     = (t2 - t1 < best) ? t2 - t1 : best;
+  }
+  best -= (overhead < best) ? overhead : best;
+  return best / iterations;
+}
+
+} // namespace bench
+
+/* -------------------------------------------------------------------------- */
+
+#endif // BENCH_H_
@@ -0,0 +1,41 @@
+/* -------------------------------------------------------------------------- */
+//
+// On-target run of the micro-benchmarks, printing the cycles per call on the
+// serial port.
+//
+// Copy examples/ble_mouse/AnalogJoystick.h next to this sketch to include the
+// joystick filter.
+//
+/* -------------------------------------------------------------------------- */
+
+#include "bench_cases.h"
+
+namespace {
+
+const uint32_t kIterations = 10000;
+
+} // namespace
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial);
+
+  BLE &ble = BLE::Instance();
+  static HIDKeyboardService keyboard(ble);
+  static HIDMouseService mouse(ble);
+
+  bench::Initialize();
+  bench::RunBenchmarks(keyboard, mouse, kIterations, [](const char *name, float time) {
+    Serial.print(name);
+    Serial.print(",");
+    Serial.println(time);
+  });
+  Serial.print("(");
+  Serial.print(bench::kUnit);
+  Serial.println(" per call)");
+}
+
+void loop()
+{
+}
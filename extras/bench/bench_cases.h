@@ -0,0 +1,118 @@
+#ifndef BENCH_CASES_H_
+#define BENCH_CASES_H_
+
+/* -------------------------------------------------------------------------- */
+//
+// Benchmarks of the per-report hot paths : keyboard key lookup, mouse motion
+// conversion and the signal processing of the examples.
+//
+// The joystick case needs examples/ble_mouse/AnalogJoystick.h on the include
+// path (the host runner adds it, copy it next to the sketch on target).
+//
+/* -------------------------------------------------------------------------- */
+
+#include "bench.h"
+#include "signal_utils.h"
+#include "services/HIDKeyboardService.h"
+#include "services/HIDMouseService.h"
+
+#if __has_include("AnalogJoystick.h")
+#include "AnalogJoystick.h"
+#define BENCH_ANALOG_JOYSTICK 1
+#endif
+
+namespace bench {
+
+/* Inputs cycled through by the float cases, in [-1, 1]. */
+static constexpr int kNumInputs = 64;
+
+inline float Input(uint32_t i) {
+  return static_cast<float>(static_cast<int>(i % kNumInputs) - kNumInputs / 2) / (kNumInputs / 2);
+}
+
+/**
+ * Run every benchmark with @p iterations calls, passing their name and time
+ * per call to report(const char *name, float time).
+ */
+template<typename Report>
+void RunBenchmarks(HIDKeyboardService &keyboard, HIDMouseService &mouse, uint32_t iterations, Report report)
+{
+  report("KeySym_t(KeyCode_t)", Measure([](uint32_t i) {
+    KeySym_t keysym(static_cast<KeyCode_t>(i & 0xff));
+    DoNotOptimize(keysym);
+  }, iterations));
+
+  report("charToKeySym", Measure([&keyboard](uint32_t i) {
+    KeySym_t keysym = keyboard.charToKeySym(static_cast<unsigned char>(i & 0x7f));
+    DoNotOptimize(keysym);
+  }, iterations));
+
+  report("HIDMouseService::motion", Measure([&mouse](uint32_t i) {
+    mouse.motion(Input(i), Input(i + 1));
+  }, iterations));
+
+#if BENCH_ANALOG_JOYSTICK
+  // (the filter only, without starting the acquisition)
+  AnalogJoystick joystick(A0, A1, 2);
+  report("AnalogJoystick::filter", Measure([&joystick](uint32_t i) {
+    joystick.filter(0.0075f);
+    DoNotOptimize(joystick.x());
+  }, iterations));
+#endif
+
+  report("clamp", Measure([](uint32_t i) {
+    DoNotOptimize(clamp(2.0f * Input(i), -1.0f, 1.0f));
+  }, iterations));
+
+  report("smoothstep", Measure([](uint32_t i) {
+    DoNotOptimize(smoothstep(0.1f, 0.9f, Input(i)));
+  }, iterations));
+
+  report("smoothcurve", Measure([](uint32_t i) {
+    DoNotOptimize(smoothcurve(0.5f + 0.5f * Input(i)));
+  }, iterations));
+
+  report("lerp", Measure([](uint32_t i) {
+    DoNotOptimize(lerp(-1.0f, 1.0f, Input(i)));
+  }, iterations));
+
+  report("mmap", Measure([](uint32_t i) {
+    DoNotOptimize(mmap(Input(i), -1.0f, 1.0f, 0.0f, 1023.0f));
+  }, iterations));
+
+  // Fixed-point variants.
+  report("smoothstep<Q15>", Measure([](uint32_t i) {
+    DoNotOptimize(smoothstep(Q15(0.1f), Q15(0.9f), Q15::FromRaw(static_cast<int16_t>(i << 5))));
+  }, iterations));
+
+  report("lerp<Q15>", Measure([](uint32_t i) {
+    DoNotOptimize(lerp(Q15(-1.0f), Q15(0.99f), Q15::FromRaw(static_cast<int16_t>(i << 5))));
+  }, iterations));
+
+  report("mmap<Q16>", Measure([](uint32_t i) {
+    DoNotOptimize(mmap(Q16::FromRaw(static_cast<int32_t>(i << 8)), Q16(-1.0f), Q16(1.0f), Q16(0.0f), Q16(1023.0f)));
+  }, iterations));
+
+  // Batches of samples, timed per sample.
+  static constexpr int kBatchSize = 64;
+  static Q15 from[kBatchSize], to[kBatchSize], out[kBatchSize];
+  for (int i = 0; i < kBatchSize; ++i) {
+    from[i] = Q15(Input(i));
+    to[i]   = Q15(Input(i + 17));
+  }
+  report("batch::Lerp (per sample)", Measure([](uint32_t i) {
+    batch::Lerp(from, to, Q15::FromRaw(static_cast<int16_t>(i & 0x7fff)), out, kBatchSize);
+    DoNotOptimize(out[0]);
+  }, iterations / kBatchSize + 1) / kBatchSize);
+
+  report("batch::Add (per sample)", Measure([](uint32_t i) {
+    batch::Add(from, to, out, kBatchSize);
+    DoNotOptimize(out[i % kBatchSize]);
+  }, iterations / kBatchSize + 1) / kBatchSize);
+}
+
+} // namespace bench
+
+/* -------------------------------------------------------------------------- */
+
+#endif // BENCH_CASES_H_
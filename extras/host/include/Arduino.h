@@ -0,0 +1,90 @@
+#ifndef HOST_ARDUINO_H_
+#define HOST_ARDUINO_H_
+
+/* -------------------------------------------------------------------------- */
+//
+// Linux stand-in for the subset of the Arduino API used by the examples.
+// Inputs are idle (analog pins at mid-range unless set with
+// sim::SetAnalogInput, digital pins high) and time is the simulated one.
+//
+/* -------------------------------------------------------------------------- */
+
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <string>
+
+#include "mbed.h"
+
+using std::min;
+using std::max;
+
+#define PI            3.14159265358979f
+#define HIGH          1
+#define LOW           0
+
+#define LED_BUILTIN   13
+#define A0            0
+#define A1            1
+#define A2            2
+#define A3            3
+#define A4            4
+#define A5            5
+#define A6            6
+#define A7            7
+
+/* (an enum, as OUTPUT is also a HID report descriptor item) */
+enum PinMode {
+  INPUT         = 0,
+  OUTPUT        = 1,
+  INPUT_PULLUP  = 2,
+};
+
+enum PinStatus {
+  CHANGE        = 2,
+  FALLING       = 3,
+  RISING        = 4,
+};
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(int pin, int mode);
+int digitalRead(int pin);
+void digitalWrite(int pin, int value);
+int analogRead(int pin);
+void analogWrite(int pin, int value);
+
+/* Pins of the Nano 33 BLE analog inputs, NC for the others. */
+PinName digitalPinToPinName(int pin);
+
+inline int digitalPinToInterrupt(int pin) { return pin; }
+void attachInterrupt(int interrupt, void (*isr)(), int mode);
+
+long random(long max);
+long random(long min, long max);
+
+/* Serial output, written to stderr. */
+class HostSerial {
+ public:
+  void begin(unsigned long) {}
+  explicit operator bool() const { return true; }
+  size_t print(const char *s);
+  size_t print(long v);
+  size_t print(double v);
+  size_t println(const char *s = "");
+  size_t println(long v);
+  size_t println(double v);
+  size_t printf(const char *format, ...);
+  size_t write(const uint8_t *data, size_t size);
+};
+extern HostSerial Serial;
+
+/* Sketch entry points. */
+void setup();
+void loop();
+
+#endif // HOST_ARDUINO_H_
@@ -0,0 +1,17 @@
+#ifndef HOST_BATTERY_SERVICE_H_
+#define HOST_BATTERY_SERVICE_H_
+
+#include "ble/BLE.h"
+
+/* Stand-in for the Mbed Battery service, which adds no attribute. */
+class BatteryService {
+ public:
+  BatteryService(BLE &_ble, uint8_t level = 100) : batteryLevel(level) {}
+
+  void updateBatteryLevel(uint8_t newLevel) { batteryLevel = newLevel; }
+
+ private:
+  uint8_t batteryLevel;
+};
+
+#endif // HOST_BATTERY_SERVICE_H_
@@ -0,0 +1,19 @@
+#ifndef HOST_DEVICE_INFORMATION_SERVICE_H_
+#define HOST_DEVICE_INFORMATION_SERVICE_H_
+
+#include "ble/BLE.h"
+
+/* Stand-in for the Mbed Device Information service, which adds no attribute. */
+class DeviceInformationService {
+ public:
+  DeviceInformationService(BLE &_ble,
+                           const char *manufacturersName = nullptr,
+                           const char *modelNumber = nullptr,
+                           const char *serialNumber = nullptr,
+                           const char *hardwareRevision = nullptr,
+                           const char *firmwareRevision = nullptr,
+                           const char *softwareRevision = nullptr)
+  {}
+};
+
+#endif // HOST_DEVICE_INFORMATION_SERVICE_H_
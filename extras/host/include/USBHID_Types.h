@@ -0,0 +1,49 @@
+#ifndef HOST_USBHID_TYPES_H_
+#define HOST_USBHID_TYPES_H_
+
+/* HID report descriptor items, as defined by the Mbed USB HID types. */
+
+#define HID_VERSION_1_11        (0x0111)
+
+#define _SIZE_MASK              (0x03)
+#define _SIZE_0                 (0x00)
+#define _SIZE_1                 (0x01)
+#define _SIZE_2                 (0x02)
+#define _SIZE_4                 (0x03)
+
+#define HID_SIZE(size)          ((size == 0) ? _SIZE_0 : ((size == 1) ? _SIZE_1 : ((size == 2) ? _SIZE_2 : _SIZE_4)))
+
+/* Main items */
+#define INPUT(size)             (0x80 | HID_SIZE(size))
+#define OUTPUT(size)            (0x90 | HID_SIZE(size))
+#define FEATURE(size)           (0xb0 | HID_SIZE(size))
+#define COLLECTION(size)        (0xa0 | HID_SIZE(size))
+#define END_COLLECTION(size)    (0xc0 | HID_SIZE(size))
+
+/* Global items */
+#define USAGE_PAGE(size)        (0x04 | HID_SIZE(size))
+#define LOGICAL_MINIMUM(size)   (0x14 | HID_SIZE(size))
+#define LOGICAL_MAXIMUM(size)   (0x24 | HID_SIZE(size))
+#define PHYSICAL_MINIMUM(size)  (0x34 | HID_SIZE(size))
+#define PHYSICAL_MAXIMUM(size)  (0x44 | HID_SIZE(size))
+#define UNIT_EXPONENT(size)     (0x54 | HID_SIZE(size))
+#define UNIT(size)              (0x64 | HID_SIZE(size))
+#define REPORT_SIZE(size)       (0x74 | HID_SIZE(size))
+#define REPORT_ID(size)         (0x84 | HID_SIZE(size))
+#define REPORT_COUNT(size)      (0x94 | HID_SIZE(size))
+#define PUSH(size)              (0xa4 | HID_SIZE(size))
+#define POP(size)               (0xb4 | HID_SIZE(size))
+
+/* Local items */
+#define USAGE(size)             (0x08 | HID_SIZE(size))
+#define USAGE_MINIMUM(size)     (0x18 | HID_SIZE(size))
+#define USAGE_MAXIMUM(size)     (0x28 | HID_SIZE(size))
+#define DESIGNATOR_INDEX(size)  (0x38 | HID_SIZE(size))
+#define DESIGNATOR_MINIMUM(size) (0x48 | HID_SIZE(size))
+#define DESIGNATOR_MAXIMUM(size) (0x58 | HID_SIZE(size))
+#define STRING_INDEX(size)      (0x78 | HID_SIZE(size))
+#define STRING_MINIMUM(size)    (0x88 | HID_SIZE(size))
+#define STRING_MAXIMUM(size)    (0x98 | HID_SIZE(size))
+#define DELIMITER(size)         (0xa8 | HID_SIZE(size))
+
+#endif // HOST_USBHID_TYPES_H_
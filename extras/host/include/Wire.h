@@ -0,0 +1,50 @@
+#ifndef HOST_WIRE_H_
+#define HOST_WIRE_H_
+
+/* -------------------------------------------------------------------------- */
+//
+// Linux stand-in for the Arduino I2C API.
+//
+// The internal bus (Wire1) holds a simulated LSM9DS1 accelerometer and
+// gyroscope at 0x6B, whose motion is set with sim::SetImuMotion : its
+// samples are produced at the configured output rate on the simulation
+// timeline, into the FIFO when enabled. Other devices do not answer.
+//
+/* -------------------------------------------------------------------------- */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class TwoWire {
+ public:
+  explicit TwoWire(int bus) : bus_(bus) {}
+
+  void begin() {}
+  void end() {}
+  void setClock(uint32_t frequency) {}
+
+  void beginTransmission(uint8_t address);
+  size_t write(uint8_t data);
+
+  /* Return 0 on success, 2 when the address is not acknowledged. */
+  uint8_t endTransmission(bool stopBit = true);
+
+  /* Read @p quantity bytes from the current register, return the number read. */
+  uint8_t requestFrom(uint8_t address, size_t quantity, bool stopBit = true);
+
+  int available() const;
+  int read();
+
+ private:
+  int bus_;
+  uint8_t address_ = 0;
+  std::vector<uint8_t> tx_;
+  std::vector<uint8_t> rx_;
+  size_t rxIndex_ = 0;
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
+
+#endif // HOST_WIRE_H_
@@ -0,0 +1,584 @@
+#ifndef HOST_BLE_BLE_H_
+#define HOST_BLE_BLE_H_
+
+/* -------------------------------------------------------------------------- */
+//
+// Linux stand-in for the subset of the Mbed BLE API used by the library,
+// backed by the simulated stack of extras/host/src/ble_sim.cpp.
+//
+/* -------------------------------------------------------------------------- */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "mbed.h"
+
+enum ble_error_t {
+  BLE_ERROR_NONE = 0,
+  BLE_ERROR_BUFFER_OVERFLOW,
+  BLE_ERROR_NOT_IMPLEMENTED,
+  BLE_ERROR_PARAM_OUT_OF_RANGE,
+  BLE_ERROR_INVALID_PARAM,
+  BLE_STACK_BUSY,
+  BLE_ERROR_INVALID_STATE,
+  BLE_ERROR_NO_MEM,
+  BLE_ERROR_OPERATION_NOT_PERMITTED,
+  BLE_ERROR_INITIALIZATION_INCOMPLETE,
+  BLE_ERROR_ALREADY_INITIALIZED,
+  BLE_ERROR_UNSPECIFIED,
+  BLE_ERROR_INTERNAL_STACK_FAILURE,
+  BLE_ERROR_NOT_FOUND,
+};
+
+class BLE;
+
+namespace sim { struct Stack; }
+
+/* -------------------------------------------------------------------------- */
+
+namespace ble {
+
+typedef uintptr_t connection_handle_t;
+typedef uint16_t  attribute_handle_t;
+typedef uint8_t   advertising_handle_t;
+typedef uint16_t  slave_latency_t;
+
+static const advertising_handle_t LEGACY_ADVERTISING_HANDLE = 0;
+static const uint8_t LEGACY_ADVERTISING_MAX_SIZE = 31;
+
+/* Duration in units of TB microseconds. */
+template<typename Rep, uint32_t TB>
+struct Duration {
+  Duration() : v(0) {}
+  explicit Duration(Rep r) : v(r) {}
+
+  template<typename R2, uint32_t TB2>
+  Duration(Duration<R2, TB2> other)
+    : v(static_cast<Rep>((static_cast<uint64_t>(other.value()) * TB2) / TB))
+  {}
+
+  Rep value() const { return v; }
+  uint64_t valueInUs() const { return static_cast<uint64_t>(v) * TB; }
+  static Duration forever() { return Duration(static_cast<Rep>(0)); }
+
+  Rep v;
+};
+
+typedef Duration<uint32_t, 1000>  millisecond_t;
+typedef Duration<uint16_t, 1250>  conn_interval_t;
+typedef Duration<uint32_t, 625>   adv_interval_t;
+typedef Duration<uint16_t, 10000> adv_duration_t;
+typedef Duration<uint16_t, 10000> supervision_timeout_t;
+
+/* Safe enums, converting to their underlying type. */
+#define HOST_BLE_SAFE_ENUM(Name, Default, ...)                              \
+  struct Name {                                                             \
+    enum type { __VA_ARGS__ };                                              \
+    Name(type t = Default) : v(t) {}                                        \
+    operator type() const { return v; }                                     \
+    type value() const { return v; }                                        \
+    type v;                                                                 \
+  }
+
+HOST_BLE_SAFE_ENUM(phy_t, NONE, NONE = 0, LE_1M = 1, LE_2M = 2, LE_CODED = 3);
+HOST_BLE_SAFE_ENUM(coded_symbol_per_bit_t, UNDEFINED, UNDEFINED, S2, S8);
+HOST_BLE_SAFE_ENUM(controller_supported_features_t, LE_ENCRYPTION,
+  LE_ENCRYPTION, LE_2M_PHY, LE_CODED_PHY, LE_DATA_PACKET_LENGTH_EXTENSION, LE_EXTENDED_ADVERTISING);
+HOST_BLE_SAFE_ENUM(advertising_type_t, CONNECTABLE_UNDIRECTED,
+  CONNECTABLE_UNDIRECTED, CONNECTABLE_DIRECTED, SCANNABLE_UNDIRECTED, NON_CONNECTABLE_UNDIRECTED, CONNECTABLE_DIRECTED_LOW_DUTY);
+HOST_BLE_SAFE_ENUM(own_address_type_t, PUBLIC,
+  PUBLIC, RANDOM, RESOLVABLE_PRIVATE_ADDRESS_PUBLIC_FALLBACK, RESOLVABLE_PRIVATE_ADDRESS_RANDOM_FALLBACK);
+HOST_BLE_SAFE_ENUM(peer_address_type_t, PUBLIC,
+  PUBLIC, RANDOM, PUBLIC_IDENTITY, RANDOM_STATIC_IDENTITY, ANONYMOUS);
+HOST_BLE_SAFE_ENUM(target_peer_address_type_t, PUBLIC, PUBLIC, RANDOM);
+HOST_BLE_SAFE_ENUM(advertising_filter_policy_t, NO_FILTER,
+  NO_FILTER, FILTER_SCAN_REQUESTS, FILTER_CONNECTION_REQUEST, FILTER_SCAN_AND_CONNECTION_REQUESTS);
+HOST_BLE_SAFE_ENUM(disconnection_reason_t, REMOTE_USER_TERMINATED_CONNECTION,
+  AUTHENTICATION_FAILURE = 0x05, CONNECTION_TIMEOUT = 0x08,
+  REMOTE_USER_TERMINATED_CONNECTION = 0x13, LOCAL_HOST_TERMINATED_CONNECTION = 0x16);
+HOST_BLE_SAFE_ENUM(local_disconnection_reason_t, USER_TERMINATION,
+  AUTHENTICATION_FAILURE = 0x05, USER_TERMINATION = 0x13, LOW_RESOURCES = 0x14, POWER_OFF = 0x15);
+HOST_BLE_SAFE_ENUM(link_encryption_t, NOT_ENCRYPTED,
+  NOT_ENCRYPTED, ENCRYPTION_IN_PROGRESS, ENCRYPTED, ENCRYPTED_WITH_MITM, ENCRYPTED_WITH_SC_AND_MITM);
+HOST_BLE_SAFE_ENUM(connection_role_t, PERIPHERAL, CENTRAL, PERIPHERAL);
+HOST_BLE_SAFE_ENUM(adv_data_appearance_t, UNKNOWN,
+  UNKNOWN = 0, GENERIC_HID = 960, KEYBOARD = 961, MOUSE = 962, JOYSTICK = 963, GAMEPAD = 964);
+
+#undef HOST_BLE_SAFE_ENUM
+
+struct adv_data_flags_t {
+  enum type {
+    LE_LIMITED_DISCOVERABLE = 1 << 0,
+    LE_GENERAL_DISCOVERABLE = 1 << 1,
+    BREDR_NOT_SUPPORTED     = 1 << 2,
+  };
+};
+
+struct phy_set_t {
+  phy_set_t(uint8_t value = 0) : value_(value) {}
+  phy_set_t(bool phy1M, bool phy2M, bool phyCoded)
+    : value_((phy1M ? 1 : 0) | (phy2M ? 2 : 0) | (phyCoded ? 4 : 0))
+  {}
+  bool get_2m() const { return value_ & 2; }
+  bool get_coded() const { return value_ & 4; }
+  uint8_t value() const { return value_; }
+  uint8_t value_;
+};
+
+struct address_t {
+  address_t() { memset(data, 0, sizeof(data)); }
+  uint8_t& operator[](size_t i) { return data[i]; }
+  const uint8_t& operator[](size_t i) const { return data[i]; }
+  bool operator==(const address_t &other) const { return !memcmp(data, other.data, sizeof(data)); }
+  bool operator!=(const address_t &other) const { return !(*this == other); }
+  static size_t size() { return 6; }
+  uint8_t data[6];
+};
+
+struct whitelist_t {
+  struct entry_t {
+    peer_address_type_t type;
+    address_t address;
+  };
+  entry_t *addresses;
+  uint8_t size;
+  uint8_t capacity;
+};
+
+/* -------------------------------------------------------------------------- */
+
+struct AdvertisingParameters {
+  AdvertisingParameters &setType(advertising_type_t type) { this->type = type; return *this; }
+  AdvertisingParameters &setPrimaryInterval(adv_interval_t min, adv_interval_t max) {
+    minInterval = min;
+    maxInterval = max;
+    return *this;
+  }
+  AdvertisingParameters &setUseLegacyPDU(bool) { return *this; }
+  AdvertisingParameters &setOwnAddressType(own_address_type_t) { return *this; }
+  AdvertisingParameters &setPhy(phy_t, phy_t) { return *this; }
+  AdvertisingParameters &setPeer(const address_t &address, target_peer_address_type_t) {
+    peer = address;
+    return *this;
+  }
+  AdvertisingParameters &setFilter(advertising_filter_policy_t policy) { filter = policy; return *this; }
+
+  advertising_type_t type;
+  adv_interval_t minInterval;
+  adv_interval_t maxInterval;
+  address_t peer;
+  advertising_filter_policy_t filter;
+};
+
+struct AdvertisingDataSpan {
+  const uint8_t *data;
+  size_t size;
+};
+
+template<size_t N>
+class AdvertisingDataSimpleBuilder {
+ public:
+  AdvertisingDataSimpleBuilder &setFlags(int) { return *this; }
+  AdvertisingDataSimpleBuilder &setName(const char*, bool) { return *this; }
+  AdvertisingDataSimpleBuilder &setAppearance(adv_data_appearance_t) { return *this; }
+  AdvertisingDataSimpleBuilder &setLocalService(uint16_t) { return *this; }
+  AdvertisingDataSpan getAdvertisingData() { return { buffer_, 0 }; }
+
+ private:
+  uint8_t buffer_[N];
+};
+
+/* -------------------------------------------------------------------------- */
+
+struct ConnectionCompleteEvent {
+  ConnectionCompleteEvent(ble_error_t status, connection_handle_t handle,
+                          peer_address_type_t peerAddressType, const address_t &peerAddress,
+                          conn_interval_t interval)
+    : status(status), handle(handle), peerAddressType(peerAddressType)
+    , peerAddress(peerAddress), interval(interval)
+  {}
+  ble_error_t getStatus() const { return status; }
+  connection_handle_t getConnectionHandle() const { return handle; }
+  connection_role_t getOwnRole() const { return connection_role_t::PERIPHERAL; }
+  peer_address_type_t getPeerAddressType() const { return peerAddressType; }
+  const address_t &getPeerAddress() const { return peerAddress; }
+  const address_t &getPeerResolvablePrivateAddress() const { return peerAddress; }
+  conn_interval_t getConnectionInterval() const { return interval; }
+  slave_latency_t getConnectionLatency() const { return 0; }
+  supervision_timeout_t getSupervisionTimeout() const { return supervision_timeout_t(400); }
+
+  ble_error_t status;
+  connection_handle_t handle;
+  peer_address_type_t peerAddressType;
+  address_t peerAddress;
+  conn_interval_t interval;
+};
+
+struct DisconnectionCompleteEvent {
+  DisconnectionCompleteEvent(connection_handle_t handle, disconnection_reason_t reason)
+    : handle(handle), reason(reason)
+  {}
+  connection_handle_t getConnectionHandle() const { return handle; }
+  const disconnection_reason_t &getReason() const { return reason; }
+
+  connection_handle_t handle;
+  disconnection_reason_t reason;
+};
+
+struct UpdateConnectionParametersRequestEvent {
+  connection_handle_t getConnectionHandle() const { return handle; }
+  conn_interval_t getMinConnectionInterval() const { return minInterval; }
+  conn_interval_t getMaxConnectionInterval() const { return maxInterval; }
+  slave_latency_t getSlaveLatency() const { return 0; }
+  supervision_timeout_t getSupervisionTimeout() const { return supervision_timeout_t(400); }
+
+  connection_handle_t handle;
+  conn_interval_t minInterval;
+  conn_interval_t maxInterval;
+};
+
+struct ConnectionParametersUpdateCompleteEvent {
+  ble_error_t getStatus() const { return BLE_ERROR_NONE; }
+  connection_handle_t getConnectionHandle() const { return handle; }
+  conn_interval_t getConnectionInterval() const { return interval; }
+  slave_latency_t getSlaveLatency() const { return 0; }
+  supervision_timeout_t getSupervisionTimeout() const { return supervision_timeout_t(400); }
+
+  connection_handle_t handle;
+  conn_interval_t interval;
+};
+
+struct AdvertisingEndEvent {
+  AdvertisingEndEvent(advertising_handle_t handle, bool connected)
+    : handle(handle), connected(connected)
+  {}
+  advertising_handle_t getAdvHandle() const { return handle; }
+  uint8_t getCompleted_events() const { return 0; }
+  bool isConnected() const { return connected; }
+
+  advertising_handle_t handle;
+  bool connected;
+};
+
+/* -------------------------------------------------------------------------- */
+
+class Gap {
+ public:
+  struct EventHandler {
+    virtual void onAdvertisingEnd(const AdvertisingEndEvent &) {}
+    virtual void onConnectionComplete(const ConnectionCompleteEvent &) {}
+    virtual void onUpdateConnectionParametersRequest(const UpdateConnectionParametersRequestEvent &) {}
+    virtual void onConnectionParametersUpdateComplete(const ConnectionParametersUpdateCompleteEvent &) {}
+    virtual void onReadPhy(ble_error_t, connection_handle_t, phy_t, phy_t) {}
+    virtual void onPhyUpdateComplete(ble_error_t, connection_handle_t, phy_t, phy_t) {}
+    virtual void onDataLengthChange(connection_handle_t, uint16_t, uint16_t) {}
+    virtual void onDisconnectionComplete(const DisconnectionCompleteEvent &) {}
+   protected:
+    ~EventHandler() {}
+  };
+
+  void setEventHandler(EventHandler *handler) { handler_ = handler; }
+  ble_error_t manageConnectionParametersUpdateRequest(bool) { return BLE_ERROR_NONE; }
+
+  ble_error_t setAdvertisingPayload(advertising_handle_t, AdvertisingDataSpan) { return BLE_ERROR_NONE; }
+  ble_error_t setAdvertisingParameters(advertising_handle_t, const AdvertisingParameters &params);
+  ble_error_t startAdvertising(advertising_handle_t handle,
+                               adv_duration_t maxDuration = adv_duration_t::forever(),
+                               uint8_t maxEvents = 0);
+  ble_error_t stopAdvertising(advertising_handle_t handle);
+  bool isAdvertisingActive(advertising_handle_t handle) { return advertising_; }
+
+  ble_error_t acceptConnectionParametersUpdate(connection_handle_t, conn_interval_t, conn_interval_t,
+                                               slave_latency_t, supervision_timeout_t) { return BLE_ERROR_NONE; }
+  ble_error_t rejectConnectionParametersUpdate(connection_handle_t) { return BLE_ERROR_NONE; }
+
+  bool isFeatureSupported(controller_supported_features_t) { return true; }
+  ble_error_t setPhy(connection_handle_t handle, const phy_set_t *txPhys, const phy_set_t *rxPhys,
+                     coded_symbol_per_bit_t codedSymbol);
+  ble_error_t disconnect(connection_handle_t handle, local_disconnection_reason_t reason);
+
+  ble_error_t setWhitelist(const whitelist_t &) { return BLE_ERROR_NONE; }
+  uint8_t getMaxWhitelistSize() const { return 8; }
+
+ private:
+  friend class ::BLE;
+  friend struct sim::Stack;
+  EventHandler *handler_ = nullptr;
+  AdvertisingParameters params_;
+  bool advertising_ = false;
+  int advertisingEndId_ = 0;
+};
+
+/* -------------------------------------------------------------------------- */
+
+class SecurityManager {
+ public:
+  enum SecurityIOCapabilities_t {
+    IO_CAPS_DISPLAY_ONLY,
+    IO_CAPS_DISPLAY_YESNO,
+    IO_CAPS_KEYBOARD_ONLY,
+    IO_CAPS_NONE,
+    IO_CAPS_KEYBOARD_DISPLAY,
+  };
+  enum SecurityCompletionStatus_t {
+    SEC_STATUS_SUCCESS = 0x00,
+    SEC_STATUS_UNSPECIFIED = 0x08,
+  };
+  enum SecurityMode_t {
+    SECURITY_MODE_NO_ACCESS,
+    SECURITY_MODE_ENCRYPTION_OPEN_LINK,
+    SECURITY_MODE_ENCRYPTION_NO_MITM,
+    SECURITY_MODE_ENCRYPTION_WITH_MITM,
+  };
+  typedef uint8_t Passkey_t[6];
+
+  struct EventHandler {
+    virtual void pairingRequest(connection_handle_t) {}
+    virtual void pairingResult(connection_handle_t, SecurityCompletionStatus_t) {}
+    virtual void linkEncryptionResult(connection_handle_t, link_encryption_t) {}
+    virtual void whitelistFromBondTable(whitelist_t *) {}
+   protected:
+    ~EventHandler() {}
+  };
+
+  ble_error_t init(bool enableBonding = true, bool requireMITM = true,
+                   SecurityIOCapabilities_t iocaps = IO_CAPS_NONE, const Passkey_t passkey = nullptr,
+                   bool signing = true, const char *dbFilepath = nullptr) {
+    bonding_ = enableBonding;
+    return BLE_ERROR_NONE;
+  }
+  ble_error_t preserveBondingStateOnReset(bool) { return BLE_ERROR_NONE; }
+  ble_error_t allowLegacyPairing(bool = true) { return BLE_ERROR_NONE; }
+  void setSecurityManagerEventHandler(EventHandler *handler) { handler_ = handler; }
+  ble_error_t setPairingRequestAuthorisation(bool required) { authorisation_ = required; return BLE_ERROR_NONE; }
+  ble_error_t acceptPairingRequest(connection_handle_t handle);
+  ble_error_t cancelPairingRequest(connection_handle_t handle);
+  ble_error_t requestPairing(connection_handle_t) { return BLE_ERROR_NONE; }
+  ble_error_t setLinkSecurity(connection_handle_t, SecurityMode_t) { return BLE_ERROR_NONE; }
+  ble_error_t generateWhitelistFromBondTable(whitelist_t *whitelist) const;
+  ble_error_t purgeAllBondingState();
+
+ private:
+  friend class ::BLE;
+  friend struct sim::Stack;
+  EventHandler *handler_ = nullptr;
+  bool bonding_ = false;
+  bool authorisation_ = false;
+};
+
+} // namespace ble
+
+using ble::Gap;
+using ble::SecurityManager;
+using ble::connection_handle_t;
+
+/* -------------------------------------------------------------------------- */
+
+class UUID {
+ public:
+  UUID(uint16_t shortUUID) : shortUUID(shortUUID) {}
+  uint16_t getShortUUID() const { return shortUUID; }
+
+ private:
+  uint16_t shortUUID;
+};
+
+class GattAttribute {
+ public:
+  typedef ble::attribute_handle_t Handle_t;
+
+  GattAttribute(const UUID &uuid, uint8_t *valuePtr = nullptr, uint16_t len = 0,
+                uint16_t maxLen = 0, bool hasVariableLen = true)
+    : uuid_(uuid), value_(valuePtr), length_(len), maxLength_(maxLen)
+  {}
+
+  Handle_t getHandle() const { return handle_; }
+  const UUID &getUUID() const { return uuid_; }
+  uint8_t *getValuePtr() { return value_; }
+  uint16_t getLength() const { return length_; }
+  uint16_t getMaxLength() const { return maxLength_; }
+
+ private:
+  friend class GattServer;
+  friend struct sim::Stack;
+  UUID uuid_;
+  uint8_t *value_;
+  uint16_t length_;
+  uint16_t maxLength_;
+  Handle_t handle_ = 0;
+};
+
+class GattCharacteristic {
+ public:
+  enum {
+    UUID_BATTERY_LEVEL_CHAR               = 0x2A19,
+    UUID_BOOT_KEYBOARD_INPUT_REPORT_CHAR  = 0x2A22,
+    UUID_BOOT_KEYBOARD_OUTPUT_REPORT_CHAR = 0x2A32,
+    UUID_BOOT_MOUSE_INPUT_REPORT_CHAR     = 0x2A33,
+    UUID_HID_INFORMATION_CHAR             = 0x2A4A,
+    UUID_REPORT_MAP_CHAR                  = 0x2A4B,
+    UUID_HID_CONTROL_POINT_CHAR           = 0x2A4C,
+    UUID_REPORT_CHAR                      = 0x2A4D,
+    UUID_PROTOCOL_MODE_CHAR               = 0x2A4E,
+  };
+  enum Properties_t {
+    BLE_GATT_CHAR_PROPERTIES_NONE                   = 0x00,
+    BLE_GATT_CHAR_PROPERTIES_BROADCAST              = 0x01,
+    BLE_GATT_CHAR_PROPERTIES_READ                   = 0x02,
+    BLE_GATT_CHAR_PROPERTIES_WRITE_WITHOUT_RESPONSE = 0x04,
+    BLE_GATT_CHAR_PROPERTIES_WRITE                  = 0x08,
+    BLE_GATT_CHAR_PROPERTIES_NOTIFY                 = 0x10,
+    BLE_GATT_CHAR_PROPERTIES_INDICATE               = 0x20,
+  };
+  struct SecurityRequirement_t {
+    enum type { NONE, UNAUTHENTICATED, AUTHENTICATED, SC_AUTHENTICATED };
+    SecurityRequirement_t(type t) : v(t) {}
+    type v;
+  };
+
+  GattCharacteristic(const UUID &uuid, uint8_t *valuePtr = nullptr, uint16_t len = 0,
+                     uint16_t maxLen = 0, uint8_t props = BLE_GATT_CHAR_PROPERTIES_NONE,
+                     GattAttribute *descriptors[] = nullptr, unsigned numDescriptors = 0,
+                     bool hasVariableLen = true)
+    : value_(uuid, valuePtr, len, maxLen, hasVariableLen)
+    , descriptors_(descriptors)
+    , numDescriptors_(numDescriptors)
+    , properties_(props)
+  {}
+
+  void setReadSecurityRequirement(SecurityRequirement_t) {}
+  void setWriteSecurityRequirement(SecurityRequirement_t) {}
+
+  GattAttribute::Handle_t getValueHandle() const { return value_.getHandle(); }
+  GattAttribute &getValueAttribute() { return value_; }
+  uint8_t getProperties() const { return properties_; }
+  unsigned getDescriptorCount() const { return numDescriptors_; }
+  GattAttribute *getDescriptor(unsigned index) { return descriptors_[index]; }
+
+ private:
+  GattAttribute value_;
+  GattAttribute **descriptors_;
+  unsigned numDescriptors_;
+  uint8_t properties_;
+};
+
+class GattService {
+ public:
+  enum {
+    UUID_DEVICE_INFORMATION_SERVICE     = 0x180A,
+    UUID_BATTERY_SERVICE                = 0x180F,
+    UUID_HUMAN_INTERFACE_DEVICE_SERVICE = 0x1812,
+  };
+
+  GattService(const UUID &uuid, GattCharacteristic *characteristics[], unsigned numCharacteristics)
+    : uuid_(uuid), characteristics_(characteristics), numCharacteristics_(numCharacteristics)
+  {}
+
+  unsigned getCharacteristicCount() const { return numCharacteristics_; }
+  GattCharacteristic *getCharacteristic(unsigned index) { return characteristics_[index]; }
+
+ private:
+  UUID uuid_;
+  GattCharacteristic **characteristics_;
+  unsigned numCharacteristics_;
+};
+
+struct GattWriteCallbackParams {
+  enum WriteOp_t { OP_INVALID, OP_WRITE_REQ, OP_WRITE_CMD };
+  connection_handle_t connHandle;
+  GattAttribute::Handle_t handle;
+  WriteOp_t writeOp;
+  uint16_t offset;
+  uint16_t len;
+  const uint8_t *data;
+};
+
+struct GattDataSentCallbackParams {
+  connection_handle_t connHandle;
+  GattAttribute::Handle_t attHandle;
+};
+
+class GattServer {
+ public:
+  struct EventHandler {
+    virtual void onAttMtuChange(connection_handle_t, uint16_t) {}
+    virtual void onDataSent(const GattDataSentCallbackParams &) {}
+    virtual void onDataWritten(const GattWriteCallbackParams &) {}
+   protected:
+    ~EventHandler() {}
+  };
+
+  void setEventHandler(EventHandler *handler) { handler_ = handler; }
+  ble_error_t addService(GattService &service);
+
+  /** Update a value, notifying all the connected hosts unless @p localOnly. */
+  ble_error_t write(GattAttribute::Handle_t handle, const uint8_t *value, uint16_t size, bool localOnly = false);
+
+  /** Update a value, notifying the host @p connection only unless @p localOnly. */
+  ble_error_t write(connection_handle_t connection, GattAttribute::Handle_t handle,
+                    const uint8_t *value, uint16_t size, bool localOnly = false);
+
+ private:
+  friend class ::BLE;
+  friend struct sim::Stack;
+  EventHandler *handler_ = nullptr;
+  GattAttribute::Handle_t nextHandle_ = 1;
+};
+
+class GattClient {
+ public:
+  ble_error_t negotiateAttMtu(connection_handle_t connection);
+};
+
+/* -------------------------------------------------------------------------- */
+
+class BLE {
+ public:
+  typedef unsigned InstanceID_t;
+  static const InstanceID_t DEFAULT_INSTANCE = 0;
+
+  struct InitializationCompleteCallbackContext {
+    BLE &ble;
+    ble_error_t error;
+  };
+  struct OnEventsToProcessCallbackContext {
+    BLE &ble;
+  };
+  typedef void (*OnEventsToProcessCallback_t)(OnEventsToProcessCallbackContext *);
+
+  static BLE &Instance(InstanceID_t id = DEFAULT_INSTANCE);
+  InstanceID_t getInstanceID() const { return DEFAULT_INSTANCE; }
+
+  template<typename T>
+  ble_error_t init(T *object, void (T::*method)(InitializationCompleteCallbackContext *)) {
+    return init(mbed::Callback<void(InitializationCompleteCallbackContext*)>(object, method));
+  }
+  ble_error_t init(mbed::Callback<void(InitializationCompleteCallbackContext*)> callback);
+  bool hasInitialized() const { return initialized_; }
+
+  void onEventsToProcess(const mbed::Callback<void(OnEventsToProcessCallbackContext*)> &callback) {
+    onEventsToProcess_ = callback;
+  }
+  void processEvents();
+
+  /** Tell the application stack events are pending, through onEventsToProcess. */
+  void signalEventsToProcess();
+
+  ble::Gap &gap() { return gap_; }
+  GattServer &gattServer() { return gattServer_; }
+  GattClient &gattClient() { return gattClient_; }
+  ble::SecurityManager &securityManager() { return securityManager_; }
+
+ private:
+  ble::Gap gap_;
+  GattServer gattServer_;
+  GattClient gattClient_;
+  ble::SecurityManager securityManager_;
+  mbed::Callback<void(OnEventsToProcessCallbackContext*)> onEventsToProcess_;
+  bool initialized_ = false;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // HOST_BLE_BLE_H_
@@ -0,0 +1,22 @@
+#ifndef HOST_KVSTORE_GLOBAL_API_H_
+#define HOST_KVSTORE_GLOBAL_API_H_
+
+/* -------------------------------------------------------------------------- */
+//
+// Linux stand-in for the Mbed KVStore global API, the records being kept in
+// memory for the run.
+//
+/* -------------------------------------------------------------------------- */
+
+#include <cstddef>
+#include <cstdint>
+
+#define MBED_SUCCESS                  0
+#define MBED_ERROR_ITEM_NOT_FOUND     (-1)
+#define MBED_ERROR_INVALID_SIZE       (-2)
+
+int kv_set(const char *full_name_key, const void *buffer, size_t size, uint32_t create_flags);
+int kv_get(const char *full_name_key, void *buffer, size_t buffer_size, size_t *actual_size);
+int kv_remove(const char *full_name_key);
+
+#endif // HOST_KVSTORE_GLOBAL_API_H_
@@ -0,0 +1,244 @@
+#ifndef HOST_MBED_H_
+#define HOST_MBED_H_
+
+/* -------------------------------------------------------------------------- */
+//
+// Linux stand-in for the subset of Mbed OS used by the library.
+//
+// Time is simulated : events run in the calling thread in chronological order,
+// see sim/simulator.h.
+//
+/* -------------------------------------------------------------------------- */
+
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "platform/mbed_assert.h"
+#include "sim/simulator.h"
+
+/* -------------------------------------------------------------------------- */
+
+#define EVENTS_EVENT_SIZE           32
+#define OS_STACK_SIZE               4096
+#define osWaitForever               0xFFFFFFFFu
+#define MBED_ALIGN(n)               alignas(n)
+
+/* BLE features of the simulated stack. */
+#define BLE_FEATURE_GATT_SERVER     1
+#define BLE_FEATURE_GATT_CLIENT     1
+#define BLE_FEATURE_SECURITY        1
+#define BLE_FEATURE_PHY_MANAGEMENT  1
+#define BLE_FEATURE_WHITELIST       1
+
+typedef enum {
+  osPriorityIdle          = 1,
+  osPriorityLow           = 8,
+  osPriorityBelowNormal   = 16,
+  osPriorityNormal        = 24,
+  osPriorityAboveNormal   = 32,
+  osPriorityHigh          = 40,
+  osPriorityRealtime      = 48,
+} osPriority_t;
+
+/* Simulated time in microseconds, wrapping like the hardware ticker. */
+inline uint32_t us_ticker_read() {
+  return static_cast<uint32_t>(sim::Now());
+}
+
+/* nRF52840 pins, numbered port * 32 + pin (only the analog ones). */
+typedef enum {
+  P0_2  = 2,
+  P0_3  = 3,
+  P0_4  = 4,
+  P0_5  = 5,
+  P0_28 = 28,
+  P0_29 = 29,
+  P0_30 = 30,
+  P0_31 = 31,
+  NC    = -1,
+} PinName;
+
+inline void core_util_critical_section_enter() {}
+inline void core_util_critical_section_exit() {}
+
+/* -------------------------------------------------------------------------- */
+
+namespace mbed {
+
+template<typename F> class Callback;
+
+/* Target kept in place, as mbed's : function, object and method, or small functor. */
+template<typename R, typename... Args>
+class Callback<R(Args...)> {
+ public:
+  Callback() {}
+  Callback(std::nullptr_t) {}
+
+  Callback(R (*fn)(Args...)) {
+    if (fn) {
+      store([fn](Args... args) { return fn(args...); });
+    }
+  }
+
+  template<typename T, typename U>
+  Callback(U *obj, R (T::*method)(Args...)) {
+    store([obj, method](Args... args) { return (obj->*method)(args...); });
+  }
+
+  template<typename F, typename = decltype(std::declval<F>()(std::declval<Args>()...))>
+  Callback(F fn) {
+    store(fn);
+  }
+
+  R operator()(Args... args) const { return thunk_(storage_, args...); }
+  R call(Args... args) const { return thunk_(storage_, args...); }
+  explicit operator bool() const { return thunk_ != nullptr; }
+
+ private:
+  struct Method {
+    void *obj;
+    void (Method::*method)();
+  };
+
+  template<typename F>
+  void store(const F &fn) {
+    static_assert(std::is_trivially_copyable<F>::value && (sizeof(F) <= sizeof(Method)),
+                  "mbed::Callback only holds a function, an object and method, or a small functor");
+    memcpy(storage_, &fn, sizeof(F));
+    thunk_ = [](const void *storage, Args... args) -> R {
+      return (*static_cast<const F*>(storage))(args...);
+    };
+  }
+
+  alignas(Method) unsigned char storage_[sizeof(Method)] = {};
+  R (*thunk_)(const void*, Args...) = nullptr;
+};
+
+template<typename T, typename U, typename R, typename... Args>
+Callback<R(Args...)> callback(U *obj, R (T::*method)(Args...)) {
+  return Callback<R(Args...)>(obj, method);
+}
+
+template<typename R, typename... Args>
+Callback<R(Args...)> callback(R (*fn)(Args...)) {
+  return Callback<R(Args...)>(fn);
+}
+
+class Timer {
+ public:
+  void start() { start_ = sim::Now(); }
+  int read_ms() const { return static_cast<int>((sim::Now() - start_) / 1000); }
+  int read_us() const { return static_cast<int>(sim::Now() - start_); }
+
+ private:
+  uint64_t start_ = 0;
+};
+
+/* Periodic interrupt, run as a timeline event. */
+class Ticker {
+ public:
+  ~Ticker() { detach(); }
+
+  void attach(Callback<void()> fn, std::chrono::microseconds period) {
+    detach();
+    const uint32_t us = static_cast<uint32_t>(period.count());
+    id_ = sim::Post(this, UINT_MAX, us, us, [fn]() { fn(); });
+  }
+
+  void detach() {
+    if (id_) {
+      sim::Cancel(id_);
+      id_ = 0;
+    }
+  }
+
+ private:
+  int id_ = 0;
+};
+
+} // namespace mbed
+
+/* -------------------------------------------------------------------------- */
+
+namespace events {
+
+/**
+ * Events are posted to the simulation timeline. The queue size is honored so
+ * overflows behave as on target.
+ */
+class EventQueue {
+ public:
+  EventQueue(unsigned size = 32 * EVENTS_EVENT_SIZE, unsigned char *buffer = nullptr)
+    : capacity_(size / EVENTS_EVENT_SIZE)
+  {}
+
+  template<typename F>
+  int call(F f) { return post(0, 0, f); }
+
+  template<typename F>
+  int call_in(int ms, F f) { return post(ms, 0, f); }
+
+  template<typename F>
+  int call_every(int ms, F f) { return post(ms, ms, f); }
+
+  bool cancel(int id) { return sim::Cancel(id); }
+
+  void dispatch_forever() { sim::Run(); }
+  void dispatch(int ms = -1) { sim::Run(ms); }
+
+ private:
+  template<typename F>
+  int post(int delay, int period, F f) {
+    return sim::Post(this, capacity_, delay * 1000uLL, period * 1000u, [f]() mutable { f(); });
+  }
+
+  unsigned capacity_;
+};
+
+} // namespace events
+
+/* -------------------------------------------------------------------------- */
+
+namespace rtos {
+
+/* Threads are started when the main thread sleeps forever, one after the other. */
+class Thread {
+ public:
+  Thread(osPriority_t priority = osPriorityNormal,
+         uint32_t stackSize = OS_STACK_SIZE,
+         unsigned char *stackMemory = nullptr,
+         const char *name = nullptr)
+  {}
+
+  int start(mbed::Callback<void()> task) {
+    sim::StartThread([task]() { task(); });
+    return 0;
+  }
+};
+
+namespace ThisThread {
+
+inline void sleep_for(uint32_t ms) {
+  if (ms == osWaitForever) {
+    sim::RunThreads();
+  } else {
+    sim::Advance(ms * 1000uLL);
+  }
+}
+
+} // namespace ThisThread
+
+} // namespace rtos
+
+/* -------------------------------------------------------------------------- */
+
+using namespace mbed;
+
+#endif // HOST_MBED_H_
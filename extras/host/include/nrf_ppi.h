@@ -0,0 +1,49 @@
+#ifndef HOST_NRF_PPI_H_
+#define HOST_NRF_PPI_H_
+
+/* -------------------------------------------------------------------------- */
+//
+// Linux stand-in for the nRF52 PPI HAL (nrfx hal/nrf_ppi.h).
+//
+// An enabled channel triggers its task when its event is raised by a
+// simulated peripheral (the TIMER compare events, see nrf_timer.h). Events
+// and tasks are identified by their register addresses, as on target.
+//
+/* -------------------------------------------------------------------------- */
+
+#include <cstdint>
+
+/* -------------------------------------------------------------------------- */
+
+#define PPI_CH_NUM 20
+
+typedef enum {
+  NRF_PPI_CHANNEL0 = 0,
+  NRF_PPI_CHANNEL1,
+  NRF_PPI_CHANNEL2,
+  NRF_PPI_CHANNEL3,
+  NRF_PPI_CHANNEL4,
+  NRF_PPI_CHANNEL5,
+  NRF_PPI_CHANNEL6,
+  NRF_PPI_CHANNEL7,
+  NRF_PPI_CHANNEL8,
+  NRF_PPI_CHANNEL9,
+  NRF_PPI_CHANNEL10,
+  NRF_PPI_CHANNEL11,
+  NRF_PPI_CHANNEL12,
+  NRF_PPI_CHANNEL13,
+  NRF_PPI_CHANNEL14,
+  NRF_PPI_CHANNEL15,
+  NRF_PPI_CHANNEL16,
+  NRF_PPI_CHANNEL17,
+  NRF_PPI_CHANNEL18,
+  NRF_PPI_CHANNEL19,
+} nrf_ppi_channel_t;
+
+void nrf_ppi_channel_endpoint_setup(nrf_ppi_channel_t channel, uint32_t eep, uint32_t tep);
+void nrf_ppi_channel_enable(nrf_ppi_channel_t channel);
+void nrf_ppi_channel_disable(nrf_ppi_channel_t channel);
+
+/* -------------------------------------------------------------------------- */
+
+#endif // HOST_NRF_PPI_H_
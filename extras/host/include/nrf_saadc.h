@@ -0,0 +1,174 @@
+#ifndef HOST_NRF_SAADC_H_
+#define HOST_NRF_SAADC_H_
+
+/* -------------------------------------------------------------------------- */
+//
+// Linux stand-in for the nRF52 SAADC HAL (nrfx hal/nrf_saadc.h) and the NVIC
+// functions used with it.
+//
+// The simulated peripheral converts the analog inputs of the Arduino pins
+// (see sim::SetAnalogInput and sim::SetAnalogNoise) in scan mode with
+// oversampling, and writes them with EasyDMA to the buffer set with
+// nrf_saadc_buffer_init. Events raise the SAADC interrupt on the simulation
+// timeline, once the conversions would be done. Its tasks can also be
+// triggered through PPI (see nrf_ppi.h).
+//
+/* -------------------------------------------------------------------------- */
+
+#include <cstdint>
+
+/* -------------------------------------------------------------------------- */
+
+typedef enum {
+  SAADC_IRQn = 7,
+} IRQn_Type;
+
+void NVIC_SetVector(IRQn_Type irq, uintptr_t vector);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+
+/* -------------------------------------------------------------------------- */
+
+#define NRF_SAADC_CHANNEL_COUNT 8
+#define NRF_SAADC_BASE          0x40007000UL
+
+typedef int16_t nrf_saadc_value_t;
+
+typedef enum {
+  NRF_SAADC_RESOLUTION_8BIT  = 0,
+  NRF_SAADC_RESOLUTION_10BIT = 1,
+  NRF_SAADC_RESOLUTION_12BIT = 2,
+  NRF_SAADC_RESOLUTION_14BIT = 3,
+} nrf_saadc_resolution_t;
+
+typedef enum {
+  NRF_SAADC_INPUT_DISABLED = 0,
+  NRF_SAADC_INPUT_AIN0     = 1,
+  NRF_SAADC_INPUT_AIN1     = 2,
+  NRF_SAADC_INPUT_AIN2     = 3,
+  NRF_SAADC_INPUT_AIN3     = 4,
+  NRF_SAADC_INPUT_AIN4     = 5,
+  NRF_SAADC_INPUT_AIN5     = 6,
+  NRF_SAADC_INPUT_AIN6     = 7,
+  NRF_SAADC_INPUT_AIN7     = 8,
+  NRF_SAADC_INPUT_VDD      = 9,
+} nrf_saadc_input_t;
+
+typedef enum {
+  NRF_SAADC_OVERSAMPLE_DISABLED = 0,
+  NRF_SAADC_OVERSAMPLE_2X       = 1,
+  NRF_SAADC_OVERSAMPLE_4X       = 2,
+  NRF_SAADC_OVERSAMPLE_8X       = 3,
+  NRF_SAADC_OVERSAMPLE_16X      = 4,
+  NRF_SAADC_OVERSAMPLE_32X      = 5,
+  NRF_SAADC_OVERSAMPLE_64X      = 6,
+  NRF_SAADC_OVERSAMPLE_128X     = 7,
+  NRF_SAADC_OVERSAMPLE_256X     = 8,
+} nrf_saadc_oversample_t;
+
+typedef enum {
+  NRF_SAADC_RESISTOR_DISABLED = 0,
+  NRF_SAADC_RESISTOR_PULLDOWN = 1,
+  NRF_SAADC_RESISTOR_PULLUP   = 2,
+  NRF_SAADC_RESISTOR_VDD1_2   = 3,
+} nrf_saadc_resistor_t;
+
+typedef enum {
+  NRF_SAADC_GAIN1_6 = 0,
+  NRF_SAADC_GAIN1_5 = 1,
+  NRF_SAADC_GAIN1_4 = 2,
+  NRF_SAADC_GAIN1_3 = 3,
+  NRF_SAADC_GAIN1_2 = 4,
+  NRF_SAADC_GAIN1   = 5,
+  NRF_SAADC_GAIN2   = 6,
+  NRF_SAADC_GAIN4   = 7,
+} nrf_saadc_gain_t;
+
+typedef enum {
+  NRF_SAADC_REFERENCE_INTERNAL = 0,
+  NRF_SAADC_REFERENCE_VDD4     = 1,
+} nrf_saadc_reference_t;
+
+typedef enum {
+  NRF_SAADC_ACQTIME_3US  = 0,
+  NRF_SAADC_ACQTIME_5US  = 1,
+  NRF_SAADC_ACQTIME_10US = 2,
+  NRF_SAADC_ACQTIME_15US = 3,
+  NRF_SAADC_ACQTIME_20US = 4,
+  NRF_SAADC_ACQTIME_40US = 5,
+} nrf_saadc_acqtime_t;
+
+typedef enum {
+  NRF_SAADC_MODE_SINGLE_ENDED = 0,
+  NRF_SAADC_MODE_DIFFERENTIAL = 1,
+} nrf_saadc_mode_t;
+
+typedef enum {
+  NRF_SAADC_BURST_DISABLED = 0,
+  NRF_SAADC_BURST_ENABLED  = 1,
+} nrf_saadc_burst_t;
+
+typedef struct {
+  nrf_saadc_resistor_t  resistor_p;
+  nrf_saadc_resistor_t  resistor_n;
+  nrf_saadc_gain_t      gain;
+  nrf_saadc_reference_t reference;
+  nrf_saadc_acqtime_t   acq_time;
+  nrf_saadc_mode_t      mode;
+  nrf_saadc_burst_t     burst;
+  nrf_saadc_input_t     pin_p;
+  nrf_saadc_input_t     pin_n;
+} nrf_saadc_channel_config_t;
+
+typedef enum {
+  NRF_SAADC_TASK_START           = 0x0000,
+  NRF_SAADC_TASK_SAMPLE          = 0x0004,
+  NRF_SAADC_TASK_STOP            = 0x0008,
+  NRF_SAADC_TASK_CALIBRATEOFFSET = 0x000C,
+} nrf_saadc_task_t;
+
+typedef enum {
+  NRF_SAADC_EVENT_STARTED       = 0x0100,
+  NRF_SAADC_EVENT_END           = 0x0104,
+  NRF_SAADC_EVENT_DONE          = 0x0108,
+  NRF_SAADC_EVENT_RESULTDONE    = 0x010C,
+  NRF_SAADC_EVENT_CALIBRATEDONE = 0x0110,
+  NRF_SAADC_EVENT_STOPPED       = 0x0114,
+} nrf_saadc_event_t;
+
+typedef enum {
+  NRF_SAADC_INT_STARTED       = 1 << 0,
+  NRF_SAADC_INT_END           = 1 << 1,
+  NRF_SAADC_INT_DONE          = 1 << 2,
+  NRF_SAADC_INT_RESULTDONE    = 1 << 3,
+  NRF_SAADC_INT_CALIBRATEDONE = 1 << 4,
+  NRF_SAADC_INT_STOPPED       = 1 << 5,
+  NRF_SAADC_INT_ALL           = 0x7FFFFFFFUL,
+} nrf_saadc_int_mask_t;
+
+void nrf_saadc_enable(void);
+void nrf_saadc_disable(void);
+bool nrf_saadc_enable_check(void);
+
+void nrf_saadc_resolution_set(nrf_saadc_resolution_t resolution);
+void nrf_saadc_oversample_set(nrf_saadc_oversample_t oversample);
+
+void nrf_saadc_channel_init(uint8_t channel, nrf_saadc_channel_config_t const *config);
+void nrf_saadc_channel_input_set(uint8_t channel, nrf_saadc_input_t pselp, nrf_saadc_input_t pseln);
+
+void nrf_saadc_buffer_init(nrf_saadc_value_t *buffer, uint32_t num);
+uint16_t nrf_saadc_amount_get(void);
+
+void nrf_saadc_task_trigger(nrf_saadc_task_t task);
+uint32_t nrf_saadc_task_address_get(nrf_saadc_task_t task);
+bool nrf_saadc_event_check(nrf_saadc_event_t event);
+void nrf_saadc_event_clear(nrf_saadc_event_t event);
+
+void nrf_saadc_int_enable(uint32_t mask);
+void nrf_saadc_int_disable(uint32_t mask);
+
+/* -------------------------------------------------------------------------- */
+
+#endif // HOST_NRF_SAADC_H_
@@ -0,0 +1,100 @@
+#ifndef HOST_NRF_TIMER_H_
+#define HOST_NRF_TIMER_H_
+
+/* -------------------------------------------------------------------------- */
+//
+// Linux stand-in for the nRF52 TIMER HAL (nrfx hal/nrf_timer.h).
+//
+// The simulated timers only raise their COMPARE0 event, on the simulation
+// timeline, repeatedly with the COMPARE0_CLEAR short. Events are published to
+// PPI (see nrf_ppi.h) and have no interrupt.
+//
+/* -------------------------------------------------------------------------- */
+
+#include <cstdint>
+
+/* -------------------------------------------------------------------------- */
+
+struct NRF_TIMER_Type;
+
+#define NRF_TIMER0_BASE   0x40008000UL
+#define NRF_TIMER1_BASE   0x40009000UL
+#define NRF_TIMER2_BASE   0x4000A000UL
+#define NRF_TIMER3_BASE   0x4001A000UL
+#define NRF_TIMER4_BASE   0x4001B000UL
+
+#define NRF_TIMER0        ((NRF_TIMER_Type *) NRF_TIMER0_BASE)
+#define NRF_TIMER1        ((NRF_TIMER_Type *) NRF_TIMER1_BASE)
+#define NRF_TIMER2        ((NRF_TIMER_Type *) NRF_TIMER2_BASE)
+#define NRF_TIMER3        ((NRF_TIMER_Type *) NRF_TIMER3_BASE)
+#define NRF_TIMER4        ((NRF_TIMER_Type *) NRF_TIMER4_BASE)
+
+typedef enum {
+  NRF_TIMER_TASK_START    = 0x000,
+  NRF_TIMER_TASK_STOP     = 0x004,
+  NRF_TIMER_TASK_COUNT    = 0x008,
+  NRF_TIMER_TASK_CLEAR    = 0x00C,
+  NRF_TIMER_TASK_SHUTDOWN = 0x010,
+} nrf_timer_task_t;
+
+typedef enum {
+  NRF_TIMER_EVENT_COMPARE0 = 0x140,
+  NRF_TIMER_EVENT_COMPARE1 = 0x144,
+  NRF_TIMER_EVENT_COMPARE2 = 0x148,
+  NRF_TIMER_EVENT_COMPARE3 = 0x14C,
+} nrf_timer_event_t;
+
+typedef enum {
+  NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK = 1 << 0,
+  NRF_TIMER_SHORT_COMPARE0_STOP_MASK  = 1 << 8,
+} nrf_timer_short_mask_t;
+
+typedef enum {
+  NRF_TIMER_MODE_TIMER             = 0,
+  NRF_TIMER_MODE_COUNTER           = 1,
+  NRF_TIMER_MODE_LOW_POWER_COUNTER = 2,
+} nrf_timer_mode_t;
+
+typedef enum {
+  NRF_TIMER_BIT_WIDTH_8  = 1,
+  NRF_TIMER_BIT_WIDTH_16 = 0,
+  NRF_TIMER_BIT_WIDTH_24 = 2,
+  NRF_TIMER_BIT_WIDTH_32 = 3,
+} nrf_timer_bit_width_t;
+
+typedef enum {
+  NRF_TIMER_FREQ_16MHz = 0,
+  NRF_TIMER_FREQ_8MHz,
+  NRF_TIMER_FREQ_4MHz,
+  NRF_TIMER_FREQ_2MHz,
+  NRF_TIMER_FREQ_1MHz,
+  NRF_TIMER_FREQ_500kHz,
+  NRF_TIMER_FREQ_250kHz,
+  NRF_TIMER_FREQ_125kHz,
+  NRF_TIMER_FREQ_62500Hz,
+  NRF_TIMER_FREQ_31250Hz,
+} nrf_timer_frequency_t;
+
+typedef enum {
+  NRF_TIMER_CC_CHANNEL0 = 0,
+  NRF_TIMER_CC_CHANNEL1,
+  NRF_TIMER_CC_CHANNEL2,
+  NRF_TIMER_CC_CHANNEL3,
+} nrf_timer_cc_channel_t;
+
+void nrf_timer_task_trigger(NRF_TIMER_Type *p_reg, nrf_timer_task_t task);
+uint32_t nrf_timer_event_address_get(NRF_TIMER_Type *p_reg, nrf_timer_event_t event);
+bool nrf_timer_event_check(NRF_TIMER_Type *p_reg, nrf_timer_event_t event);
+void nrf_timer_event_clear(NRF_TIMER_Type *p_reg, nrf_timer_event_t event);
+
+void nrf_timer_shorts_enable(NRF_TIMER_Type *p_reg, uint32_t mask);
+void nrf_timer_shorts_disable(NRF_TIMER_Type *p_reg, uint32_t mask);
+
+void nrf_timer_mode_set(NRF_TIMER_Type *p_reg, nrf_timer_mode_t mode);
+void nrf_timer_bit_width_set(NRF_TIMER_Type *p_reg, nrf_timer_bit_width_t bit_width);
+void nrf_timer_frequency_set(NRF_TIMER_Type *p_reg, nrf_timer_frequency_t frequency);
+void nrf_timer_cc_write(NRF_TIMER_Type *p_reg, nrf_timer_cc_channel_t cc_channel, uint32_t cc_value);
+
+/* -------------------------------------------------------------------------- */
+
+#endif // HOST_NRF_TIMER_H_
@@ -0,0 +1,9 @@
+#ifndef HOST_MBED_ASSERT_H_
+#define HOST_MBED_ASSERT_H_
+
+#include <cassert>
+
+#define MBED_ASSERT(expr)               assert(expr)
+#define MBED_STATIC_ASSERT(expr, msg)   static_assert(expr, msg)
+
+#endif // HOST_MBED_ASSERT_H_
@@ -0,0 +1,134 @@
+#ifndef HOST_SIM_SIMULATOR_H_
+#define HOST_SIM_SIMULATOR_H_
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+//
+// Host simulation backend.
+//
+// Mbed event queues, threads and the BLE stack run on a single simulated
+// timeline : events are processed in chronological order, jumping from one to
+// the next, so runs are deterministic and faster than real time.
+//
+// A simulated host connects to the advertising device, negotiates the link
+// and receives the notifications at each connection event. Every notification
+// is recorded with its timestamp.
+//
+/* -------------------------------------------------------------------------- */
+
+namespace sim {
+
+/** Parameters of the simulated run and host. */
+struct Config {
+  uint32_t durationMs         = 10000;  // Simulated run duration.
+  uint32_t connectDelayMs     = 100;    // Delay before the host connects to an advertising device (0 : never).
+  uint32_t disconnectAtMs     = 0;      // Time the host disconnects (0 : never).
+  uint32_t connectionInterval = 7500;   // In microseconds, multiple of 1250.
+  uint16_t attMtu             = 247;    // ATT MTU accepted by the host.
+  uint16_t dataLength         = 251;    // LE Data Length Extension accepted by the host.
+  bool     phy2M              = true;   // Does the host support the 2M PHY ?
+  bool     bond               = true;   // Does the host bond when the device allows it ?
+  int      notificationsPerEvent = 4;   // Notifications sent per connection event.
+  int      txBuffers          = 8;      // Notifications buffered by the stack.
+};
+
+/** A notification received by the host. */
+struct Notification {
+  uint64_t timestamp;     // End of the connection event which carried it, in microseconds.
+  uintptr_t connection;
+  uint16_t handle;        // Attribute handle of the characteristic value.
+  std::vector<uint8_t> data;
+};
+
+/** A GATT attribute registered by the device. */
+struct Attribute {
+  uint16_t uuid;
+  uint16_t handle;
+  uint8_t  properties;    // Characteristic properties, 0 for descriptors.
+  const uint8_t *value;   // Current value, owned by the device.
+  uint16_t length;
+};
+
+/** A report characteristic of a HID service, with its Report Reference. */
+struct Report {
+  uint16_t handle;
+  uint8_t  id;            // 0 when the report map has no Report IDs.
+  uint8_t  type;          // 1 : input, 2 : output, 3 : feature.
+};
+
+/** A HID service registered by the device. */
+struct HIDServiceInfo {
+  const Attribute *reportMap;
+  std::vector<Report> reports;
+};
+
+Config& GetConfig();
+
+// -- Timeline --
+uint64_t Now();
+void Advance(uint64_t us);
+
+/** Post an event for @p queue (up to @p capacity pending events), return its id or 0 when full. */
+int Post(const void *queue, unsigned capacity, uint64_t delay, uint32_t period, std::function<void()> fn);
+
+/** Schedule a stack or host event, with no capacity limit. */
+int Schedule(uint64_t delay, std::function<void()> fn);
+
+bool Cancel(int id);
+
+/** Process the events until the end of the run, or for @p ms milliseconds. */
+void Run(int ms = -1);
+
+/** Process the events up to the simulated time @p end, in microseconds. */
+void RunUntil(uint64_t end);
+
+/** End the current run once the event being processed returns. */
+void Stop();
+
+void StartThread(std::function<void()> task);
+void RunThreads();
+
+// -- Host side --
+const std::vector<Notification>& Notifications();
+const std::vector<Attribute>& Attributes();
+
+/** Return the attribute of the characteristic value or descriptor @p handle, or nullptr. */
+const Attribute* FindAttribute(uint16_t handle);
+
+/** HID services registered by the device, in registration order. */
+std::vector<HIDServiceInfo> HIDServices();
+
+/** Write an attribute from the host, eg. an output report. */
+void HostWrite(uint16_t handle, const uint8_t *data, uint16_t length);
+
+/** Called on each notification received by the host, when set. */
+void OnNotification(std::function<void(const Notification&)> fn);
+
+// -- Inputs --
+
+/** Set the value returned by analogRead(@p pin), mid-range (512) by default. */
+void SetAnalogInput(int pin, int value);
+
+/** Add a uniform noise of +/- @p amplitude LSB to the SAADC conversions of @p pin (12-bit). */
+void SetAnalogNoise(int pin, int amplitude);
+
+/** Motion of the IMU : specific force in g and angular rate in dps, in the sensor axes. */
+struct ImuMotion {
+  float accel[3];
+  float gyro[3];
+};
+
+/** Set the motion of the IMU at each time (in seconds), still and flat by default. */
+void SetImuMotion(std::function<ImuMotion(double)> motion);
+
+/** Set the IMU gyro bias (dps) and the uniform noise amplitudes of its gyro (dps) and accelerometer (g). */
+void SetImuErrors(const float gyroBias[3], float gyroNoise, float accelNoise);
+
+} // namespace sim
+
+/* -------------------------------------------------------------------------- */
+
+#endif // HOST_SIM_SIMULATOR_H_
@@ -0,0 +1,200 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Arduino.h"
+#include "adc_scanner.h"
+
+/* -------------------------------------------------------------------------- */
+//
+// Check the AdcScanner averaging and calibration on the simulated SAADC.
+//
+//  average     : AdcScanner::Average against a floating point reference.
+//  calibration : rest position averaged in the background, against the input.
+//  values      : mean and noise of the published values, the noise of the
+//                conversions being reduced by the oversampling and the average
+//                of the scans.
+//  step        : delay for a step of the input to be published.
+//
+// Exits with 1 when a check fails.
+//
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+const int kPinX = A7;
+const int kPinY = A6;
+
+struct Options {
+  uint32_t periodUs = AdcScanner::kDefaultPeriodUs;
+  int noise         = 16;     // in 12-bit LSB.
+};
+
+/* Conversion of a simulated analog input (10-bit) without noise. */
+float Expected(int input)
+{
+  return static_cast<float>((input * AdcScanner::kMaxValue + 511) / 1023);
+}
+
+bool Report(const char *name, bool ok, const char *format, double a, double b)
+{
+  printf("%-12s %s  ", name, ok ? "ok  " : "FAIL");
+  printf(format, a, b);
+  printf("\n");
+  return ok;
+}
+
+bool CheckAverage()
+{
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> sample(-8, AdcScanner::kMaxValue);
+
+  int mismatches = 0;
+  for (int run = 0; run < 10000; ++run) {
+    const int numChannels = 1 + run % AdcScanner::kMaxChannels;
+    const int numScans    = 1 + (run / AdcScanner::kMaxChannels) % AdcScanner::kScansPerBuffer;
+    nrf_saadc_value_t buffer[AdcScanner::kScansPerBuffer * AdcScanner::kMaxChannels];
+    for (int i = 0; i < numChannels * numScans; ++i) {
+      buffer[i] = static_cast<nrf_saadc_value_t>(sample(rng));
+    }
+
+    uint16_t out[AdcScanner::kMaxChannels];
+    AdcScanner::Average(buffer, numChannels, numScans, out);
+    for (int c = 0; c < numChannels; ++c) {
+      double sum = 0.0;
+      for (int s = 0; s < numScans; ++s) {
+        sum += std::max(0, static_cast<int>(buffer[s * numChannels + c]));
+      }
+      mismatches += (out[c] != static_cast<uint16_t>(std::floor(sum / numScans + 0.5))) ? 1 : 0;
+    }
+  }
+  return Report("average", mismatches == 0, "%.0f mismatches over %.0f buffers", mismatches, 10000);
+}
+
+bool CheckScanner(const Options &options)
+{
+  const int inputX = 300;
+  const int inputY = 800;
+  sim::SetAnalogInput(kPinX, inputX);
+  sim::SetAnalogInput(kPinY, inputY);
+  sim::SetAnalogNoise(kPinX, options.noise);
+  sim::SetAnalogNoise(kPinY, options.noise);
+
+  auto &adc = AdcScanner::Get();
+  const int channelX = adc.addPin(kPinX);
+  const int channelY = adc.addPin(kPinY);
+  if ((channelX < 0) || (channelY < 0) || !adc.start(options.periodUs)) {
+    printf("could not start the scanner\n");
+    return false;
+  }
+  adc.calibrate();
+
+  // Calibration, done in the background.
+  const uint64_t calibrationStart = sim::Now();
+  while (!adc.calibrated() && (sim::Now() - calibrationStart < 1000000)) {
+    sim::RunUntil(sim::Now() + 1000);
+  }
+  const float errorX = adc.calibration(channelX) - Expected(inputX);
+  const float errorY = adc.calibration(channelY) - Expected(inputY);
+  bool ok = Report("calibration", adc.calibrated() && (fabs(errorX) < 1.5f) && (fabs(errorY) < 1.5f),
+    "error %+.2f %+.2f LSB", errorX, errorY);
+  ok &= Report("", adc.calibrated(), "done in %.1f ms, %.0f buffers",
+    (sim::Now() - calibrationStart) / 1000.0, AdcScanner::kDefaultCalibrationBuffers);
+
+  // Published values, read every millisecond.
+  double sum = 0.0, sumSquares = 0.0;
+  int count = 0;
+  uint32_t lastSequence = 0;
+  for (int i = 0; i < 2000; ++i) {
+    sim::RunUntil(sim::Now() + 1000);
+    uint16_t values[AdcScanner::kMaxChannels];
+    const uint32_t sequence = adc.read(values);
+    if (sequence != lastSequence) {
+      const double error = values[channelX] - Expected(inputX);
+      sum += error;
+      sumSquares += error * error;
+      ++count;
+      lastSequence = sequence;
+    }
+  }
+  const double mean = count ? sum / count : 0.0;
+  const double deviation = count ? sqrt(sumSquares / count - mean * mean) : 0.0;
+  const double rawDeviation = options.noise / sqrt(3.0);
+  ok &= Report("values", count && (fabs(mean) < 1.0), "mean error %+.2f LSB over %.0f buffers", mean, count);
+  ok &= Report("", !options.noise || (deviation < rawDeviation / 3.0), "noise %.2f LSB RMS, %.2f per conversion",
+    deviation, rawDeviation);
+
+  // Step of the input, until published within 2 LSB.
+  const int inputStep = 700;
+  sim::SetAnalogNoise(kPinX, 0);
+  sim::SetAnalogInput(kPinX, inputStep);
+  const uint64_t stepStart = sim::Now();
+  while (sim::Now() - stepStart < 100000) {
+    sim::RunUntil(sim::Now() + 100);
+    if (fabs(adc.value(channelX) - Expected(inputStep)) <= 2.0f) {
+      break;
+    }
+  }
+  const double stepMs = (sim::Now() - stepStart) / 1000.0;
+  const double maxStepMs = 2.0 * AdcScanner::kScansPerBuffer * options.periodUs / 1000.0;
+  ok &= Report("step", stepMs <= maxStepMs, "%.1f ms (at most %.1f ms)", stepMs, maxStepMs);
+
+  adc.stop();
+  return ok;
+}
+
+void PrintUsage(const char *name)
+{
+  fprintf(stderr,
+    "usage: %s [options]\n"
+    "  --period US          scan period (default %u)\n"
+    "  --noise LSB          noise of the conversions, 12-bit (default 16)\n",
+    name, static_cast<unsigned>(AdcScanner::kDefaultPeriodUs)
+  );
+}
+
+bool ParseArgs(int argc, char *argv[], Options *options)
+{
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+    if (!value) {
+      return false;
+    }
+    ++i;
+    if (!strcmp(arg, "--period")) {
+      options->periodUs = atoi(value);
+    } else if (!strcmp(arg, "--noise")) {
+      options->noise = atoi(value);
+    } else {
+      return false;
+    }
+  }
+  return (options->periodUs > 0) && (options->noise >= 0);
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+void setup() {}
+void loop() {}
+
+int main(int argc, char *argv[])
+{
+  Options options;
+  if (!ParseArgs(argc, argv, &options)) {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  bool ok = CheckAverage();
+  ok &= CheckScanner(options);
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* -------------------------------------------------------------------------- */
@@ -0,0 +1,123 @@
+#include <cstdarg>
+#include <cstdio>
+#include <map>
+
+#include "Arduino.h"
+
+/* -------------------------------------------------------------------------- */
+
+HostSerial Serial;
+
+unsigned long millis()
+{
+  return static_cast<unsigned long>(sim::Now() / 1000);
+}
+
+unsigned long micros()
+{
+  return static_cast<unsigned long>(sim::Now());
+}
+
+void delay(unsigned long ms)
+{
+  sim::Advance(ms * 1000uLL);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  sim::Advance(us);
+}
+
+void pinMode(int pin, int mode) {}
+
+int digitalRead(int pin)
+{
+  return HIGH;
+}
+
+void digitalWrite(int pin, int value) {}
+
+namespace {
+
+std::map<int, int> sAnalogInputs;
+
+} // namespace
+
+void sim::SetAnalogInput(int pin, int value)
+{
+  sAnalogInputs[pin] = value;
+}
+
+int analogRead(int pin)
+{
+  auto it = sAnalogInputs.find(pin);
+  return (it != sAnalogInputs.end()) ? it->second : 512;
+}
+
+void analogWrite(int pin, int value) {}
+
+PinName digitalPinToPinName(int pin)
+{
+  static const PinName kAnalogPins[] = { P0_4, P0_5, P0_30, P0_29, P0_31, P0_2, P0_28, P0_3 };
+  return ((pin >= A0) && (pin <= A7)) ? kAnalogPins[pin - A0] : NC;
+}
+
+void attachInterrupt(int interrupt, void (*isr)(), int mode) {}
+
+long random(long max)
+{
+  return (max > 0) ? std::rand() % max : 0;
+}
+
+long random(long min, long max)
+{
+  return (max > min) ? min + random(max - min) : min;
+}
+
+/* -------------------------------------------------------------------------- */
+
+size_t HostSerial::print(const char *s)
+{
+  return fprintf(stderr, "%s", s);
+}
+
+size_t HostSerial::print(long v)
+{
+  return fprintf(stderr, "%ld", v);
+}
+
+size_t HostSerial::print(double v)
+{
+  return fprintf(stderr, "%.2f", v);
+}
+
+size_t HostSerial::println(const char *s)
+{
+  return fprintf(stderr, "%s\n", s);
+}
+
+size_t HostSerial::println(long v)
+{
+  return fprintf(stderr, "%ld\n", v);
+}
+
+size_t HostSerial::println(double v)
+{
+  return fprintf(stderr, "%.2f\n", v);
+}
+
+size_t HostSerial::printf(const char *format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  const int n = vfprintf(stderr, format, args);
+  va_end(args);
+  return (n > 0) ? n : 0;
+}
+
+size_t HostSerial::write(const uint8_t *data, size_t size)
+{
+  return fwrite(data, 1, size, stderr);
+}
+
+/* -------------------------------------------------------------------------- */
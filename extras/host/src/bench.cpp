@@ -0,0 +1,174 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Arduino.h"
+#include "ble/BLE.h"
+#include "bench_cases.h"
+
+/* -------------------------------------------------------------------------- */
+//
+// Run the micro-benchmarks of extras/bench on the host, and compare them to a
+// baseline saved by a previous run to catch regressions.
+//
+// Results are written as CSV lines "name,ns per call" on stdout, which is also
+// the baseline format.
+//
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+struct Options {
+  uint32_t iterations          = 1000000;
+  const char *saveFilename     = nullptr;
+  const char *compareFilename  = nullptr;
+  float threshold              = 0.10f;
+};
+
+struct Result {
+  std::string name;
+  float time;
+};
+
+void PrintUsage(const char *name)
+{
+  fprintf(stderr,
+    "usage: %s [options]\n"
+    "  --iterations N       calls per measure (default 1000000)\n"
+    "  --save FILE          save the results as a baseline\n"
+    "  --compare FILE       compare the results to a baseline, fail on regression\n"
+    "  --threshold PCT      slowdown considered a regression (default 10)\n",
+    name
+  );
+}
+
+bool ParseArgs(int argc, char *argv[], Options *options)
+{
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+    if (!value) {
+      return false;
+    }
+    ++i;
+    if (!strcmp(arg, "--iterations")) {
+      options->iterations = static_cast<uint32_t>(atol(value));
+    } else if (!strcmp(arg, "--save")) {
+      options->saveFilename = value;
+    } else if (!strcmp(arg, "--compare")) {
+      options->compareFilename = value;
+    } else if (!strcmp(arg, "--threshold")) {
+      options->threshold = atof(value) / 100.0f;
+    } else {
+      return false;
+    }
+  }
+  return options->iterations > 0;
+}
+
+bool Save(const char *filename, const std::vector<Result> &results)
+{
+  FILE *fd = fopen(filename, "w");
+  if (!fd) {
+    return false;
+  }
+  for (const auto &result : results) {
+    fprintf(fd, "%s,%.3f\n", result.name.c_str(), result.time);
+  }
+  fclose(fd);
+  return true;
+}
+
+bool Load(const char *filename, std::map<std::string, float> *baseline)
+{
+  FILE *fd = fopen(filename, "r");
+  if (!fd) {
+    return false;
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), fd)) {
+    char *comma = strrchr(line, ',');
+    if (comma) {
+      *comma = '\0';
+      (*baseline)[line] = atof(comma + 1);
+    }
+  }
+  fclose(fd);
+  return true;
+}
+
+/* Print the results against the baseline, return the number of regressions. */
+int Compare(const std::vector<Result> &results, const std::map<std::string, float> &baseline, float threshold)
+{
+  // Times too small to be compared reliably, in nanoseconds.
+  const float kResolution = 0.5f;
+
+  int regressions = 0;
+  fprintf(stderr, "%-28s %10s %10s %8s\n", "benchmark", "baseline", "current", "change");
+  for (const auto &result : results) {
+    auto it = baseline.find(result.name);
+    if (it == baseline.end()) {
+      fprintf(stderr, "%-28s %10s %10.2f\n", result.name.c_str(), "-", result.time);
+      continue;
+    }
+    const float reference = it->second;
+    const float change = (result.time - reference) / std::max(reference, kResolution);
+    const bool bRegression = (change > threshold) && (result.time - reference > kResolution);
+    regressions += bRegression;
+    fprintf(stderr, "%-28s %10.2f %10.2f %+7.1f%%%s\n",
+      result.name.c_str(), reference, result.time, 100.0f * change, bRegression ? "  REGRESSION" : ""
+    );
+  }
+  return regressions;
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+// (the services of the benchmarks are created outside of a sketch)
+void setup() {}
+void loop() {}
+
+int main(int argc, char *argv[])
+{
+  Options options;
+  if (!ParseArgs(argc, argv, &options)) {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  BLE &ble = BLE::Instance();
+  HIDKeyboardService keyboard(ble);
+  HIDMouseService mouse(ble);
+  keyboard.registerService();
+  mouse.registerService();
+
+  std::vector<Result> results;
+  bench::Initialize();
+  bench::RunBenchmarks(keyboard, mouse, options.iterations, [&results](const char *name, float time) {
+    printf("%s,%.3f\n", name, time);
+    results.push_back({ name, time });
+  });
+
+  if (options.saveFilename && !Save(options.saveFilename, results)) {
+    fprintf(stderr, "could not write %s\n", options.saveFilename);
+    return EXIT_FAILURE;
+  }
+  if (options.compareFilename) {
+    std::map<std::string, float> baseline;
+    if (!Load(options.compareFilename, &baseline)) {
+      fprintf(stderr, "could not read %s\n", options.compareFilename);
+      return EXIT_FAILURE;
+    }
+    if (Compare(results, baseline, options.threshold) > 0) {
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
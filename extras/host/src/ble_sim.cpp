@@ -0,0 +1,541 @@
+#include <deque>
+#include <map>
+
+#include "ble/BLE.h"
+
+/* -------------------------------------------------------------------------- */
+//
+// Simulated BLE stack and host.
+//
+// Stack callbacks are queued then delivered by BLE::processEvents(), as on
+// target. The host connects to the advertising device, negotiates the link
+// following the simulation config and receives up to a fixed number of
+// notifications per connection event.
+//
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+struct Connection {
+  bool connected                  = false;
+  ble::connection_handle_t handle = 0;
+  int eventId                     = 0;
+  std::deque<sim::Notification> tx;
+};
+
+/* Stack callbacks waiting for BLE::processEvents(). */
+std::deque<std::function<void()>> sStackEvents;
+
+std::vector<sim::Attribute> sAttributes;
+std::map<uint16_t, GattAttribute*> sAttributeValues;
+std::map<uint16_t, uint8_t> sAttributeProperties;
+
+std::vector<sim::Notification> sNotifications;
+std::function<void(const sim::Notification&)> sOnNotification;
+
+Connection sConnection;
+ble::connection_handle_t sNextConnectionHandle = 1;
+bool sConnectionPending = false;
+bool sBonded = false;
+
+/* Address of the simulated host. */
+const ble::address_t& HostAddress()
+{
+  static ble::address_t sAddress;
+  static bool bInit(false);
+  if (!bInit) {
+    const uint8_t kAddress[6] = { 0x01, 0x23, 0x45, 0x67, 0x89, 0xC0 };
+    memcpy(sAddress.data, kAddress, sizeof(kAddress));
+    bInit = true;
+  }
+  return sAddress;
+}
+
+uint64_t ConnectionInterval()
+{
+  return sim::GetConfig().connectionInterval;
+}
+
+/* Queue a stack callback, signaling the application on the first one. */
+void PostStackEvent(std::function<void()> fn, uint64_t delay = 0)
+{
+  auto post = [fn]() {
+    const bool bWasEmpty = sStackEvents.empty();
+    sStackEvents.push_back(fn);
+    if (bWasEmpty) {
+      BLE::Instance().signalEventsToProcess();
+    }
+  };
+  if (delay) {
+    sim::Schedule(delay, post);
+  } else {
+    post();
+  }
+}
+
+void RecordNotification(sim::Notification notification)
+{
+  sNotifications.push_back(std::move(notification));
+  if (sOnNotification) {
+    sOnNotification(sNotifications.back());
+  }
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+namespace sim {
+
+struct Stack {
+  static Gap::EventHandler* gapHandler() { return BLE::Instance().gap().handler_; }
+  static GattServer::EventHandler* gattHandler() { return BLE::Instance().gattServer().handler_; }
+  static SecurityManager::EventHandler* securityHandler() { return BLE::Instance().securityManager().handler_; }
+  static bool& advertising() { return BLE::Instance().gap().advertising_; }
+  static int& advertisingEndId() { return BLE::Instance().gap().advertisingEndId_; }
+  static bool bonding() { return BLE::Instance().securityManager().bonding_; }
+  static bool pairingAuthorisation() { return BLE::Instance().securityManager().authorisation_; }
+
+  static void connectionEvent();
+  static void connect();
+  static void disconnect(ble::disconnection_reason_t reason);
+};
+
+/* Send the pending notifications, then schedule the next connection event. */
+void Stack::connectionEvent()
+{
+  const Config &config = GetConfig();
+  auto &connection = sConnection;
+
+  for (int i = 0; (i < config.notificationsPerEvent) && !connection.tx.empty(); ++i) {
+    Notification notification = std::move(connection.tx.front());
+    connection.tx.pop_front();
+    notification.timestamp = Now();
+
+    const GattDataSentCallbackParams params{ notification.connection, notification.handle };
+    PostStackEvent([params]() {
+      if (auto *handler = gattHandler()) {
+        handler->onDataSent(params);
+      }
+    });
+    RecordNotification(std::move(notification));
+  }
+  connection.eventId = Schedule(ConnectionInterval(), connectionEvent);
+}
+
+void Stack::connect()
+{
+  sConnectionPending = false;
+  if (!advertising() || sConnection.connected) {
+    return;
+  }
+  const Config &config = GetConfig();
+
+  advertising() = false;
+  if (advertisingEndId()) {
+    Cancel(advertisingEndId());
+    advertisingEndId() = 0;
+  }
+
+  auto &connection = sConnection;
+  connection.connected = true;
+  connection.handle    = sNextConnectionHandle++;
+  connection.tx.clear();
+  connection.eventId   = Schedule(ConnectionInterval(), connectionEvent);
+
+  const ble::connection_handle_t handle = connection.handle;
+  const ble::ConnectionCompleteEvent event(
+    BLE_ERROR_NONE, handle,
+    ble::peer_address_type_t::PUBLIC, HostAddress(),
+    ble::conn_interval_t(static_cast<uint16_t>(config.connectionInterval / 1250))
+  );
+  PostStackEvent([event]() {
+    if (auto *handler = gapHandler()) {
+      handler->onConnectionComplete(event);
+    }
+  });
+
+  // The controllers negotiate the data length by themselves.
+  const uint16_t dataLength = config.dataLength;
+  PostStackEvent([handle, dataLength]() {
+    if (auto *handler = gapHandler()) {
+      handler->onDataLengthChange(handle, dataLength, dataLength);
+    }
+  }, ConnectionInterval());
+
+  // A bonded host encrypts the link right away, otherwise it pairs first.
+  if (sBonded) {
+    PostStackEvent([handle]() {
+      if (auto *handler = securityHandler()) {
+        handler->linkEncryptionResult(handle, ble::link_encryption_t::ENCRYPTED);
+      }
+    }, 2 * ConnectionInterval());
+  } else if (pairingAuthorisation()) {
+    PostStackEvent([handle]() {
+      if (auto *handler = securityHandler()) {
+        handler->pairingRequest(handle);
+      }
+    }, 2 * ConnectionInterval());
+  }
+
+  if (config.disconnectAtMs && (Now() < config.disconnectAtMs * 1000uLL)) {
+    Schedule(config.disconnectAtMs * 1000uLL - Now(), []() {
+      disconnect(ble::disconnection_reason_t::REMOTE_USER_TERMINATED_CONNECTION);
+    });
+  }
+}
+
+void Stack::disconnect(ble::disconnection_reason_t reason)
+{
+  auto &connection = sConnection;
+  if (!connection.connected) {
+    return;
+  }
+  Cancel(connection.eventId);
+  connection.connected = false;
+  connection.tx.clear();
+
+  const ble::DisconnectionCompleteEvent event(connection.handle, reason);
+  PostStackEvent([event]() {
+    if (auto *handler = gapHandler()) {
+      handler->onDisconnectionComplete(event);
+    }
+  });
+}
+
+/* -------------------------------------------------------------------------- */
+
+const std::vector<Notification>& Notifications()
+{
+  return sNotifications;
+}
+
+const std::vector<Attribute>& Attributes()
+{
+  return sAttributes;
+}
+
+const Attribute* FindAttribute(uint16_t handle)
+{
+  for (const auto &attribute : sAttributes) {
+    if (attribute.handle == handle) {
+      return &attribute;
+    }
+  }
+  return nullptr;
+}
+
+std::vector<HIDServiceInfo> HIDServices()
+{
+  // Report characteristics come before the report map of their service, each
+  // value being directly followed by its Report Reference descriptor.
+  std::vector<HIDServiceInfo> services;
+  std::vector<Report> reports;
+
+  for (size_t i = 0; i < sAttributes.size(); ++i) {
+    const auto &attribute = sAttributes[i];
+    if (attribute.uuid == GattCharacteristic::UUID_REPORT_CHAR) {
+      Report report{ attribute.handle, 0, 1 };
+      if ((i + 1 < sAttributes.size()) && (sAttributes[i + 1].length >= 2)) {
+        report.id   = sAttributes[i + 1].value[0];
+        report.type = sAttributes[i + 1].value[1];
+      }
+      reports.push_back(report);
+    } else if (attribute.uuid == GattCharacteristic::UUID_REPORT_MAP_CHAR) {
+      services.push_back({ &attribute, std::move(reports) });
+      reports.clear();
+    }
+  }
+  return services;
+}
+
+void HostWrite(uint16_t handle, const uint8_t *data, uint16_t length)
+{
+  if (!sConnection.connected) {
+    return;
+  }
+  const ble::connection_handle_t connection = sConnection.handle;
+  std::vector<uint8_t> value(data, data + length);
+
+  PostStackEvent([connection, handle, value]() {
+    auto it = sAttributeValues.find(handle);
+    if (it != sAttributeValues.end()) {
+      GattAttribute *attribute = it->second;
+      const uint16_t size = (value.size() < attribute->getMaxLength()) ? value.size() : attribute->getMaxLength();
+      if (attribute->getValuePtr()) {
+        memcpy(attribute->getValuePtr(), value.data(), size);
+      }
+    }
+    if (auto *handler = Stack::gattHandler()) {
+      GattWriteCallbackParams params;
+      params.connHandle = connection;
+      params.handle     = handle;
+      params.writeOp    = GattWriteCallbackParams::OP_WRITE_CMD;
+      params.offset     = 0;
+      params.len        = static_cast<uint16_t>(value.size());
+      params.data       = value.data();
+      handler->onDataWritten(params);
+    }
+  });
+}
+
+void OnNotification(std::function<void(const Notification&)> fn)
+{
+  sOnNotification = std::move(fn);
+}
+
+} // namespace sim
+
+using sim::Stack;
+
+/* -------------------------------------------------------------------------- */
+
+BLE& BLE::Instance(InstanceID_t id)
+{
+  static BLE sInstance;
+  return sInstance;
+}
+
+ble_error_t BLE::init(mbed::Callback<void(InitializationCompleteCallbackContext*)> callback)
+{
+  if (initialized_) {
+    return BLE_ERROR_ALREADY_INITIALIZED;
+  }
+  initialized_ = true;
+
+  PostStackEvent([this, callback]() {
+    InitializationCompleteCallbackContext context{ *this, BLE_ERROR_NONE };
+    callback(&context);
+  });
+  return BLE_ERROR_NONE;
+}
+
+void BLE::processEvents()
+{
+  while (!sStackEvents.empty()) {
+    auto fn = std::move(sStackEvents.front());
+    sStackEvents.pop_front();
+    fn();
+  }
+}
+
+void BLE::signalEventsToProcess()
+{
+  if (onEventsToProcess_) {
+    OnEventsToProcessCallbackContext context{ *this };
+    onEventsToProcess_(&context);
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+
+namespace ble {
+
+ble_error_t Gap::setAdvertisingParameters(advertising_handle_t handle, const AdvertisingParameters &params)
+{
+  if (advertising_) {
+    return BLE_ERROR_INVALID_STATE;
+  }
+  params_ = params;
+  return BLE_ERROR_NONE;
+}
+
+ble_error_t Gap::startAdvertising(advertising_handle_t handle, adv_duration_t maxDuration, uint8_t maxEvents)
+{
+  if (advertising_) {
+    return BLE_ERROR_INVALID_STATE;
+  }
+  advertising_ = true;
+
+  if (maxDuration.value()) {
+    advertisingEndId_ = sim::Schedule(maxDuration.valueInUs(), [this, handle]() {
+      advertisingEndId_ = 0;
+      if (!advertising_) {
+        return;
+      }
+      advertising_ = false;
+      const AdvertisingEndEvent event(handle, false);
+      PostStackEvent([this, event]() {
+        if (handler_) {
+          handler_->onAdvertisingEnd(event);
+        }
+      });
+    });
+  }
+
+  // The host connects a while after the device starts advertising.
+  const uint32_t delay = sim::GetConfig().connectDelayMs;
+  if (delay && !sConnectionPending && !sConnection.connected) {
+    sConnectionPending = true;
+    sim::Schedule(delay * 1000uLL, Stack::connect);
+  }
+  return BLE_ERROR_NONE;
+}
+
+ble_error_t Gap::stopAdvertising(advertising_handle_t handle)
+{
+  if (advertisingEndId_) {
+    sim::Cancel(advertisingEndId_);
+    advertisingEndId_ = 0;
+  }
+  advertising_ = false;
+  return BLE_ERROR_NONE;
+}
+
+ble_error_t Gap::setPhy(connection_handle_t handle, const phy_set_t *txPhys, const phy_set_t *rxPhys,
+                        coded_symbol_per_bit_t codedSymbol)
+{
+  phy_t phy = phy_t::LE_1M;
+  if (txPhys && txPhys->get_coded()) {
+    phy = phy_t::LE_CODED;
+  } else if (txPhys && txPhys->get_2m() && sim::GetConfig().phy2M) {
+    phy = phy_t::LE_2M;
+  }
+  PostStackEvent([this, handle, phy]() {
+    if (handler_) {
+      handler_->onPhyUpdateComplete(BLE_ERROR_NONE, handle, phy, phy);
+    }
+  }, 2 * ConnectionInterval());
+  return BLE_ERROR_NONE;
+}
+
+ble_error_t Gap::disconnect(connection_handle_t handle, local_disconnection_reason_t reason)
+{
+  if (!sConnection.connected || (sConnection.handle != handle)) {
+    return BLE_ERROR_INVALID_PARAM;
+  }
+  Stack::disconnect(disconnection_reason_t::LOCAL_HOST_TERMINATED_CONNECTION);
+  return BLE_ERROR_NONE;
+}
+
+/* -------------------------------------------------------------------------- */
+
+ble_error_t SecurityManager::acceptPairingRequest(connection_handle_t handle)
+{
+  const bool bBond = bonding_ && sim::GetConfig().bond;
+  PostStackEvent([this, handle, bBond]() {
+    sBonded = sBonded || bBond;
+    if (handler_) {
+      handler_->pairingResult(handle, SEC_STATUS_SUCCESS);
+      handler_->linkEncryptionResult(handle, link_encryption_t::ENCRYPTED);
+    }
+  }, 2 * ConnectionInterval());
+  return BLE_ERROR_NONE;
+}
+
+ble_error_t SecurityManager::cancelPairingRequest(connection_handle_t handle)
+{
+  PostStackEvent([this, handle]() {
+    if (handler_) {
+      handler_->pairingResult(handle, SEC_STATUS_UNSPECIFIED);
+    }
+  });
+  return BLE_ERROR_NONE;
+}
+
+ble_error_t SecurityManager::generateWhitelistFromBondTable(whitelist_t *whitelist) const
+{
+  whitelist->size = 0;
+  if (sBonded && (whitelist->capacity > 0)) {
+    whitelist->addresses[0].type    = peer_address_type_t::PUBLIC;
+    whitelist->addresses[0].address = HostAddress();
+    whitelist->size = 1;
+  }
+  PostStackEvent([this, whitelist]() {
+    if (handler_) {
+      handler_->whitelistFromBondTable(whitelist);
+    }
+  });
+  return BLE_ERROR_NONE;
+}
+
+ble_error_t SecurityManager::purgeAllBondingState()
+{
+  sBonded = false;
+  return BLE_ERROR_NONE;
+}
+
+} // namespace ble
+
+/* -------------------------------------------------------------------------- */
+
+ble_error_t GattServer::addService(GattService &service)
+{
+  // Handles follow the attributes layout : declaration, value, then descriptors.
+  for (unsigned i = 0; i < service.getCharacteristicCount(); ++i) {
+    GattCharacteristic *characteristic = service.getCharacteristic(i);
+
+    ++nextHandle_;
+    GattAttribute &value = characteristic->getValueAttribute();
+    value.handle_ = nextHandle_++;
+    sAttributeValues[value.handle_]     = &value;
+    sAttributeProperties[value.handle_] = characteristic->getProperties();
+    sAttributes.push_back({
+      value.getUUID().getShortUUID(), value.handle_, characteristic->getProperties(),
+      value.getValuePtr(), value.getLength()
+    });
+
+    for (unsigned j = 0; j < characteristic->getDescriptorCount(); ++j) {
+      GattAttribute *descriptor = characteristic->getDescriptor(j);
+      descriptor->handle_ = nextHandle_++;
+      sAttributeValues[descriptor->handle_] = descriptor;
+      sAttributes.push_back({
+        descriptor->getUUID().getShortUUID(), descriptor->handle_, 0,
+        descriptor->getValuePtr(), descriptor->getLength()
+      });
+    }
+  }
+  return BLE_ERROR_NONE;
+}
+
+ble_error_t GattServer::write(GattAttribute::Handle_t handle, const uint8_t *value, uint16_t size, bool localOnly)
+{
+  return write(sConnection.handle, handle, value, size, localOnly);
+}
+
+ble_error_t GattServer::write(connection_handle_t connection, GattAttribute::Handle_t handle,
+                              const uint8_t *value, uint16_t size, bool localOnly)
+{
+  auto it = sAttributeValues.find(handle);
+  if (it == sAttributeValues.end()) {
+    return BLE_ERROR_INVALID_PARAM;
+  }
+
+  // As with Cordio, the value is copied into the attribute buffer.
+  GattAttribute *attribute = it->second;
+  if (attribute->value_ && (attribute->value_ != value)) {
+    const uint16_t maxLength = attribute->getMaxLength() ? attribute->getMaxLength() : size;
+    memmove(attribute->value_, value, (size < maxLength) ? size : maxLength);
+  }
+  attribute->length_ = size;
+  for (auto &a : sAttributes) {
+    if (a.handle == handle) {
+      a.length = size;
+    }
+  }
+
+  const bool bNotify = sAttributeProperties[handle] & GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY;
+  if (localOnly || !bNotify || !sConnection.connected || (connection != sConnection.handle)) {
+    return BLE_ERROR_NONE;
+  }
+
+  // Notifications wait for the next connection event in the stack buffers.
+  if (sConnection.tx.size() >= static_cast<size_t>(sim::GetConfig().txBuffers)) {
+    return BLE_ERROR_NO_MEM;
+  }
+  sConnection.tx.push_back({ 0, connection, handle, std::vector<uint8_t>(value, value + size) });
+  return BLE_ERROR_NONE;
+}
+
+ble_error_t GattClient::negotiateAttMtu(connection_handle_t connection)
+{
+  const uint16_t mtu = sim::GetConfig().attMtu;
+  PostStackEvent([connection, mtu]() {
+    if (auto *handler = Stack::gattHandler()) {
+      handler->onAttMtuChange(connection, mtu);
+    }
+  }, ConnectionInterval());
+  return BLE_ERROR_NONE;
+}
+
+/* -------------------------------------------------------------------------- */
@@ -0,0 +1,403 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Arduino.h"
+#include "AnalogJoystick.h"
+
+/* -------------------------------------------------------------------------- */
+//
+// Compare the latency and the jitter of the ble_mouse joystick filter with
+// the previous constant damping filter, on recorded or synthetic traces.
+//
+// The traces are fed to AnalogJoystick through the simulated analog inputs,
+// acquired by the simulated SAADC, so the latencies include the acquisition.
+// Each output is compared to a reference, the noise-free input when known
+// (synthetic traces) or a centered moving average of the input otherwise,
+// going through the same calibration and dead zone :
+//
+//  latency : time shift of the reference best matching the output while the
+//            joystick moves, in milliseconds.
+//  jitter  : RMS deviation from the reference while the joystick rests, for
+//            at least 100ms, in thousandths of the full range. For traces
+//            never resting, the deviation while moving from the reference
+//            delayed by the latency.
+//
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+const int kPinX       = A7;
+const int kPinY       = A6;
+const int kPinButton  = 2;
+const int kCenter     = 512;
+
+/* A trace of the X axis, in ADC units. */
+struct Trace {
+  std::string name;
+  std::vector<uint64_t> times;    // in microseconds, from 0.
+  std::vector<float> values;
+  std::vector<float> references;  // noise-free values, when known.
+};
+
+struct Options {
+  std::vector<const char*> traceFilenames;
+  uint32_t periodUs = 7500;       // sampling period of the synthetic traces.
+  float noise       = 2.0f;       // ADC noise of the synthetic traces, in LSB.
+  float minCutoff   = -1.0f;      // One Euro parameters (< 0 : defaults).
+  float beta        = -1.0f;
+  float derivativeCutoff = OneEuroFilter::kDefaultDerivativeCutoff;
+  bool  sweep       = false;
+};
+
+struct Result {
+  float latencyMs;
+  float jitter;
+};
+
+/* -------------------------------------------------------------------------- */
+
+/* Calibration of the joystick during the runs : its full range, around kCenter. */
+AxisCalibration::data_t Calibration()
+{
+  AxisCalibration::data_t data;
+  data.center  = static_cast<float>((kCenter * AdcScanner::kMaxValue + 511) / 1023);
+  data.minimum = 0.0f;
+  data.maximum = static_cast<float>(AdcScanner::kMaxValue);
+  return data;
+}
+
+float Normalize(float adc)
+{
+  AxisCalibration calibration(AdcScanner::kMaxValue);
+  calibration.load(Calibration());
+  return calibration.normalize(adc * AdcScanner::kMaxValue / 1023.0f);
+}
+
+/* Dead zone of AnalogJoystick, on a normalized value. */
+float Shape(float x)
+{
+  const float l = 0.01f;
+  return x * smoothstep(l, 1.0f-l, fabsf(x));
+}
+
+/* Previous AnalogJoystick filter : dead zone then a constant damping. */
+class DampingFilter {
+ public:
+  float filter(float x) {
+    const float damp_factor = 0.96f;
+    last_ = lerp(last_, Shape(x), damp_factor);
+    return last_;
+  }
+
+ private:
+  float last_ = 0.0f;
+};
+
+Trace MakeTrace(const char *name, uint32_t periodUs, float noise, float durationS,
+                float (*signal)(float t))
+{
+  std::mt19937 rng(1);
+  std::normal_distribution<float> gaussian(0.0f, noise);
+  Trace trace;
+  trace.name = name;
+  for (uint64_t t = 0; t < durationS * 1e6f; t += periodUs) {
+    const float clean = signal(t * 1e-6f);
+    trace.times.push_back(t);
+    trace.references.push_back(clean);
+    trace.values.push_back(std::round(std::min(1023.0f, std::max(0.0f, clean + gaussian(rng)))));
+  }
+  return trace;
+}
+
+std::vector<Trace> SyntheticTraces(const Options &options)
+{
+  std::vector<Trace> traces;
+  // Joystick held still at a few positions, 1s each.
+  traces.push_back(MakeTrace("hold", options.periodUs, options.noise, 6.0f, [](float t) {
+    const float kPositions[] = { 0.0f, 40.0f, 150.0f, -60.0f, -300.0f, 480.0f };
+    return kCenter + kPositions[static_cast<int>(t) % 6];
+  }));
+  // Quick pushes to the edge and back, 40ms ramps.
+  traces.push_back(MakeTrace("flick", options.periodUs, options.noise, 6.0f, [](float t) {
+    const float phase = fmodf(t, 1.5f);
+    const float ramp  = 0.04f;
+    const float hold  = 0.3f;
+    const float x = (phase < 0.5f) ? 0.0f
+                  : (phase < 0.5f + ramp) ? (phase - 0.5f) / ramp
+                  : (phase < 0.5f + ramp + hold) ? 1.0f
+                  : (phase < 0.5f + 2 * ramp + hold) ? 1.0f - (phase - 0.5f - ramp - hold) / ramp
+                  : 0.0f;
+    return kCenter + 500.0f * x;
+  }));
+  // Slow to fast oscillations, from 0.25Hz to 3Hz.
+  traces.push_back(MakeTrace("sweep", options.periodUs, options.noise, 8.0f, [](float t) {
+    const float f0 = 0.25f, f1 = 3.0f, duration = 8.0f;
+    const float phase = 2.0f * PI * (f0 * t + 0.5f * (f1 - f0) * t * t / duration);
+    return kCenter + 300.0f * sinf(phase);
+  }));
+  return traces;
+}
+
+/* Read a trace recorded as "time in microseconds,ADC value" lines. */
+bool LoadTrace(const char *filename, Trace *trace)
+{
+  FILE *fd = fopen(filename, "r");
+  if (!fd) {
+    return false;
+  }
+  trace->name = filename;
+  char line[128];
+  uint64_t firstTime = 0;
+  while (fgets(line, sizeof(line), fd)) {
+    unsigned long long time;
+    float value;
+    if (sscanf(line, "%llu,%f", &time, &value) != 2) {
+      continue; // header.
+    }
+    firstTime = trace->times.empty() ? time : firstTime;
+    trace->times.push_back(time - firstTime);
+    trace->values.push_back(value);
+  }
+  fclose(fd);
+
+  // Reference : centered moving average over 5 samples.
+  const int n = static_cast<int>(trace->values.size());
+  for (int i = 0; i < n; ++i) {
+    float sum = 0.0f;
+    int count = 0;
+    for (int j = std::max(0, i - 2); j <= std::min(n - 1, i + 2); ++j) {
+      sum += trace->values[j];
+      ++count;
+    }
+    trace->references.push_back(sum / count);
+  }
+  return n > 1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+Result Evaluate(const Trace &trace, const std::vector<float> &outputs)
+{
+  const int n = static_cast<int>(outputs.size());
+  std::vector<float> references(n);
+  for (int i = 0; i < n; ++i) {
+    references[i] = Shape(Normalize(trace.references[i]));
+  }
+
+  // Resting samples : the reference has not moved for the last 100ms.
+  std::vector<bool> resting(n, false);
+  uint64_t lastMotion = 0;
+  for (int i = 1; i < n; ++i) {
+    if (fabsf(references[i] - references[i - 1]) > 1e-4f) {
+      lastMotion = trace.times[i];
+    }
+    resting[i] = (trace.times[i] >= lastMotion + 100000);
+  }
+
+  // Moving samples : the reference moved in the last or the next 100ms, so a
+  // step is seen from both sides.
+  std::vector<bool> moving(n, false);
+  uint64_t nextMotion = UINT64_MAX - 100000;
+  for (int i = n - 1; i >= 0; --i) {
+    if ((i + 1 < n) && (fabsf(references[i + 1] - references[i]) > 1e-4f)) {
+      nextMotion = trace.times[i + 1];
+    }
+    moving[i] = !resting[i] || (trace.times[i] + 100000 > nextMotion);
+  }
+
+  // Shift, in samples, minimizing the error while moving. A negative shift is
+  // searched too, for the sub-sample minimum of the filters without lag.
+  const float period = float(trace.times.back() - trace.times.front()) / (n - 1);
+  const int maxShift = static_cast<int>(200000 / period);
+  std::vector<double> errors(maxShift + 2, 0.0);   // (shifts from -1)
+  int numMoving = 0;
+  int best = 0;
+  for (int k = 0; k <= maxShift + 1; ++k) {
+    numMoving = 0;
+    for (int i = maxShift; i < n - 1; ++i) {
+      if (moving[i]) {
+        const float reference = references[i - (k - 1)];
+        errors[k] += (outputs[i] - reference) * (outputs[i] - reference);
+        ++numMoving;
+      }
+    }
+    best = (errors[k] < errors[best]) ? k : best;
+  }
+  // (sub-sample minimum, from a parabola through its neighbours)
+  float shift = best - 1;
+  if ((best > 0) && (best < maxShift + 1)) {
+    const double e0 = errors[best - 1], e1 = errors[best], e2 = errors[best + 1];
+    const double curvature = e0 - 2.0 * e1 + e2;
+    shift += (curvature > 0.0) ? 0.5 * (e0 - e2) / curvature : 0.0;
+  }
+
+  // Jitter at rest or, for the traces never resting, around the reference
+  // delayed by the latency (interpolated).
+  const int numResting = std::count(resting.begin(), resting.end(), true);
+  double jitter = 0.0;
+  int numJitter = 0;
+  for (int i = 0; i < n; ++i) {
+    if (numResting ? resting[i] : (moving[i] && (i > maxShift) && (i < n - 1))) {
+      const int j = i - static_cast<int>(floorf(shift));
+      const float t = shift - floorf(shift);
+      const float reference = numResting ? references[i] : lerp(references[j], references[j - 1], t);
+      jitter += (outputs[i] - reference) * (outputs[i] - reference);
+      ++numJitter;
+    }
+  }
+
+  Result result;
+  result.latencyMs = numMoving ? shift * period / 1000.0f : NAN;
+  result.jitter    = numJitter ? 1000.0f * sqrtf(jitter / numJitter) : NAN;
+  return result;
+}
+
+/* Run the trace through AnalogJoystick, on the simulated clock. */
+std::vector<float> RunJoystick(const Trace &trace, float minCutoff, float beta, float derivativeCutoff)
+{
+  sim::SetAnalogInput(kPinX, kCenter);
+  sim::SetAnalogInput(kPinY, kCenter);
+  AnalogJoystick joystick(kPinX, kPinY, kPinButton);
+  joystick.initialize();
+  if (minCutoff >= 0.0f) {
+    joystick.setFilterParameters(minCutoff, beta, derivativeCutoff);
+  }
+
+  joystick.setCalibration(Calibration(), Calibration());
+
+  // Each value is held around its time, as the samples of a continuous input,
+  // the scanner acquiring it in the meantime.
+  std::vector<float> outputs;
+  const uint64_t start = sim::Now();
+  for (size_t i = 0; i < trace.values.size(); ++i) {
+    const uint64_t hold = (i > 0) ? (trace.times[i] - trace.times[i - 1]) / 2 : 0;
+    sim::RunUntil(start + trace.times[i] - hold);
+    sim::SetAnalogInput(kPinX, static_cast<int>(trace.values[i]));
+    sim::RunUntil(start + trace.times[i]);
+    joystick.update();
+    outputs.push_back(joystick.x());
+  }
+  return outputs;
+}
+
+std::vector<float> RunDamping(const Trace &trace)
+{
+  DampingFilter filter;
+  std::vector<float> outputs;
+  for (float value : trace.values) {
+    outputs.push_back(filter.filter(Normalize(value)));
+  }
+  return outputs;
+}
+
+void PrintUsage(const char *name)
+{
+  fprintf(stderr,
+    "usage: %s [options] [trace.csv ..]\n"
+    "  --period US          sampling period of the synthetic traces (default 7500)\n"
+    "  --noise LSB          ADC noise of the synthetic traces (default 2)\n"
+    "  --min-cutoff HZ      One Euro minimum cutoff\n"
+    "  --beta B             One Euro speed coefficient\n"
+    "  --d-cutoff HZ        One Euro speed cutoff, with --min-cutoff (default 1)\n"
+    "  --sweep              print the results over a grid of One Euro parameters\n"
+    "Traces are CSV lines \"time in microseconds,ADC value\", synthetic ones are used without.\n",
+    name
+  );
+}
+
+bool ParseArgs(int argc, char *argv[], Options *options)
+{
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+    if (!strcmp(arg, "--sweep")) {
+      options->sweep = true;
+      continue;
+    }
+    if (strncmp(arg, "--", 2)) {
+      options->traceFilenames.push_back(arg);
+      continue;
+    }
+    if (!value) {
+      return false;
+    }
+    ++i;
+    if (!strcmp(arg, "--period")) {
+      options->periodUs = atoi(value);
+    } else if (!strcmp(arg, "--noise")) {
+      options->noise = atof(value);
+    } else if (!strcmp(arg, "--min-cutoff")) {
+      options->minCutoff = atof(value);
+    } else if (!strcmp(arg, "--beta")) {
+      options->beta = atof(value);
+    } else if (!strcmp(arg, "--d-cutoff")) {
+      options->derivativeCutoff = atof(value);
+    } else {
+      return false;
+    }
+  }
+  return (options->periodUs > 0) && ((options->minCutoff < 0.0f) == (options->beta < 0.0f))
+      && (options->derivativeCutoff > 0.0f);
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+void setup() {}
+void loop() {}
+
+int main(int argc, char *argv[])
+{
+  Options options;
+  if (!ParseArgs(argc, argv, &options)) {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<Trace> traces;
+  for (const char *filename : options.traceFilenames) {
+    Trace trace;
+    if (!LoadTrace(filename, &trace)) {
+      fprintf(stderr, "could not read %s\n", filename);
+      return EXIT_FAILURE;
+    }
+    traces.push_back(std::move(trace));
+  }
+  if (traces.empty()) {
+    traces = SyntheticTraces(options);
+  }
+
+  if (options.sweep) {
+    printf("%-10s %6s %6s %6s %12s %10s\n", "trace", "fcmin", "beta", "dcut", "latency(ms)", "jitter");
+    for (const auto &trace : traces) {
+      for (float minCutoff : { 0.5f, 1.0f, 2.0f, 5.0f }) {
+        for (float beta : { 0.0f, 2.0f, 8.0f, 32.0f, 64.0f, 128.0f }) {
+          for (float derivativeCutoff : { 1.0f, 8.0f, 32.0f }) {
+            const Result r = Evaluate(trace, RunJoystick(trace, minCutoff, beta, derivativeCutoff));
+            printf("%-10s %6.1f %6.1f %6.1f %12.1f %10.2f\n", trace.name.c_str(),
+                   minCutoff, beta, derivativeCutoff, r.latencyMs, r.jitter);
+          }
+        }
+      }
+    }
+    return EXIT_SUCCESS;
+  }
+
+  printf("%-10s %-10s %12s %10s\n", "trace", "filter", "latency(ms)", "jitter");
+  for (const auto &trace : traces) {
+    const Result damping  = Evaluate(trace, RunDamping(trace));
+    const Result oneEuro  = Evaluate(trace, RunJoystick(trace, options.minCutoff, options.beta, options.derivativeCutoff));
+    printf("%-10s %-10s %12.1f %10.2f\n", trace.name.c_str(), "damping", damping.latencyMs, damping.jitter);
+    printf("%-10s %-10s %12.1f %10.2f\n", trace.name.c_str(), "one-euro", oneEuro.latencyMs, oneEuro.jitter);
+  }
+  return EXIT_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
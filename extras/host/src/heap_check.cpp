@@ -0,0 +1,254 @@
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Arduino.h"
+#include "sim/simulator.h"
+
+/* -------------------------------------------------------------------------- */
+//
+// Run a sketch on the simulated timeline and check that the library never
+// allocates on the heap, from setup to the end of the run.
+//
+// Every malloc call is recorded with its call stack. Each stack is then
+// attributed, through the debug information, to the innermost frame outside
+// the standard library : allocations made by the library sources (src/) fail
+// the check, those of the simulation stand-ins and of the sketch are only
+// counted.
+//
+// Exits with 1 when the library allocates.
+//
+/* -------------------------------------------------------------------------- */
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+namespace {
+
+constexpr int kMaxFrames = 24;
+constexpr int kMaxTraces = 1 << 12;   // Power of two.
+
+struct Trace {
+  void *frames[kMaxFrames];
+  int numFrames;
+  unsigned count;
+};
+
+// Distinct call stacks, hashed by their frames.
+Trace sTraces[kMaxTraces];
+unsigned sNumTraces   = 0;
+unsigned sNumDropped  = 0;
+bool sRecording       = false;
+thread_local bool tInHook = false;
+
+uint64_t Hash(void *const *frames, int numFrames)
+{
+  uint64_t hash = 1469598103934665603uLL;
+  for (int i = 0; i < numFrames; ++i) {
+    hash = (hash ^ reinterpret_cast<uintptr_t>(frames[i])) * 1099511628211uLL;
+  }
+  return hash;
+}
+
+void Record()
+{
+  if (!sRecording || tInHook) {
+    return;
+  }
+  tInHook = true;
+  void *frames[kMaxFrames];
+  const int numFrames = backtrace(frames, kMaxFrames);
+  for (uint64_t i = Hash(frames, numFrames), probe = 0; probe < kMaxTraces; ++i, ++probe) {
+    Trace &trace = sTraces[i & (kMaxTraces - 1)];
+    if (trace.count == 0) {
+      memcpy(trace.frames, frames, numFrames * sizeof(void*));
+      trace.numFrames = numFrames;
+      trace.count = 1;
+      ++sNumTraces;
+      break;
+    }
+    if ((trace.numFrames == numFrames) && !memcmp(trace.frames, frames, numFrames * sizeof(void*))) {
+      ++trace.count;
+      break;
+    }
+    sNumDropped += (probe + 1 == kMaxTraces) ? 1 : 0;
+  }
+  tInHook = false;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* Source location of a frame, innermost inlined function first. */
+struct Location {
+  std::string function;
+  std::string file;
+};
+
+// Functions of this file, used to locate the executable.
+void Anchor() {}
+
+/* Locations of @p addresses in the executable, resolved with addr2line. */
+std::vector<std::vector<Location>> Resolve(const std::vector<void*> &addresses)
+{
+  Dl_info anchor;
+  dladdr(reinterpret_cast<void*>(&Anchor), &anchor);
+
+  char path[] = "/tmp/heap_check_XXXXXX";
+  const int fd = mkstemp(path);
+  FILE *file = fdopen(fd, "w");
+  for (void *address : addresses) {
+    // Return addresses point after the call, and are relative to the load base.
+    Dl_info info;
+    const bool local = dladdr(address, &info) && (info.dli_fbase == anchor.dli_fbase);
+    const uintptr_t offset = local ? reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(anchor.dli_fbase) - 1 : 0;
+    fprintf(file, "0x%zx\n", static_cast<size_t>(offset));
+  }
+  fclose(file);
+
+  const std::string command = std::string("addr2line -a -C -f -i -e /proc/")
+                            + std::to_string(getpid()) + "/exe < " + path;
+  std::vector<std::vector<Location>> locations;
+  FILE *pipe = popen(command.c_str(), "r");
+  char line[4096];
+  while (pipe && fgets(line, sizeof(line), pipe)) {
+    line[strcspn(line, "\n")] = '\0';
+    if (!strncmp(line, "0x", 2)) {
+      locations.emplace_back();
+      continue;
+    }
+    if (locations.empty()) {
+      continue;
+    }
+    Location location;
+    location.function = line;
+    if (fgets(line, sizeof(line), pipe)) {
+      line[strcspn(line, ":\n")] = '\0';
+      location.file = line;
+    }
+    locations.back().push_back(location);
+  }
+  if (pipe) {
+    pclose(pipe);
+  }
+  unlink(path);
+  locations.resize(addresses.size());
+  return locations;
+}
+
+/* Is @p file one of the library sources ? */
+bool IsLibrary(const std::string &file)
+{
+  const std::string marker = "../../src/";
+  return (file.find(marker) != std::string::npos) || (file.find(LIBRARY_SOURCE_DIR "/") == 0);
+}
+
+/* Is @p location in the standard library, or unknown ? */
+bool IsSystem(const Location &location)
+{
+  // Out-of-line template instances may carry the line of their user, so their
+  // name is checked too (without template arguments).
+  const std::string name = location.function.substr(0, location.function.find_first_of("<("));
+  return location.file.empty() || (location.file[0] == '?')
+      || (location.file.compare(0, 5, "/usr/") == 0)
+      || (name.find("std::") != std::string::npos);
+}
+
+/* Innermost location of @p trace outside the standard library and this file. */
+const Location* Owner(const Trace &trace, const std::vector<std::vector<Location>> &locations, unsigned first)
+{
+  for (int i = 0; i < trace.numFrames; ++i) {
+    for (const auto &location : locations[first + i]) {
+      if (!IsSystem(location) && (location.file.find("heap_check.cpp") == std::string::npos)) {
+        return &location;
+      }
+    }
+  }
+  return nullptr;
+}
+
+/* Run the Arduino loop every millisecond, for sketches without event thread. */
+void LoopTask()
+{
+  loop();
+  sim::Schedule(1000, LoopTask);
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+extern "C" void *malloc(size_t size)
+{
+  void *ptr = __libc_malloc(size);
+  Record();
+  return ptr;
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+  void *ptr = __libc_calloc(count, size);
+  Record();
+  return ptr;
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+  void *result = __libc_realloc(ptr, size);
+  Record();
+  return result;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+  // Load the unwinder before recording, it allocates on first use.
+  void *frames[1];
+  backtrace(frames, 1);
+
+  sRecording = true;
+  setup();
+  if (sim::Now() < sim::GetConfig().durationMs * 1000uLL) {
+    sim::Schedule(0, LoopTask);
+    sim::Run();
+  }
+  sRecording = false;
+
+  std::vector<void*> addresses;
+  std::vector<const Trace*> traces;
+  for (const auto &trace : sTraces) {
+    if (trace.count > 0) {
+      traces.push_back(&trace);
+      addresses.insert(addresses.end(), trace.frames, trace.frames + trace.numFrames);
+    }
+  }
+  const auto locations = Resolve(addresses);
+
+  unsigned numAllocations = 0;
+  unsigned numLibrary = 0;
+  unsigned first = 0;
+  for (const Trace *trace : traces) {
+    numAllocations += trace->count;
+    const Location *owner = Owner(*trace, locations, first);
+    if (owner && IsLibrary(owner->file)) {
+      numLibrary += trace->count;
+      printf("  %6u x %s (%s)\n", trace->count, owner->function.c_str(), owner->file.c_str());
+    }
+    first += trace->numFrames;
+  }
+
+  const bool ok = (numLibrary == 0) && (sNumDropped == 0);
+  printf("%-9s %s  %u allocations from the library, %u from the simulation and the sketch (%u call stacks)\n",
+         "heap", ok ? "ok  " : "FAIL", numLibrary, numAllocations - numLibrary, sNumTraces);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* -------------------------------------------------------------------------- */
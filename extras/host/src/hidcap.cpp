@@ -0,0 +1,211 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "report_capture.h"
+#include "uhid.h"
+
+/* -------------------------------------------------------------------------- */
+//
+// Read the report captures written by ReportRecorder::dump(), and replay them
+// through /dev/uhid from the report maps they carry.
+//
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+/* Time waited for the evdev events of a report when measuring the latency. */
+const int kEvdevTimeoutMs = 5;
+
+bool ReadFile(const char *filename, std::vector<uint8_t> &data)
+{
+  FILE *fd = fopen(filename, "rb");
+  if (!fd) {
+    fprintf(stderr, "could not read %s : %s\n", filename, strerror(errno));
+    return false;
+  }
+  uint8_t buffer[4096];
+  size_t bytes;
+  while ((bytes = fread(buffer, 1, sizeof(buffer), fd)) > 0) {
+    data.insert(data.end(), buffer, buffer + bytes);
+  }
+  fclose(fd);
+  return true;
+}
+
+int Info(ReportCaptureReader &reader)
+{
+  printf("base timestamp  %lu us\n", static_cast<unsigned long>(reader.baseTimestamp()));
+  printf("dropped records %lu\n", static_cast<unsigned long>(reader.dropped()));
+  for (int i = 0; i < reader.numReportMaps(); ++i) {
+    printf("report map %d    %u bytes, input report ID %u\n", i, reader.reportMapLength(i), reader.reportID(i));
+  }
+
+  std::vector<unsigned> counts(reader.numReportMaps(), 0);
+  ReportCaptureReader::record_t record;
+  uint32_t first = 0, last = 0;
+  unsigned total = 0;
+  while (reader.next(record)) {
+    first = (total == 0) ? record.timestamp : first;
+    last  = record.timestamp;
+    if (record.reportMap < counts.size()) {
+      ++counts[record.reportMap];
+    }
+    ++total;
+  }
+
+  const double seconds = (last - first) / 1e6;
+  printf("records         %u over %.3f s\n", total, seconds);
+  for (size_t i = 0; i < counts.size(); ++i) {
+    printf("  report map %u  %u records (%.1f Hz)\n", static_cast<unsigned>(i), counts[i],
+           (seconds > 0.0) ? counts[i] / seconds : 0.0);
+  }
+  return EXIT_SUCCESS;
+}
+
+int WriteCSV(ReportCaptureReader &reader)
+{
+  printf("timestamp_us,report_map,data\n");
+  ReportCaptureReader::record_t record;
+  while (reader.next(record)) {
+    printf("%lu,%u,", static_cast<unsigned long>(record.timestamp), record.reportMap);
+    for (int i = 0; i < record.length; ++i) {
+      printf("%02x", record.data[i]);
+    }
+    printf("\n");
+  }
+  return EXIT_SUCCESS;
+}
+
+int Replay(ReportCaptureReader &reader, const std::string &name, bool latency)
+{
+  std::vector<int> devices;
+  std::vector<std::vector<int>> evdevs;
+  for (int i = 0; i < reader.numReportMaps(); ++i) {
+    const int fd = uhid::Create(name + ((i > 0) ? " " + std::to_string(i) : ""), i,
+                                reader.reportMap(i), reader.reportMapLength(i));
+    if (fd < 0) {
+      for (int device : devices) {
+        uhid::Destroy(device);
+      }
+      return EXIT_FAILURE;
+    }
+    devices.push_back(fd);
+  }
+
+  if (latency) {
+    // (let the kernel create the input devices)
+    usleep(500000);
+    for (size_t i = 0; i < devices.size(); ++i) {
+      evdevs.push_back(uhid::OpenInputDevices(i));
+    }
+  }
+
+  uhid::LatencyStats stats;
+  ReportCaptureReader::record_t record;
+  const uint64_t wallStart = uhid::MonotonicTime();
+  unsigned count = 0;
+
+  while (reader.next(record)) {
+    if (record.reportMap >= devices.size()) {
+      continue;
+    }
+    const uint64_t wallTime = wallStart + (record.timestamp - reader.baseTimestamp());
+    const uint64_t now = uhid::MonotonicTime();
+    if (wallTime > now) {
+      usleep(static_cast<useconds_t>(wallTime - now));
+    }
+
+    // Nothing answers the kernel requests.
+    for (int fd : devices) {
+      uhid_event ev;
+      while (uhid::ReadEvent(fd, ev)) {
+        uhid::RejectRequest(fd, ev);
+      }
+    }
+
+    const int fd = devices[record.reportMap];
+    if (latency) {
+      uhid::FlushInputEvents(evdevs[record.reportMap]);
+    }
+    const uint64_t t = uhid::MonotonicTime();
+    if (!uhid::Input(fd, reader.reportID(record.reportMap), record.data, record.length)) {
+      fprintf(stderr, "could not inject a report : %s\n", strerror(errno));
+      break;
+    }
+    if (latency && !evdevs[record.reportMap].empty()) {
+      const uint64_t eventTime = uhid::WaitInputEvents(evdevs[record.reportMap], kEvdevTimeoutMs);
+      if (eventTime >= t) {
+        stats.add(static_cast<uint32_t>(eventTime - t));
+      } else {
+        stats.miss();
+      }
+    }
+    ++count;
+  }
+  fprintf(stderr, "replayed %u reports\n", count);
+  if (latency) {
+    stats.print();
+  }
+
+  for (size_t i = 0; i < devices.size(); ++i) {
+    for (int evdev : (i < evdevs.size()) ? evdevs[i] : std::vector<int>()) {
+      close(evdev);
+    }
+    uhid::Destroy(devices[i]);
+  }
+  return EXIT_SUCCESS;
+}
+
+void PrintUsage(const char *name)
+{
+  fprintf(stderr,
+    "usage: %s info FILE                  summary of a report capture\n"
+    "       %s csv FILE                   print the records as CSV\n"
+    "       %s replay FILE [--no-latency] inject the records through /dev/uhid\n",
+    name, name, name
+  );
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+  if (argc < 3) {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  const std::string command = argv[1];
+
+  std::vector<uint8_t> data;
+  if (!ReadFile(argv[2], data)) {
+    return EXIT_FAILURE;
+  }
+  ReportCaptureReader reader(data.data(), data.size());
+  if (!reader.valid()) {
+    fprintf(stderr, "%s is not a valid report capture\n", argv[2]);
+    return EXIT_FAILURE;
+  }
+
+  if (command == "info") {
+    return Info(reader);
+  }
+  if (command == "csv") {
+    return WriteCSV(reader);
+  }
+  if (command == "replay") {
+    const bool latency = !((argc > 3) && !strcmp(argv[3], "--no-latency"));
+    return Replay(reader, "hidcap", latency);
+  }
+  PrintUsage(argv[0]);
+  return EXIT_FAILURE;
+}
+
+/* -------------------------------------------------------------------------- */
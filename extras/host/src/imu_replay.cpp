@@ -0,0 +1,411 @@
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "Arduino.h"
+#include "LSM9DS1Fifo.h"
+#include "air_mouse.h"
+#include "sim/simulator.h"
+
+/* -------------------------------------------------------------------------- */
+//
+// Run the air mouse pipeline on IMU streams, recorded or synthetic.
+//
+//  --replay FILE : replay a stream recorded by ble_air_mouse with
+//                  AIR_MOUSE_RECORD_SERIAL (one "ax,ay,az,gx,gy,gz" line of raw
+//                  samples each), writing the pointer and the estimated
+//                  vertical of each sample as CSV on stdout.
+//  --write FILE  : write the synthetic yaw stream in the same format.
+//
+// Without options, check the pipeline against the ground truth of synthetic
+// streams, made with the sensitivities of the example and a gyro bias :
+//
+//  bias   : gyro bias estimated while still, and no motion of the pointer.
+//  tilt   : vertical estimated at rest, for several orientations.
+//  yaw    : pointer moved by a rotation around the vertical, for several
+//           rolls of the device (the vertical staying still).
+//  pitch  : pointer moved by a rotation around the horizontal axis.
+//  replay : a stream written and replayed, giving the same motion.
+//  fifo   : samples read by bursts from the simulated IMU.
+//
+// Exits with 1 when a check fails.
+//
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+constexpr float kSampleRate  = LSM9DS1Fifo::kSampleRate;
+constexpr float kGyroLsb     = LSM9DS1Fifo::kGyroSensitivity;
+constexpr float kAccelLsb    = LSM9DS1Fifo::kAccelSensitivity;
+constexpr float kDegToRad    = 3.14159265f / 180.0f;
+
+const float kGyroBias[3]     = { 0.8f, -0.5f, 0.3f };   // in dps.
+constexpr float kGyroNoise   = 0.1f;                    // in dps.
+constexpr float kAccelNoise  = 0.002f;                  // in g.
+
+constexpr float kBiasTolerance    = 0.05f;    // in dps.
+constexpr float kTiltTolerance    = 0.5f;     // in degrees.
+constexpr float kMotionTolerance  = 0.03f;    // relative to the expected counts.
+constexpr float kCrossTolerance   = 0.02f;    // relative to the expected counts.
+
+/* -------------------------------------------------------------------------- */
+
+struct Quat {
+  float w, x, y, z;
+};
+
+Quat Multiply(const Quat &a, const Quat &b)
+{
+  return {
+    a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+    a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+    a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+    a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+  };
+}
+
+Quat AxisAngle(const float axis[3], float angle)
+{
+  const float s = sinf(0.5f * angle);
+  return { cosf(0.5f * angle), s * axis[0], s * axis[1], s * axis[2] };
+}
+
+/* Rotate the earth vector @p v to the sensor frame of the orientation @p q. */
+void ToSensor(const Quat &q, const float v[3], float out[3])
+{
+  const Quat conj = { q.w, -q.x, -q.y, -q.z };
+  const Quat r = Multiply(Multiply(conj, { 0.0f, v[0], v[1], v[2] }), q);
+  out[0] = r.x;
+  out[1] = r.y;
+  out[2] = r.z;
+}
+
+/* Orientation rolled around the pointing axis, then pitched, in degrees. */
+Quat Orientation(float roll, float pitch)
+{
+  const float x[3] = { 1.0f, 0.0f, 0.0f };
+  const float y[3] = { 0.0f, 1.0f, 0.0f };
+  return Multiply(AxisAngle(y, -pitch * kDegToRad), AxisAngle(x, roll * kDegToRad));
+}
+
+/* A synthetic stream, with the true vertical of each sample. */
+struct Stream {
+  std::vector<AirMouse::sample_t> samples;
+  std::vector<float> up;    // 3 per sample.
+};
+
+/**
+ * Hold @p base still for @p restTime seconds, then rotate it by @p angle
+ * degrees around the earth @p axis with a raised cosine profile over
+ * @p duration seconds, then hold it still for @p restTime again.
+ */
+Stream MakeStream(const Quat &base, const float axis[3], float angle, float duration, float restTime, uint32_t seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+  const float earthUp[3] = { 0.0f, 0.0f, 1.0f };
+
+  Stream stream;
+  const int numSamples = static_cast<int>((2.0f * restTime + duration) * kSampleRate);
+  for (int i = 0; i < numSamples; ++i) {
+    const float t = i / kSampleRate - restTime;
+    const float u = (t <= 0.0f) ? 0.0f : (t >= duration) ? 1.0f : t / duration;
+    const float theta = angle * kDegToRad * 0.5f * (1.0f - cosf(3.14159265f * u));
+    const float rate  = ((u > 0.0f) && (u < 1.0f)) ? angle * 0.5f * 3.14159265f / duration * sinf(3.14159265f * u) : 0.0f;
+
+    const Quat q = Multiply(AxisAngle(axis, theta), base);
+    const float earthRate[3] = { rate * axis[0], rate * axis[1], rate * axis[2] };
+    float gyro[3], accel[3];
+    ToSensor(q, earthRate, gyro);
+    ToSensor(q, earthUp, accel);
+
+    AirMouse::sample_t sample;
+    for (int j = 0; j < 3; ++j) {
+      sample.gyro[j]  = static_cast<int16_t>(lroundf((gyro[j] + kGyroBias[j] + kGyroNoise * noise(rng)) / kGyroLsb));
+      sample.accel[j] = static_cast<int16_t>(lroundf((accel[j] + kAccelNoise * noise(rng)) / kAccelLsb));
+      stream.up.push_back(accel[j]);
+    }
+    stream.samples.push_back(sample);
+  }
+  return stream;
+}
+
+/** Pointer motion of a run, and the largest error of the estimated vertical. */
+struct Result {
+  long dx = 0;
+  long dy = 0;
+  float maxTiltError = 0.0f;    // in degrees, once ready.
+  float bias[3] = {};           // in dps.
+};
+
+Result Run(const Stream &stream, std::ostream *csv = nullptr)
+{
+  AirMouse airMouse(kSampleRate, kGyroLsb, kAccelLsb);
+  Result result;
+  for (size_t i = 0; i < stream.samples.size(); ++i) {
+    airMouse.update(stream.samples[i]);
+    int dx, dy;
+    airMouse.takeMotion(&dx, &dy);
+    result.dx += dx;
+    result.dy += dy;
+
+    Q30 up[3];
+    airMouse.fusion().up(up);
+    if (airMouse.ready() && (3 * i + 2 < stream.up.size())) {
+      const float *truth = &stream.up[3 * i];
+      const float dot = up[0].toFloat() * truth[0] + up[1].toFloat() * truth[1] + up[2].toFloat() * truth[2];
+      const float error = acosf((dot > 1.0f) ? 1.0f : dot) / kDegToRad;
+      result.maxTiltError = (error > result.maxTiltError) ? error : result.maxTiltError;
+    }
+    if (csv) {
+      *csv << i << "," << result.dx << "," << result.dy << ","
+           << up[0].toFloat() << "," << up[1].toFloat() << "," << up[2].toFloat() << "\n";
+    }
+  }
+  for (int i = 0; i < 3; ++i) {
+    result.bias[i] = airMouse.bias().bias(i) * kGyroLsb / (1 << GyroBiasEstimator::kFracBits);
+  }
+  return result;
+}
+
+void WriteStream(const Stream &stream, std::ostream &out)
+{
+  for (const auto &s : stream.samples) {
+    out << s.accel[0] << "," << s.accel[1] << "," << s.accel[2] << ","
+        << s.gyro[0] << "," << s.gyro[1] << "," << s.gyro[2] << "\n";
+  }
+}
+
+bool ReadStream(std::istream &in, Stream *stream)
+{
+  std::string line;
+  while (std::getline(in, line)) {
+    int v[6];
+    if (sscanf(line.c_str(), "%d,%d,%d,%d,%d,%d", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 6) {
+      continue;
+    }
+    AirMouse::sample_t sample;
+    for (int i = 0; i < 3; ++i) {
+      sample.accel[i] = static_cast<int16_t>(v[i]);
+      sample.gyro[i]  = static_cast<int16_t>(v[3 + i]);
+    }
+    stream->samples.push_back(sample);
+  }
+  return !stream->samples.empty();
+}
+
+/* Yaw of 30 degrees to the right, rolled by 45 degrees. */
+Stream YawStream()
+{
+  const float vertical[3] = { 0.0f, 0.0f, -1.0f };
+  return MakeStream(Orientation(45.0f, 10.0f), vertical, 30.0f, 0.5f, 1.5f, 1);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool Report(const char *name, bool ok, const char *format, ...)
+{
+  printf("%-8s %s  ", name, ok ? "ok  " : "FAIL");
+  va_list args;
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+  printf("\n");
+  return ok;
+}
+
+bool CheckBias()
+{
+  const float axis[3] = { 0.0f, 0.0f, 1.0f };
+  const Stream stream = MakeStream(Orientation(0.0f, 0.0f), axis, 0.0f, 0.0f, 1.5f, 2);
+  const Result result = Run(stream);
+
+  float maxError = 0.0f;
+  for (int i = 0; i < 3; ++i) {
+    maxError = fmaxf(maxError, fabsf(result.bias[i] - kGyroBias[i]));
+  }
+  const bool ok = (maxError < kBiasTolerance) && (result.dx == 0) && (result.dy == 0);
+  return Report("bias", ok, "bias (%.3f %.3f %.3f) dps, error %.3f dps, motion (%ld, %ld)",
+                result.bias[0], result.bias[1], result.bias[2], maxError, result.dx, result.dy);
+}
+
+bool CheckTilt()
+{
+  const float orientations[][2] = { {0, 0}, {30, 0}, {0, 30}, {60, -20}, {90, 0}, {-45, 40}, {180, 15} };
+  const float axis[3] = { 0.0f, 0.0f, 1.0f };
+
+  bool ok = true;
+  for (const auto &o : orientations) {
+    const Stream stream = MakeStream(Orientation(o[0], o[1]), axis, 0.0f, 0.0f, 1.0f, 3);
+    const Result result = Run(stream);
+    ok &= Report("tilt", result.maxTiltError < kTiltTolerance, "roll %4.0f pitch %4.0f : error %.3f deg",
+                 o[0], o[1], result.maxTiltError);
+  }
+  return ok;
+}
+
+/* Check a rotation of @p angle degrees around @p axis, expected to move the pointer by (ex, ey). */
+bool CheckMotion(const char *name, const Quat &base, const float axis[3], float angle, float ex, float ey, const char *label)
+{
+  const Stream stream = MakeStream(base, axis, angle, 0.5f, 1.5f, 4);
+  const Result result = Run(stream);
+
+  const float expected = fmaxf(fabsf(ex), fabsf(ey));
+  const float error = fmaxf(fabsf(result.dx - ex), fabsf(result.dy - ey));
+  const float cross = (fabsf(ex) > fabsf(ey)) ? fabsf(result.dy - ey) : fabsf(result.dx - ex);
+  const bool ok = (error <= kMotionTolerance * expected)
+               && (cross <= kCrossTolerance * expected)
+               && (result.maxTiltError < kTiltTolerance);
+  return Report(name, ok, "%s : motion (%ld, %ld) for (%.0f, %.0f), tilt error %.3f deg",
+                label, result.dx, result.dy, ex, ey, result.maxTiltError);
+}
+
+bool CheckYaw()
+{
+  // To the right : clockwise seen from above.
+  const float vertical[3] = { 0.0f, 0.0f, -1.0f };
+  const float expected = 30.0f * AirMouse::kDefaultGain;
+  const float rolls[] = { 0.0f, 45.0f, 90.0f, -60.0f, 180.0f };
+
+  bool ok = true;
+  for (float roll : rolls) {
+    char label[32];
+    snprintf(label, sizeof(label), "roll %4.0f", roll);
+    ok &= CheckMotion("yaw", Orientation(roll, 10.0f), vertical, 30.0f, expected, 0.0f, label);
+  }
+  return ok;
+}
+
+bool CheckPitch()
+{
+  // Upward, around the earth axis on the right of the pointing direction : -y.
+  const float right[3] = { 0.0f, -1.0f, 0.0f };
+  const float expected = 20.0f * AirMouse::kDefaultGain;
+  const float rolls[] = { 0.0f, 60.0f, -90.0f };
+
+  bool ok = true;
+  for (float roll : rolls) {
+    char label[32];
+    snprintf(label, sizeof(label), "roll %4.0f", roll);
+    ok &= CheckMotion("pitch", Orientation(roll, -10.0f), right, 20.0f, 0.0f, -expected, label);
+  }
+  return ok;
+}
+
+bool CheckReplay()
+{
+  const Stream stream = YawStream();
+  std::stringstream csv;
+  WriteStream(stream, csv);
+  Stream replayed;
+  ReadStream(csv, &replayed);
+
+  const Result a = Run(stream);
+  const Result b = Run(replayed);
+  const bool ok = (replayed.samples.size() == stream.samples.size()) && (a.dx == b.dx) && (a.dy == b.dy);
+  return Report("replay", ok, "%zu samples, motion (%ld, %ld) and (%ld, %ld)",
+                replayed.samples.size(), a.dx, a.dy, b.dx, b.dy);
+}
+
+/* Read the simulated IMU every @p periodMs for a second, return the samples read. */
+int ReadBursts(LSM9DS1Fifo &imu, int periodMs, unsigned *overruns)
+{
+  const unsigned before = imu.overruns();
+  int total = 0;
+  for (int t = 0; t < 1000; t += periodMs) {
+    sim::Advance(periodMs * 1000);
+    AirMouse::sample_t samples[LSM9DS1Fifo::kFifoSize];
+    total += imu.read(samples, LSM9DS1Fifo::kFifoSize);
+  }
+  *overruns = imu.overruns() - before;
+  return total;
+}
+
+bool CheckFifo()
+{
+  sim::SetImuErrors(kGyroBias, kGyroNoise, kAccelNoise);
+  LSM9DS1Fifo imu;
+  if (!Report("fifo", imu.initialize(), "initialize")) {
+    return false;
+  }
+
+  // Flat and still : 1g on z and the gyro bias.
+  AirMouse::sample_t sample;
+  sim::Advance(10000);
+  imu.read(&sample, 1);
+  const bool values = (fabsf(sample.accel[2] * kAccelLsb - 1.0f) < 0.01f)
+                   && (fabsf(sample.gyro[0] * kGyroLsb - kGyroBias[0]) < 0.2f);
+  bool ok = Report("fifo", values, "sample accel z %.3f g, gyro x %.3f dps",
+                   sample.accel[2] * kAccelLsb, sample.gyro[0] * kGyroLsb);
+
+  // Bursts every 10ms keep up with the output rate, every 200ms overrun.
+  unsigned overruns;
+  const int samples = ReadBursts(imu, 10, &overruns);
+  ok &= Report("fifo", (abs(samples - static_cast<int>(kSampleRate)) <= 2) && (overruns == 0),
+               "10ms bursts : %d samples/s, %u overruns", samples, overruns);
+  const int lost = ReadBursts(imu, 200, &overruns);
+  ok &= Report("fifo", (lost <= 5 * LSM9DS1Fifo::kFifoSize) && (overruns > 0),
+               "200ms bursts : %d samples/s, %u overruns", lost, overruns);
+  return ok;
+}
+
+void PrintUsage(const char *name)
+{
+  fprintf(stderr,
+    "usage: %s [options]\n"
+    "  --replay FILE        replay a recorded stream, writing the pointer as CSV\n"
+    "  --write FILE         write the synthetic yaw stream\n",
+    name
+  );
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+void setup() {}
+void loop() {}
+
+int main(int argc, char *argv[])
+{
+  if ((argc == 3) && !strcmp(argv[1], "--replay")) {
+    std::ifstream file(argv[2]);
+    Stream stream;
+    if (!ReadStream(file, &stream)) {
+      fprintf(stderr, "no samples in %s\n", argv[2]);
+      return EXIT_FAILURE;
+    }
+    std::cout << "sample,x,y,up_x,up_y,up_z\n";
+    const Result result = Run(stream, &std::cout);
+    fprintf(stderr, "%zu samples, motion (%ld, %ld), bias (%.3f %.3f %.3f) dps\n",
+            stream.samples.size(), result.dx, result.dy, result.bias[0], result.bias[1], result.bias[2]);
+    return EXIT_SUCCESS;
+  }
+  if ((argc == 3) && !strcmp(argv[1], "--write")) {
+    std::ofstream file(argv[2]);
+    WriteStream(YawStream(), file);
+    return file ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  if (argc != 1) {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  bool ok = CheckBias();
+  ok &= CheckTilt();
+  ok &= CheckYaw();
+  ok &= CheckPitch();
+  ok &= CheckReplay();
+  ok &= CheckFifo();
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* -------------------------------------------------------------------------- */
@@ -0,0 +1,256 @@
+#include <cmath>
+#include <deque>
+
+#include "Arduino.h"
+#include "Wire.h"
+#include "sim/simulator.h"
+
+/* -------------------------------------------------------------------------- */
+
+TwoWire Wire(0);
+TwoWire Wire1(1);
+
+namespace {
+
+// LSM9DS1 accelerometer and gyroscope on the internal bus.
+constexpr int kImuBus         = 1;
+constexpr uint8_t kImuAddress = 0x6B;
+
+constexpr uint8_t WHO_AM_I     = 0x0F;
+constexpr uint8_t CTRL_REG1_G  = 0x10;
+constexpr uint8_t OUT_X_L_G    = 0x18;
+constexpr uint8_t CTRL_REG6_XL = 0x20;
+constexpr uint8_t CTRL_REG8    = 0x22;
+constexpr uint8_t CTRL_REG9    = 0x23;
+constexpr uint8_t OUT_X_L_XL   = 0x28;
+constexpr uint8_t OUT_Z_H_XL   = 0x2D;
+constexpr uint8_t FIFO_CTRL    = 0x2E;
+constexpr uint8_t FIFO_SRC     = 0x2F;
+
+constexpr int kFifoSize = 32;
+
+// Gyro output rates (CTRL_REG1_G ODR_G), the accelerometer following them.
+constexpr float kOutputRates[] = { 0.0f, 14.9f, 59.5f, 119.0f, 238.0f, 476.0f, 952.0f, 0.0f };
+
+// Sensitivities by full scale setting, in dps and g per LSB.
+constexpr float kGyroSensitivities[]  = { 0.00875f, 0.0175f, 0.0175f, 0.07f };
+constexpr float kAccelSensitivities[] = { 0.000061f, 0.000732f, 0.000122f, 0.000244f };
+
+struct Sample {
+  int16_t gyro[3];
+  int16_t accel[3];
+};
+
+struct Imu {
+  uint8_t registers[0x80] = {};
+  uint8_t pointer = 0;
+
+  std::deque<Sample> fifo;
+  bool overrun = false;
+  Sample latest = {};
+  uint64_t nextSampleTime = 0;   // 0 while powered down.
+};
+
+/* Motion and sensor errors, kept across resets. */
+struct Environment {
+  std::function<sim::ImuMotion(double)> motion;
+  float gyroBias[3] = { 0.8f, -0.5f, 0.3f };
+  float gyroNoise   = 0.1f;
+  float accelNoise  = 0.002f;
+  uint32_t seed     = 1;
+};
+
+Imu sImu;
+Environment sEnvironment;
+
+float Noise(float amplitude)
+{
+  sEnvironment.seed = sEnvironment.seed * 1664525u + 1013904223u;
+  return amplitude * ((sEnvironment.seed >> 8) / float(1 << 24) * 2.0f - 1.0f);
+}
+
+int16_t ToRaw(float value, float sensitivity)
+{
+  const float raw = roundf(value / sensitivity);
+  return static_cast<int16_t>((raw > 32767.0f) ? 32767.0f : (raw < -32768.0f) ? -32768.0f : raw);
+}
+
+float OutputRate()
+{
+  return kOutputRates[sImu.registers[CTRL_REG1_G] >> 5];
+}
+
+bool FifoEnabled()
+{
+  return (sImu.registers[CTRL_REG9] & 0x02) && ((sImu.registers[FIFO_CTRL] >> 5) != 0);
+}
+
+Sample Measure(double t)
+{
+  sim::ImuMotion motion = {};
+  if (sEnvironment.motion) {
+    motion = sEnvironment.motion(t);
+  } else {
+    motion.accel[2] = 1.0f;
+  }
+
+  const float gyroSensitivity  = kGyroSensitivities[(sImu.registers[CTRL_REG1_G] >> 3) & 3];
+  const float accelSensitivity = kAccelSensitivities[(sImu.registers[CTRL_REG6_XL] >> 3) & 3];
+  Sample sample;
+  for (int i = 0; i < 3; ++i) {
+    sample.gyro[i]  = ToRaw(motion.gyro[i] + sEnvironment.gyroBias[i] + Noise(sEnvironment.gyroNoise), gyroSensitivity);
+    sample.accel[i] = ToRaw(motion.accel[i] + Noise(sEnvironment.accelNoise), accelSensitivity);
+  }
+  return sample;
+}
+
+/* Produce the samples up to the current time. */
+void CatchUp()
+{
+  const float rate = OutputRate();
+  if (rate <= 0.0f) {
+    sImu.nextSampleTime = 0;
+    return;
+  }
+  const uint64_t period = static_cast<uint64_t>(1.0e6f / rate);
+  if (sImu.nextSampleTime == 0) {
+    sImu.nextSampleTime = sim::Now() + period;
+  }
+  for (; sImu.nextSampleTime <= sim::Now(); sImu.nextSampleTime += period) {
+    sImu.latest = Measure(sImu.nextSampleTime * 1.0e-6);
+    if (!FifoEnabled()) {
+      continue;
+    }
+    if (sImu.fifo.size() >= kFifoSize) {
+      // Continuous mode : the oldest sample is overwritten.
+      sImu.fifo.pop_front();
+      sImu.overrun = true;
+    }
+    sImu.fifo.push_back(sImu.latest);
+  }
+}
+
+uint8_t ReadRegister(uint8_t reg)
+{
+  const Sample &sample = (FifoEnabled() && !sImu.fifo.empty()) ? sImu.fifo.front() : sImu.latest;
+  if ((reg >= OUT_X_L_G) && (reg < OUT_X_L_G + 6)) {
+    const int16_t v = sample.gyro[(reg - OUT_X_L_G) / 2];
+    return ((reg - OUT_X_L_G) & 1) ? (v >> 8) & 0xff : v & 0xff;
+  }
+  if ((reg >= OUT_X_L_XL) && (reg <= OUT_Z_H_XL)) {
+    const int16_t v = sample.accel[(reg - OUT_X_L_XL) / 2];
+    const uint8_t value = ((reg - OUT_X_L_XL) & 1) ? (v >> 8) & 0xff : v & 0xff;
+    if ((reg == OUT_Z_H_XL) && FifoEnabled() && !sImu.fifo.empty()) {
+      // The FIFO moves to the next sample once its accelerometer is read.
+      sImu.fifo.pop_front();
+    }
+    return value;
+  }
+  if (reg == FIFO_SRC) {
+    const uint8_t value = static_cast<uint8_t>(sImu.fifo.size() | (sImu.overrun ? 0x40 : 0));
+    sImu.overrun = false;
+    return value;
+  }
+  if (reg == WHO_AM_I) {
+    return 0x68;
+  }
+  return sImu.registers[reg];
+}
+
+void WriteRegister(uint8_t reg, uint8_t value)
+{
+  if ((reg == CTRL_REG8) && (value & 0x01)) {
+    // Software reset.
+    sImu = Imu();
+    sImu.registers[CTRL_REG8] = 0x04;
+    return;
+  }
+  sImu.registers[reg] = value;
+  if ((reg == FIFO_CTRL) && ((value >> 5) == 0)) {
+    // Bypass mode empties the FIFO.
+    sImu.fifo.clear();
+    sImu.overrun = false;
+  }
+}
+
+/* Register address following @p reg in a multiple bytes access. */
+uint8_t NextRegister(uint8_t reg)
+{
+  return (sImu.registers[CTRL_REG8] & 0x04) ? (reg + 1) & 0x7f : reg;
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+void sim::SetImuMotion(std::function<ImuMotion(double)> motion)
+{
+  sEnvironment.motion = motion;
+}
+
+void sim::SetImuErrors(const float gyroBias[3], float gyroNoise, float accelNoise)
+{
+  for (int i = 0; i < 3; ++i) {
+    sEnvironment.gyroBias[i] = gyroBias[i];
+  }
+  sEnvironment.gyroNoise  = gyroNoise;
+  sEnvironment.accelNoise = accelNoise;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+  address_ = address;
+  tx_.clear();
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+  tx_.push_back(data);
+  return 1;
+}
+
+uint8_t TwoWire::endTransmission(bool stopBit)
+{
+  if ((bus_ != kImuBus) || (address_ != kImuAddress)) {
+    return 2;
+  }
+  CatchUp();
+  if (!tx_.empty()) {
+    sImu.pointer = tx_[0] & 0x7f;
+    for (size_t i = 1; i < tx_.size(); ++i) {
+      WriteRegister(sImu.pointer, tx_[i]);
+      sImu.pointer = NextRegister(sImu.pointer);
+    }
+  }
+  tx_.clear();
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, size_t quantity, bool stopBit)
+{
+  rx_.clear();
+  rxIndex_ = 0;
+  if ((bus_ != kImuBus) || (address != kImuAddress)) {
+    return 0;
+  }
+  CatchUp();
+  for (size_t i = 0; i < quantity; ++i) {
+    rx_.push_back(ReadRegister(sImu.pointer));
+    sImu.pointer = NextRegister(sImu.pointer);
+  }
+  return static_cast<uint8_t>(rx_.size());
+}
+
+int TwoWire::available() const
+{
+  return static_cast<int>(rx_.size() - rxIndex_);
+}
+
+int TwoWire::read()
+{
+  return (rxIndex_ < rx_.size()) ? rx_[rxIndex_++] : -1;
+}
+
+/* -------------------------------------------------------------------------- */
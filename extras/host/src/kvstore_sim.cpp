@@ -0,0 +1,44 @@
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "kvstore_global_api.h"
+
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+std::map<std::string, std::vector<uint8_t>> sRecords;
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+int kv_set(const char *full_name_key, const void *buffer, size_t size, uint32_t create_flags)
+{
+  const uint8_t *data = static_cast<const uint8_t*>(buffer);
+  sRecords[full_name_key].assign(data, data + size);
+  return MBED_SUCCESS;
+}
+
+int kv_get(const char *full_name_key, void *buffer, size_t buffer_size, size_t *actual_size)
+{
+  auto it = sRecords.find(full_name_key);
+  if (it == sRecords.end()) {
+    return MBED_ERROR_ITEM_NOT_FOUND;
+  }
+  const size_t size = (it->second.size() < buffer_size) ? it->second.size() : buffer_size;
+  memcpy(buffer, it->second.data(), size);
+  if (actual_size) {
+    *actual_size = size;
+  }
+  return MBED_SUCCESS;
+}
+
+int kv_remove(const char *full_name_key)
+{
+  return sRecords.erase(full_name_key) ? MBED_SUCCESS : MBED_ERROR_ITEM_NOT_FOUND;
+}
+
+/* -------------------------------------------------------------------------- */
@@ -0,0 +1,195 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+#include "Arduino.h"
+#include "ble/BLE.h"
+#include "report_capture.h"
+
+/* -------------------------------------------------------------------------- */
+//
+// Run a sketch on the simulated timeline, then report the notifications
+// received by the host.
+//
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+void PrintUsage(const char *name)
+{
+  fprintf(stderr,
+    "usage: %s [options]\n"
+    "  --duration MS        simulated run duration (default 10000)\n"
+    "  --interval US        connection interval, multiple of 1250 (default 7500)\n"
+    "  --mtu N              ATT MTU accepted by the host (default 247)\n"
+    "  --per-event N        notifications sent per connection event (default 4)\n"
+    "  --buffers N          notifications buffered by the stack (default 8)\n"
+    "  --disconnect-at MS   the host disconnects at this time\n"
+    "  --no-connect         the host never connects\n"
+    "  --csv FILE           write the notifications to FILE\n"
+    "  --capture FILE       write the input reports to FILE as a report capture\n",
+    name
+  );
+}
+
+struct Options {
+  const char *csvFilename     = nullptr;
+  const char *captureFilename = nullptr;
+};
+
+bool ParseArgs(int argc, char *argv[], Options *options)
+{
+  auto &config = sim::GetConfig();
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+    if (!strcmp(arg, "--no-connect")) {
+      config.connectDelayMs = 0;
+      continue;
+    }
+    if (!value) {
+      return false;
+    }
+    ++i;
+    if (!strcmp(arg, "--duration")) {
+      config.durationMs = atoi(value);
+    } else if (!strcmp(arg, "--interval")) {
+      config.connectionInterval = atoi(value);
+    } else if (!strcmp(arg, "--mtu")) {
+      config.attMtu = atoi(value);
+    } else if (!strcmp(arg, "--per-event")) {
+      config.notificationsPerEvent = atoi(value);
+    } else if (!strcmp(arg, "--buffers")) {
+      config.txBuffers = atoi(value);
+    } else if (!strcmp(arg, "--disconnect-at")) {
+      config.disconnectAtMs = atoi(value);
+    } else if (!strcmp(arg, "--csv")) {
+      options->csvFilename = value;
+    } else if (!strcmp(arg, "--capture")) {
+      options->captureFilename = value;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Run the Arduino loop every millisecond, for sketches without event thread. */
+void LoopTask()
+{
+  loop();
+  sim::Schedule(1000, LoopTask);
+}
+
+void PrintSummary()
+{
+  struct Stats {
+    unsigned count = 0;
+    size_t bytes   = 0;
+  };
+  std::map<uint16_t, Stats> stats;
+  for (const auto &notification : sim::Notifications()) {
+    auto &s = stats[notification.handle];
+    ++s.count;
+    s.bytes += notification.data.size();
+  }
+
+  const double seconds = sim::GetConfig().durationMs / 1000.0;
+  printf("%u notifications in %.1f s\n", static_cast<unsigned>(sim::Notifications().size()), seconds);
+  printf("handle   uuid    count        Hz       B/s\n");
+  for (const auto &it : stats) {
+    const auto *attribute = sim::FindAttribute(it.first);
+    printf("%6u  0x%04X %7u %9.1f %9.1f\n",
+      it.first, attribute ? attribute->uuid : 0, it.second.count,
+      it.second.count / seconds, it.second.bytes / seconds
+    );
+  }
+}
+
+bool WriteCSV(const char *filename)
+{
+  FILE *fd = fopen(filename, "w");
+  if (!fd) {
+    return false;
+  }
+  fprintf(fd, "timestamp_us,connection,handle,data\n");
+  for (const auto &notification : sim::Notifications()) {
+    fprintf(fd, "%llu,%u,%u,",
+      static_cast<unsigned long long>(notification.timestamp),
+      static_cast<unsigned>(notification.connection), notification.handle
+    );
+    for (uint8_t byte : notification.data) {
+      fprintf(fd, "%02x", byte);
+    }
+    fprintf(fd, "\n");
+  }
+  fclose(fd);
+  return true;
+}
+
+/* Write the input reports received by the host as a report capture. */
+bool WriteCapture(const char *filename)
+{
+  const auto services = sim::HIDServices();
+  std::vector<uint8_t> buffer(1 << 20);
+  ReportRecorder recorder(buffer.data(), buffer.size());
+
+  std::map<uint16_t, int> reportMaps;
+  for (const auto &service : services) {
+    for (const auto &report : service.reports) {
+      if (report.type == 1) {
+        reportMaps[report.handle] = recorder.addReportMap(service.reportMap->value, service.reportMap->length, report.id);
+      }
+    }
+  }
+  for (const auto &notification : sim::Notifications()) {
+    auto it = reportMaps.find(notification.handle);
+    if ((it != reportMaps.end()) && (it->second >= 0)) {
+      recorder.record(it->second, notification.data.data(), notification.data.size(),
+                      static_cast<uint32_t>(notification.timestamp));
+    }
+  }
+
+  FILE *fd = fopen(filename, "wb");
+  if (!fd) {
+    return false;
+  }
+  recorder.dump([fd](const uint8_t *data, size_t size) { fwrite(data, 1, size, fd); });
+  fclose(fd);
+  return true;
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+  Options options;
+  if (!ParseArgs(argc, argv, &options)) {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // Sketches using MbedBleHID_RunEventThread() only return at the end of the run.
+  setup();
+  if (sim::Now() < sim::GetConfig().durationMs * 1000uLL) {
+    sim::Schedule(0, LoopTask);
+    sim::Run();
+  }
+
+  PrintSummary();
+  if (options.csvFilename && !WriteCSV(options.csvFilename)) {
+    fprintf(stderr, "could not write %s\n", options.csvFilename);
+    return EXIT_FAILURE;
+  }
+  if (options.captureFilename && !WriteCapture(options.captureFilename)) {
+    fprintf(stderr, "could not write %s\n", options.captureFilename);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
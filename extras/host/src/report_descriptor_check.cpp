@@ -0,0 +1,296 @@
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "USBHID_Types.h"
+#include "report_descriptor.h"
+
+/* -------------------------------------------------------------------------- */
+//
+// Check the report descriptor parser, built with AddressSanitizer and
+// UndefinedBehaviorSanitizer.
+//
+//  reports  : report lengths and fields of valid maps.
+//  errors   : each malformed map is rejected with its error, at its item.
+//  fuzz     : random mutations of the valid maps run through the fuzzing
+//             entry point (report_descriptor_fuzz.cpp), which aborts on an
+//             inconsistent result.
+//
+// With file arguments, runs the fuzzing entry point on each of them instead,
+// eg. to replay the crashes and the corpus of libFuzzer (make fuzz).
+//
+// Exits with 1 when a check fails.
+//
+/* -------------------------------------------------------------------------- */
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+namespace {
+
+constexpr int kNumMutations = 200000;
+
+using Map = std::vector<uint8_t>;
+
+// Mouse with Report IDs, and a feature report.
+const Map kMouseMap = {
+  USAGE_PAGE(1),      0x01,
+  USAGE(1),           0x02,
+  COLLECTION(1),      0x01,
+    REPORT_ID(1),       0x01,
+    USAGE(1),           0x01,
+    COLLECTION(1),      0x00,
+      USAGE_PAGE(1),      0x09,
+      USAGE_MINIMUM(1),   0x01,
+      USAGE_MAXIMUM(1),   0x03,
+      LOGICAL_MINIMUM(1), 0x00,
+      LOGICAL_MAXIMUM(1), 0x01,
+      REPORT_COUNT(1),    0x03,
+      REPORT_SIZE(1),     0x01,
+      INPUT(1),           0x02,
+      REPORT_COUNT(1),    0x01,
+      REPORT_SIZE(1),     0x05,
+      INPUT(1),           0x01,
+      USAGE_PAGE(1),      0x01,
+      USAGE(1),           0x30,
+      USAGE(1),           0x31,
+      LOGICAL_MINIMUM(1), 0x81,
+      LOGICAL_MAXIMUM(1), 0x7f,
+      REPORT_SIZE(1),     0x08,
+      REPORT_COUNT(1),    0x02,
+      INPUT(1),           0x06,
+    END_COLLECTION(0),
+    REPORT_ID(1),       0x02,
+    USAGE_PAGE(2),      0x00, 0xFF,
+    USAGE(1),           0x01,
+    LOGICAL_MINIMUM(1), 0x00,
+    LOGICAL_MAXIMUM(2), 0xFF, 0x00,
+    REPORT_SIZE(1),     0x08,
+    REPORT_COUNT(1),    0x01,
+    FEATURE(1),         0x02,
+  END_COLLECTION(0),
+};
+
+// Keyboard without Report ID, with an output report and a pushed state.
+const Map kKeyboardMap = {
+  USAGE_PAGE(1),      0x01,
+  USAGE(1),           0x06,
+  COLLECTION(1),      0x01,
+    USAGE_PAGE(1),      0x07,
+    USAGE_MINIMUM(1),   0xE0,
+    LOGICAL_MINIMUM(1), 0x00,
+    LOGICAL_MAXIMUM(1), 0x01,
+    REPORT_SIZE(1),     0x01,
+    REPORT_COUNT(1),    0x08,
+    INPUT(1),           0x02,
+    PUSH(0),
+    REPORT_COUNT(1),    0x05,
+    USAGE_PAGE(1),      0x08,
+    OUTPUT(1),          0x02,
+    REPORT_SIZE(1),     0x03,
+    REPORT_COUNT(1),    0x01,
+    OUTPUT(1),          0x01,
+    POP(0),
+    REPORT_SIZE(1),     0x08,
+    REPORT_COUNT(1),    0x06,
+    LOGICAL_MAXIMUM(2), 0xFF, 0x00,
+    INPUT(1),           0x00,
+  END_COLLECTION(0),
+};
+
+bool Report(const char *name, bool ok, const char *format, double a, double b)
+{
+  printf("%-9s %s  ", name, ok ? "ok  " : "FAIL");
+  printf(format, a, b);
+  printf("\n");
+  fflush(stdout);   // (before an abort of the fuzzing entry point)
+  return ok;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool CheckReports()
+{
+  ReportDescriptor descriptor;
+  ReportDescriptor::field_t fields[8];
+  int failures = 0;
+
+  failures += (descriptor.parse(kMouseMap.data(), kMouseMap.size(), fields, 8) != ReportDescriptor::NO_ERROR);
+  failures += (descriptor.numReports() != 2) || (descriptor.numFields() != 4);
+  failures += (descriptor.reportSize(ReportDescriptor::INPUT, 1) != 3);
+  failures += (descriptor.reportSize(ReportDescriptor::FEATURE, 2) != 1);
+  failures += (descriptor.reportSize(ReportDescriptor::INPUT, 0) != -1);
+  failures += (fields[2].bitOffset != 8) || (fields[2].count != 2) || (fields[2].usage != 0x30);
+  failures += (fields[2].logicalMinimum != -127) || (fields[2].logicalMaximum != 127);
+  failures += (fields[3].logicalMaximum != 255);
+
+  failures += (descriptor.parse(kKeyboardMap.data(), kKeyboardMap.size(), fields, 8) != ReportDescriptor::NO_ERROR);
+  failures += (descriptor.reportSize(ReportDescriptor::INPUT) != 7);
+  failures += (descriptor.reportSize(ReportDescriptor::OUTPUT) != 1);
+  failures += (fields[3].bitSize != 8) || (fields[3].count != 6);
+
+  return Report("reports", failures == 0, "%.0f mismatches over %.0f maps", failures, 2);
+}
+
+/* -------------------------------------------------------------------------- */
+
+struct ErrorCase {
+  const char *name;
+  Map map;
+  ReportDescriptor::Error error;
+  size_t offset;
+};
+
+// Prefix of a data field, before its Report Size, Report Count and main item.
+#define RANGE   LOGICAL_MINIMUM(1), 0x00, LOGICAL_MAXIMUM(1), 0x01
+
+const ErrorCase kErrorCases[] = {
+  { "truncated item",
+    { USAGE_PAGE(2), 0x01 },
+    ReportDescriptor::ERROR_TRUNCATED, 0 },
+  { "truncated long item",
+    { 0xFE, 0x04, 0x00, 0x01 },
+    ReportDescriptor::ERROR_TRUNCATED, 0 },
+  { "reserved item",
+    { 0x0C },
+    ReportDescriptor::ERROR_UNKNOWN_ITEM, 0 },
+  { "unbalanced collections",
+    { COLLECTION(1), 0x01 },
+    ReportDescriptor::ERROR_COLLECTION, 2 },
+  { "end without collection",
+    { END_COLLECTION(0) },
+    ReportDescriptor::ERROR_COLLECTION, 0 },
+  { "pop without push",
+    { POP(0) },
+    ReportDescriptor::ERROR_GLOBAL_STACK, 0 },
+  { "push overflow",
+    { PUSH(0), PUSH(0), PUSH(0), PUSH(0), PUSH(0) },
+    ReportDescriptor::ERROR_GLOBAL_STACK, 4 },
+  { "missing report count",
+    { RANGE, REPORT_SIZE(1), 0x08, INPUT(1), 0x02 },
+    ReportDescriptor::ERROR_REPORT_SIZE, 6 },
+  { "missing logical range",
+    { REPORT_SIZE(1), 0x08, REPORT_COUNT(1), 0x01, INPUT(1), 0x02 },
+    ReportDescriptor::ERROR_LOGICAL_RANGE, 4 },
+  { "report ID 0",
+    { REPORT_ID(1), 0x00 },
+    ReportDescriptor::ERROR_REPORT_ID, 0 },
+  { "mixed report IDs",
+    { RANGE, REPORT_SIZE(1), 0x08, REPORT_COUNT(1), 0x01, INPUT(1), 0x02,
+      REPORT_ID(1), 0x01, INPUT(1), 0x02 },
+    ReportDescriptor::ERROR_REPORT_ID, 12 },
+  { "too many reports",
+    { RANGE, REPORT_SIZE(1), 0x08, REPORT_COUNT(1), 0x01,
+      REPORT_ID(1), 1, INPUT(1), 0x02, REPORT_ID(1), 2, INPUT(1), 0x02,
+      REPORT_ID(1), 3, INPUT(1), 0x02, REPORT_ID(1), 4, INPUT(1), 0x02,
+      REPORT_ID(1), 5, INPUT(1), 0x02, REPORT_ID(1), 6, INPUT(1), 0x02,
+      REPORT_ID(1), 7, INPUT(1), 0x02, REPORT_ID(1), 8, INPUT(1), 0x02,
+      REPORT_ID(1), 9, INPUT(1), 0x02 },
+    ReportDescriptor::ERROR_TOO_MANY_REPORTS, 42 },
+  // 255 x 65535 bits, wrapping a 16-bit length to 65281.
+  { "report overflow",
+    { RANGE, REPORT_SIZE(1), 0xFF, REPORT_COUNT(2), 0xFF, 0xFF, INPUT(1), 0x02 },
+    ReportDescriptor::ERROR_REPORT_OVERFLOW, 9 },
+  // 2 x 32768 bits, wrapping to 0.
+  { "report overflow (sum)",
+    { RANGE, REPORT_SIZE(1), 0x08, REPORT_COUNT(2), 0x00, 0x10, INPUT(1), 0x02, INPUT(1), 0x02 },
+    ReportDescriptor::ERROR_REPORT_OVERFLOW, 11 },
+};
+
+#undef RANGE
+
+bool CheckErrors()
+{
+  int failures = 0;
+  for (const auto &errorCase : kErrorCases) {
+    ReportDescriptor descriptor;
+    const auto error = descriptor.parse(errorCase.map.data(), errorCase.map.size());
+    if ((error != errorCase.error) || (descriptor.errorOffset() != errorCase.offset)) {
+      printf("  %s : %s at %zu, expected %s at %zu\n", errorCase.name,
+             ReportDescriptor::ErrorString(error), descriptor.errorOffset(),
+             ReportDescriptor::ErrorString(errorCase.error), errorCase.offset);
+      ++failures;
+    }
+  }
+  const int numCases = sizeof(kErrorCases) / sizeof(kErrorCases[0]);
+  return Report("errors", failures == 0, "%.0f mismatches over %.0f malformed maps", failures, numCases);
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* Mutate @p map in place : flip, overwrite, insert, erase or duplicate bytes. */
+void Mutate(Map &map, std::mt19937 &rng)
+{
+  std::uniform_int_distribution<int> byte(0, 255);
+  const int numEdits = 1 + rng() % 4;
+  for (int i = 0; i < numEdits; ++i) {
+    const size_t at = map.empty() ? 0 : rng() % map.size();
+    switch (rng() % 5) {
+      case 0: if (!map.empty()) map[at] ^= 1 << (rng() % 8); break;
+      case 1: if (!map.empty()) map[at] = byte(rng); break;
+      case 2: map.insert(map.begin() + at, byte(rng)); break;
+      case 3: if (!map.empty()) map.erase(map.begin() + at); break;
+      case 4: map.insert(map.begin() + at, map.begin() + at, map.begin() + std::min(at + 4, map.size())); break;
+    }
+  }
+}
+
+bool CheckFuzz()
+{
+  std::mt19937 rng(1);
+  const Map *seeds[] = { &kMouseMap, &kKeyboardMap };
+
+  int numParsed = 0;
+  for (int i = 0; i < kNumMutations; ++i) {
+    Map map = *seeds[i % 2];
+    Mutate(map, rng);
+    // (an exact-size copy, for the sanitizer to catch reads past the end)
+    std::vector<uint8_t> input(map);
+    input.shrink_to_fit();
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+
+    ReportDescriptor descriptor;
+    numParsed += (descriptor.parse(input.data(), input.size()) == ReportDescriptor::NO_ERROR) ? 1 : 0;
+  }
+  return Report("fuzz", true, "%.0f mutated maps, %.0f valid", kNumMutations, numParsed);
+}
+
+/* Run the fuzzing entry point on the file at @p path. */
+bool Replay(const char *path)
+{
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    printf("%s : cannot open\n", path);
+    return false;
+  }
+  std::vector<uint8_t> input;
+  for (int c; (c = fgetc(file)) != EOF; ) {
+    input.push_back(static_cast<uint8_t>(c));
+  }
+  fclose(file);
+  input.shrink_to_fit();
+  LLVMFuzzerTestOneInput(input.data(), input.size());
+  return true;
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+  bool ok = true;
+  if (argc > 1) {
+    for (int i = 1; i < argc; ++i) {
+      ok &= Replay(argv[i]);
+    }
+    printf("%-9s %s  %d inputs replayed\n", "replay", ok ? "ok  " : "FAIL", argc - 1);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  ok &= CheckReports();
+  ok &= CheckErrors();
+  ok &= CheckFuzz();
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* -------------------------------------------------------------------------- */
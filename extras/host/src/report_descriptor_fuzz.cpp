@@ -0,0 +1,75 @@
+#include <cstdint>
+#include <cstdlib>
+
+#include "report_descriptor.h"
+
+/* -------------------------------------------------------------------------- */
+//
+// Fuzzing entry point of the report descriptor parser, for libFuzzer
+// (make fuzz, with clang) or for the standalone driver of
+// report_descriptor_check (make descriptor).
+//
+// Any input must parse without reading past its end, and the result must be
+// consistent : the error offset lies in the map, and the fields of a parsed
+// map tile their reports, whose lengths fit their bit count.
+//
+// Aborts on an inconsistent result, the sanitizers catching the rest.
+//
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+constexpr int kMaxFields = 64;
+
+void Expect(bool condition)
+{
+  if (!condition) {
+    abort();
+  }
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  ReportDescriptor descriptor;
+  ReportDescriptor::field_t fields[kMaxFields];
+  const auto error = descriptor.parse(data, size, fields, kMaxFields);
+
+  Expect(error == descriptor.error());
+  Expect(descriptor.errorOffset() <= size);
+  Expect((descriptor.numReports() >= 0) && (descriptor.numReports() <= ReportDescriptor::kMaxReports));
+
+  // The fields do not change the result.
+  ReportDescriptor bare;
+  Expect(bare.parse(data, size) == error);
+  Expect(bare.errorOffset() == descriptor.errorOffset());
+
+  if (error != ReportDescriptor::NO_ERROR) {
+    return 0;
+  }
+
+  uint32_t bitLengths[ReportDescriptor::kMaxReports] = {};
+  const int numFields = (descriptor.numFields() < kMaxFields) ? descriptor.numFields() : kMaxFields;
+  for (int i = 0; i < numFields; ++i) {
+    const auto &field = fields[i];
+    Expect(field.report < descriptor.numReports());
+    Expect(field.bitOffset == bitLengths[field.report]);
+    bitLengths[field.report] += uint32_t(field.bitSize) * field.count;
+  }
+  if (numFields == descriptor.numFields()) {
+    for (int i = 0; i < descriptor.numReports(); ++i) {
+      Expect(bitLengths[i] == descriptor.report(i).bitLength);
+    }
+  }
+  for (int i = 0; i < descriptor.numReports(); ++i) {
+    const auto &report = descriptor.report(i);
+    Expect(descriptor.find(report.type, report.id) == &report);
+    Expect(report.size() == (report.bitLength + 7u) / 8u);
+  }
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
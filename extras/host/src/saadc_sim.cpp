@@ -0,0 +1,471 @@
+#include <climits>
+#include <map>
+#include <vector>
+
+#include "Arduino.h"
+#include "nrf_ppi.h"
+#include "nrf_saadc.h"
+#include "nrf_timer.h"
+
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+// Conversion time of a single sample, in microseconds (on top of its acquisition time).
+constexpr uint32_t kConversionTimeUs = 2;
+
+constexpr uint32_t kAcquisitionTimesUs[] = { 3, 5, 10, 15, 20, 40 };
+
+// nRF52840 pins of the analog inputs AIN0 to AIN7.
+constexpr int kInputPins[] = { 2, 3, 4, 5, 28, 29, 30, 31 };
+
+struct Saadc {
+  bool enabled = false;
+  nrf_saadc_resolution_t resolution = NRF_SAADC_RESOLUTION_10BIT;
+  nrf_saadc_oversample_t oversample = NRF_SAADC_OVERSAMPLE_DISABLED;
+  nrf_saadc_channel_config_t channels[NRF_SAADC_CHANNEL_COUNT] = {};
+
+  // EasyDMA, the pointer being double buffered on START.
+  nrf_saadc_value_t *nextBuffer = nullptr;
+  uint32_t nextMaxCount = 0;
+  nrf_saadc_value_t *buffer = nullptr;
+  uint32_t maxCount = 0;
+  uint32_t amount = 0;
+  bool started = false;
+  bool busy = false;
+
+  uint32_t events = 0;      // raised events, one bit per nrf_saadc_int_mask_t.
+  uint32_t interrupts = 0;  // enabled interrupts.
+};
+
+struct Nvic {
+  void (*vector)() = nullptr;
+  bool enabled = false;
+  bool pending = false;
+};
+
+/* A TIMER, of which only the COMPARE0 event is simulated. */
+struct NrfTimer {
+  nrf_timer_frequency_t frequency = NRF_TIMER_FREQ_16MHz;
+  uint32_t cc0 = 0;
+  uint32_t shorts = 0;
+  uint32_t events = 0;      // raised events, one bit per compare channel.
+  int compareId = 0;        // next COMPARE0 on the timeline, 0 when stopped.
+};
+
+struct PpiChannel {
+  uint32_t eep = 0;
+  uint32_t tep = 0;
+  bool enabled = false;
+};
+
+Saadc sSaadc;
+Nvic sNvic;
+std::map<uintptr_t, NrfTimer> sTimers;
+PpiChannel sPpiChannels[PPI_CH_NUM];
+
+std::map<int, int> sNoises;
+uint32_t sNoiseSeed = 1;
+
+inline uint32_t EventBit(nrf_saadc_event_t event)
+{
+  return 1u << ((event - NRF_SAADC_EVENT_STARTED) / 4);
+}
+
+void RunInterrupt()
+{
+  sNvic.pending = false;
+  if (sNvic.enabled && sNvic.vector) {
+    sNvic.vector();
+  }
+}
+
+/* Set the interrupt pending when enabled, it runs as soon as the caller returns. */
+void UpdateInterrupt()
+{
+  if (!(sSaadc.events & sSaadc.interrupts) || sNvic.pending) {
+    return;
+  }
+  sNvic.pending = true;
+  sim::Schedule(0, RunInterrupt);
+}
+
+void Raise(nrf_saadc_event_t event)
+{
+  sSaadc.events |= EventBit(event);
+  UpdateInterrupt();
+}
+
+/* Arduino pin of an analog input, -1 when none. */
+int InputToArduinoPin(nrf_saadc_input_t input)
+{
+  if ((input < NRF_SAADC_INPUT_AIN0) || (input > NRF_SAADC_INPUT_AIN7)) {
+    return -1;
+  }
+  const int pinName = kInputPins[input - NRF_SAADC_INPUT_AIN0];
+  for (int pin = A0; pin <= A7; ++pin) {
+    if (digitalPinToPinName(pin) == pinName) {
+      return pin;
+    }
+  }
+  return -1;
+}
+
+int Noise(int pin)
+{
+  auto it = sNoises.find(pin);
+  if ((it == sNoises.end()) || (it->second <= 0)) {
+    return 0;
+  }
+  sNoiseSeed = sNoiseSeed * 1664525u + 1013904223u;
+  return static_cast<int>((sNoiseSeed >> 8) % (2 * it->second + 1)) - it->second;
+}
+
+/* Convert a channel once, oversampled, at the configured resolution. */
+nrf_saadc_value_t Convert(const nrf_saadc_channel_config_t &channel)
+{
+  const int pin = InputToArduinoPin(channel.pin_p);
+  const int numSamples = 1 << sSaadc.oversample;
+  const int maxValue = (1 << (8 + 2 * sSaadc.resolution)) - 1;
+
+  // Inputs are set in 10-bit units, the noise in 12-bit ones.
+  int64_t sum = 0;
+  for (int i = 0; i < numSamples; ++i) {
+    const int value = (pin < 0) ? 0 : (analogRead(pin) * 4095 + 511) / 1023 + Noise(pin);
+    const int scaled = (value * maxValue + 2047) / 4095;
+    sum += (scaled < 0) ? 0 : (scaled > maxValue) ? maxValue : scaled;
+  }
+  return static_cast<nrf_saadc_value_t>((sum + numSamples / 2) / numSamples);
+}
+
+/* Scan the enabled channels, writing the results once their conversions are done. */
+void Sample()
+{
+  if (!sSaadc.enabled || !sSaadc.started || sSaadc.busy) {
+    return;
+  }
+  std::vector<nrf_saadc_value_t> results;
+  uint32_t duration = 0;
+  for (const auto &channel : sSaadc.channels) {
+    if (channel.pin_p == NRF_SAADC_INPUT_DISABLED) {
+      continue;
+    }
+    results.push_back(Convert(channel));
+    const int numSamples = (channel.burst == NRF_SAADC_BURST_ENABLED) ? (1 << sSaadc.oversample) : 1;
+    duration += numSamples * (kAcquisitionTimesUs[channel.acq_time] + kConversionTimeUs);
+  }
+
+  sSaadc.busy = true;
+  sim::Schedule(duration, [results]() {
+    sSaadc.busy = false;
+    for (auto result : results) {
+      if (sSaadc.started && (sSaadc.amount < sSaadc.maxCount)) {
+        sSaadc.buffer[sSaadc.amount++] = result;
+      }
+    }
+    Raise(NRF_SAADC_EVENT_DONE);
+    Raise(NRF_SAADC_EVENT_RESULTDONE);
+    if (sSaadc.started && (sSaadc.amount >= sSaadc.maxCount)) {
+      // The buffer is full : samples are ignored until the next START.
+      sSaadc.started = false;
+      Raise(NRF_SAADC_EVENT_END);
+    }
+  });
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* Trigger the task at @p address, of the SAADC or of a TIMER. */
+void TriggerTask(uint32_t address)
+{
+  const uint32_t base = address & ~0xFFFu;
+  if (base == NRF_SAADC_BASE) {
+    nrf_saadc_task_trigger(static_cast<nrf_saadc_task_t>(address - base));
+  } else if (sTimers.count(base)) {
+    nrf_timer_task_trigger(reinterpret_cast<NRF_TIMER_Type*>(base), static_cast<nrf_timer_task_t>(address - base));
+  }
+}
+
+/* Trigger the tasks connected to the event at @p address. */
+void PublishEvent(uint32_t address)
+{
+  for (const auto &channel : sPpiChannels) {
+    if (channel.enabled && (channel.eep == address)) {
+      TriggerTask(channel.tep);
+    }
+  }
+}
+
+NrfTimer& GetTimer(NRF_TIMER_Type *p_reg)
+{
+  return sTimers[reinterpret_cast<uintptr_t>(p_reg)];
+}
+
+/* Duration of @p ticks of @p timer, in microseconds. */
+uint32_t TicksToUs(const NrfTimer &timer, uint32_t ticks)
+{
+  return static_cast<uint32_t>((uint64_t(ticks) << timer.frequency) / 16);
+}
+
+void StopTimer(NrfTimer &timer)
+{
+  if (timer.compareId) {
+    sim::Cancel(timer.compareId);
+    timer.compareId = 0;
+  }
+}
+
+/* Schedule the next COMPARE0 of the timer at @p p_reg, counting from 0. */
+void StartTimer(NRF_TIMER_Type *p_reg)
+{
+  NrfTimer &timer = GetTimer(p_reg);
+  StopTimer(timer);
+  if (timer.cc0 == 0) {
+    return;
+  }
+  const bool repeat = (timer.shorts & NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK)
+                  && !(timer.shorts & NRF_TIMER_SHORT_COMPARE0_STOP_MASK);
+  const uint32_t periodUs = TicksToUs(timer, timer.cc0);
+  timer.compareId = sim::Post(&timer, UINT_MAX, periodUs, repeat ? periodUs : 0, [p_reg, repeat]() {
+    NrfTimer &timer = GetTimer(p_reg);
+    timer.compareId = repeat ? timer.compareId : 0;
+    timer.events |= 1u << 0;
+    PublishEvent(nrf_timer_event_address_get(p_reg, NRF_TIMER_EVENT_COMPARE0));
+  });
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+void sim::SetAnalogNoise(int pin, int amplitude)
+{
+  sNoises[pin] = amplitude;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void NVIC_SetVector(IRQn_Type irq, uintptr_t vector)
+{
+  sNvic.vector = reinterpret_cast<void (*)()>(vector);
+}
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) {}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+  sNvic.enabled = true;
+  UpdateInterrupt();
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq)
+{
+  sNvic.enabled = false;
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq) {}
+
+/* -------------------------------------------------------------------------- */
+
+void nrf_saadc_enable(void)
+{
+  sSaadc.enabled = true;
+}
+
+void nrf_saadc_disable(void)
+{
+  sSaadc.enabled = false;
+  sSaadc.started = false;
+}
+
+bool nrf_saadc_enable_check(void)
+{
+  return sSaadc.enabled;
+}
+
+void nrf_saadc_resolution_set(nrf_saadc_resolution_t resolution)
+{
+  sSaadc.resolution = resolution;
+}
+
+void nrf_saadc_oversample_set(nrf_saadc_oversample_t oversample)
+{
+  sSaadc.oversample = oversample;
+}
+
+void nrf_saadc_channel_init(uint8_t channel, nrf_saadc_channel_config_t const *config)
+{
+  MBED_ASSERT(channel < NRF_SAADC_CHANNEL_COUNT);
+  sSaadc.channels[channel] = *config;
+}
+
+void nrf_saadc_channel_input_set(uint8_t channel, nrf_saadc_input_t pselp, nrf_saadc_input_t pseln)
+{
+  MBED_ASSERT(channel < NRF_SAADC_CHANNEL_COUNT);
+  sSaadc.channels[channel].pin_p = pselp;
+  sSaadc.channels[channel].pin_n = pseln;
+}
+
+void nrf_saadc_buffer_init(nrf_saadc_value_t *buffer, uint32_t num)
+{
+  sSaadc.nextBuffer   = buffer;
+  sSaadc.nextMaxCount = num;
+}
+
+uint16_t nrf_saadc_amount_get(void)
+{
+  return static_cast<uint16_t>(sSaadc.amount);
+}
+
+void nrf_saadc_task_trigger(nrf_saadc_task_t task)
+{
+  if (!sSaadc.enabled) {
+    return;
+  }
+  switch (task) {
+    case NRF_SAADC_TASK_START:
+      sSaadc.buffer   = sSaadc.nextBuffer;
+      sSaadc.maxCount = sSaadc.nextMaxCount;
+      sSaadc.amount   = 0;
+      sSaadc.started  = true;
+      Raise(NRF_SAADC_EVENT_STARTED);
+    break;
+
+    case NRF_SAADC_TASK_SAMPLE:
+      Sample();
+    break;
+
+    case NRF_SAADC_TASK_STOP:
+      if (sSaadc.started) {
+        sSaadc.started = false;
+        Raise(NRF_SAADC_EVENT_END);
+      }
+      Raise(NRF_SAADC_EVENT_STOPPED);
+    break;
+
+    case NRF_SAADC_TASK_CALIBRATEOFFSET:
+      Raise(NRF_SAADC_EVENT_CALIBRATEDONE);
+    break;
+  }
+}
+
+uint32_t nrf_saadc_task_address_get(nrf_saadc_task_t task)
+{
+  return NRF_SAADC_BASE + task;
+}
+
+bool nrf_saadc_event_check(nrf_saadc_event_t event)
+{
+  return (sSaadc.events & EventBit(event)) != 0;
+}
+
+void nrf_saadc_event_clear(nrf_saadc_event_t event)
+{
+  sSaadc.events &= ~EventBit(event);
+}
+
+void nrf_saadc_int_enable(uint32_t mask)
+{
+  sSaadc.interrupts |= mask;
+  UpdateInterrupt();
+}
+
+void nrf_saadc_int_disable(uint32_t mask)
+{
+  sSaadc.interrupts &= ~mask;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void nrf_timer_task_trigger(NRF_TIMER_Type *p_reg, nrf_timer_task_t task)
+{
+  NrfTimer &timer = GetTimer(p_reg);
+  switch (task) {
+    case NRF_TIMER_TASK_START:
+      if (!timer.compareId) {
+        StartTimer(p_reg);
+      }
+    break;
+
+    case NRF_TIMER_TASK_STOP:
+    case NRF_TIMER_TASK_SHUTDOWN:
+      StopTimer(timer);
+    break;
+
+    case NRF_TIMER_TASK_CLEAR:
+      if (timer.compareId) {
+        StartTimer(p_reg);
+      }
+    break;
+
+    default:
+    break;
+  }
+}
+
+uint32_t nrf_timer_event_address_get(NRF_TIMER_Type *p_reg, nrf_timer_event_t event)
+{
+  return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(p_reg)) + event;
+}
+
+bool nrf_timer_event_check(NRF_TIMER_Type *p_reg, nrf_timer_event_t event)
+{
+  return (GetTimer(p_reg).events & (1u << ((event - NRF_TIMER_EVENT_COMPARE0) / 4))) != 0;
+}
+
+void nrf_timer_event_clear(NRF_TIMER_Type *p_reg, nrf_timer_event_t event)
+{
+  GetTimer(p_reg).events &= ~(1u << ((event - NRF_TIMER_EVENT_COMPARE0) / 4));
+}
+
+void nrf_timer_shorts_enable(NRF_TIMER_Type *p_reg, uint32_t mask)
+{
+  GetTimer(p_reg).shorts |= mask;
+}
+
+void nrf_timer_shorts_disable(NRF_TIMER_Type *p_reg, uint32_t mask)
+{
+  GetTimer(p_reg).shorts &= ~mask;
+}
+
+void nrf_timer_mode_set(NRF_TIMER_Type *p_reg, nrf_timer_mode_t mode)
+{
+  MBED_ASSERT(mode == NRF_TIMER_MODE_TIMER);
+}
+
+void nrf_timer_bit_width_set(NRF_TIMER_Type *p_reg, nrf_timer_bit_width_t bit_width) {}
+
+void nrf_timer_frequency_set(NRF_TIMER_Type *p_reg, nrf_timer_frequency_t frequency)
+{
+  GetTimer(p_reg).frequency = frequency;
+}
+
+void nrf_timer_cc_write(NRF_TIMER_Type *p_reg, nrf_timer_cc_channel_t cc_channel, uint32_t cc_value)
+{
+  if (cc_channel == NRF_TIMER_CC_CHANNEL0) {
+    GetTimer(p_reg).cc0 = cc_value;
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void nrf_ppi_channel_endpoint_setup(nrf_ppi_channel_t channel, uint32_t eep, uint32_t tep)
+{
+  MBED_ASSERT(channel < PPI_CH_NUM);
+  sPpiChannels[channel].eep = eep;
+  sPpiChannels[channel].tep = tep;
+}
+
+void nrf_ppi_channel_enable(nrf_ppi_channel_t channel)
+{
+  MBED_ASSERT(channel < PPI_CH_NUM);
+  sPpiChannels[channel].enabled = true;
+}
+
+void nrf_ppi_channel_disable(nrf_ppi_channel_t channel)
+{
+  MBED_ASSERT(channel < PPI_CH_NUM);
+  sPpiChannels[channel].enabled = false;
+}
+
+/* -------------------------------------------------------------------------- */
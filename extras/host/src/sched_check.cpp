@@ -0,0 +1,99 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+#include "Nano33BleHID.h"
+#include "sim/simulator.h"
+
+/* -------------------------------------------------------------------------- */
+//
+// Check the scheduling of the update task on the simulated timeline.
+//
+//  interval : with the default POLLING_CONNECTION_INTERVAL mode, a sketch
+//             sending a report on each run must run, and notify, once per
+//             connection interval, for several intervals.
+//
+// Each run happens in a child process, the simulation being global.
+// Exits with 1 when a check fails.
+//
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+constexpr uint32_t kDurationMs  = 3000;
+constexpr uint32_t kSettleMs    = 1000;   // Connection and link negotiation, excluded.
+constexpr double kRateTolerance = 0.05;   // Relative to the connection event rate.
+
+const uint32_t kIntervals[] = { 7500, 15000, 30000, 50000 };
+
+Nano33BleMouse sMouse("sched_check");
+unsigned sNumRuns = 0;
+
+/* Rate of the notifications received after the settling time, in Hz. */
+double NotificationRate()
+{
+  unsigned count = 0;
+  for (const auto &notification : sim::Notifications()) {
+    count += (notification.timestamp >= kSettleMs * 1000uLL) ? 1 : 0;
+  }
+  return count / ((kDurationMs - kSettleMs) / 1000.0);
+}
+
+/* Run the sketch with a connection @p interval, return true when the rate follows it. */
+bool RunInterval(uint32_t interval)
+{
+  auto &config = sim::GetConfig();
+  config.durationMs         = kDurationMs;
+  config.connectionInterval = interval;
+
+  setup();
+
+  const double expected = 1.0e6 / interval;
+  const double rate     = NotificationRate();
+  const bool ok = fabs(rate - expected) <= kRateTolerance * expected;
+  printf("%-9s %s  %5.1f ms : %6.1f reports/s for %6.1f, %u runs\n", "interval",
+         ok ? "ok  " : "FAIL", interval / 1000.0, rate, expected, sNumRuns);
+  return ok;
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+void setup()
+{
+  sMouse.initialize();
+  MbedBleHID_RunEventThread();
+}
+
+void loop()
+{
+  ++sNumRuns;
+  if (!sMouse.connected()) {
+    return;
+  }
+  auto *mouse = sMouse.hid();
+  mouse->motion(0.1f, 0.0f);
+  mouse->SendReport();
+}
+
+int main(int argc, char *argv[])
+{
+  bool ok = true;
+  for (uint32_t interval : kIntervals) {
+    fflush(stdout);
+    const pid_t pid = fork();
+    if (pid == 0) {
+      exit(RunInterval(interval) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    int status = 0;
+    ok &= (pid > 0) && (waitpid(pid, &status, 0) == pid)
+       && WIFEXITED(status) && (WEXITSTATUS(status) == EXIT_SUCCESS);
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* -------------------------------------------------------------------------- */
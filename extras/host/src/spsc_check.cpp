@@ -0,0 +1,161 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "Arduino.h"
+#include "Nano33BleHID.h"
+#include "spsc_queue.h"
+#include "sim/simulator.h"
+
+/* -------------------------------------------------------------------------- */
+//
+// Check the SpscQueue against a producer thread, built with ThreadSanitizer.
+//
+//  queue  : items pushed by a thread and popped by another arrive in order,
+//           untorn and without loss (the producer retrying when full).
+//  mouse  : button changes posted by a thread with HIDMouseService::postButton
+//           are sent by the update task, in order and without loss, between
+//           the reports of the sketch.
+//
+// Exits with 1 when a check fails, or on a data race reported by the sanitizer.
+//
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+constexpr uint32_t kNumItems        = 1000000;
+constexpr uint32_t kNumButtonEvents = 2000;
+constexpr uint32_t kDurationMs      = 600000;   // Upper bound of the simulated run.
+
+bool Report(const char *name, bool ok, const char *format, double a, double b)
+{
+  printf("%-9s %s  ", name, ok ? "ok  " : "FAIL");
+  printf(format, a, b);
+  printf("\n");
+  return ok;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* Item whose halves are written separately, to detect a torn read. */
+struct Item {
+  uint32_t sequence;
+  uint32_t check;
+};
+
+bool CheckQueue()
+{
+  static SpscQueue<Item, 64> queue;
+
+  std::thread producer([]() {
+    for (uint32_t i = 0; i < kNumItems; ++i) {
+      while (!queue.push(Item{ i, ~i })) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint32_t expected = 0;
+  uint32_t errors   = 0;
+  while (expected < kNumItems) {
+    Item item;
+    if (!queue.pop(item)) {
+      std::this_thread::yield();
+      continue;
+    }
+    errors += ((item.sequence != expected) || (item.check != ~expected)) ? 1 : 0;
+    expected = item.sequence + 1;
+  }
+  producer.join();
+
+  return Report("queue", (errors == 0) && queue.empty(), "%.0f errors over %.0f items", errors, kNumItems);
+}
+
+/* -------------------------------------------------------------------------- */
+
+Nano33BleMouse sMouse("spsc_check");
+
+std::atomic<bool> sConnected{ false };
+std::atomic<bool> sProducerDone{ false };
+uint32_t sStopTime = 0;
+
+/* Post alternate presses and releases of the left button, retrying when full. */
+void ProduceButtonEvents()
+{
+  while (!sConnected) {
+    std::this_thread::yield();
+  }
+  auto *mouse = sMouse.hid();
+  for (uint32_t i = 0; i < kNumButtonEvents; ++i) {
+    const auto buttons = (i & 1) ? HIDMouseService::BUTTON_NONE : HIDMouseService::BUTTON_LEFT;
+    while (!mouse->postButton(buttons)) {
+      std::this_thread::yield();
+    }
+  }
+  sProducerDone = true;
+}
+
+bool CheckMouse()
+{
+  sim::GetConfig().durationMs = kDurationMs;
+
+  std::thread producer(ProduceButtonEvents);
+  setup();
+  sConnected = true;   // (unblock the producer when the host never connected)
+  producer.join();
+
+  // Button changes seen by the host, the sketch reports repeating the state.
+  uint32_t changes = 0;
+  uint32_t moves   = 0;
+  uint8_t last     = HIDMouseService::BUTTON_NONE;
+  for (const auto &notification : sim::Notifications()) {
+    const uint8_t buttons = notification.data[0];
+    changes += (buttons != last) ? 1 : 0;
+    moves   += ((buttons != last) && (notification.data[1] || notification.data[2])) ? 1 : 0;
+    last = buttons;
+  }
+  const bool ok = (changes == kNumButtonEvents) && (moves == 0);
+  return Report("mouse", ok, "%.0f button changes received for %.0f posted", changes, kNumButtonEvents);
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+void setup()
+{
+  sMouse.initialize();
+  MbedBleHID_RunEventThread();
+}
+
+void loop()
+{
+  if (!sMouse.connected()) {
+    return;
+  }
+  sConnected = true;
+
+  // Sketch reports, moving the pointer between the button events.
+  auto *mouse = sMouse.hid();
+  mouse->motionCounts(1, 0);
+  mouse->SendReport();
+
+  // Stop a second after the last event was posted, once drained.
+  if (sProducerDone && !sStopTime) {
+    sStopTime = millis() + 1000;
+  }
+  if (sStopTime && (millis() >= sStopTime)) {
+    sim::Stop();
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  bool ok = true;
+  ok &= CheckQueue();
+  ok &= CheckMouse();
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* -------------------------------------------------------------------------- */
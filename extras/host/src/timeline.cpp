@@ -0,0 +1,147 @@
+#include <map>
+#include <tuple>
+
+#include "sim/simulator.h"
+
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+struct Event {
+  int id;
+  const void *queue;
+  uint32_t period;
+  std::function<void()> fn;
+};
+
+/* Pending events ordered by time, then by posting order. */
+std::map<std::tuple<uint64_t, int>, Event> sEvents;
+std::map<const void*, unsigned> sQueueSizes;
+std::vector<std::function<void()>> sThreads;
+
+uint64_t sNow    = 0;
+int sNextEventId = 1;
+bool sRunning    = false;
+bool sStopped    = false;
+
+int Insert(uint64_t time, Event event)
+{
+  if (event.queue) {
+    ++sQueueSizes[event.queue];
+  }
+  const int id = event.id;
+  sEvents.emplace(std::make_tuple(time, id), std::move(event));
+  return id;
+}
+
+void Release(const Event &event)
+{
+  if (event.queue) {
+    --sQueueSizes[event.queue];
+  }
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+namespace sim {
+
+Config& GetConfig()
+{
+  static Config sConfig;
+  return sConfig;
+}
+
+uint64_t Now()
+{
+  return sNow;
+}
+
+void Advance(uint64_t us)
+{
+  sNow += us;
+}
+
+int Post(const void *queue, unsigned capacity, uint64_t delay, uint32_t period, std::function<void()> fn)
+{
+  if (sQueueSizes[queue] >= capacity) {
+    return 0;
+  }
+  return Insert(sNow + delay, { sNextEventId++, queue, period, std::move(fn) });
+}
+
+int Schedule(uint64_t delay, std::function<void()> fn)
+{
+  return Insert(sNow + delay, { sNextEventId++, nullptr, 0, std::move(fn) });
+}
+
+bool Cancel(int id)
+{
+  for (auto it = sEvents.begin(); it != sEvents.end(); ++it) {
+    if (it->second.id == id) {
+      Release(it->second);
+      sEvents.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
+void Run(int ms)
+{
+  RunUntil((ms < 0) ? GetConfig().durationMs * 1000uLL : sNow + ms * 1000uLL);
+}
+
+void RunUntil(uint64_t end)
+{
+  // Events run by the events are processed by the outer loop.
+  if (sRunning) {
+    return;
+  }
+  sRunning = true;
+  sStopped = false;
+
+  while (!sStopped && !sEvents.empty() && (std::get<0>(sEvents.begin()->first) <= end)) {
+    auto node = sEvents.begin();
+    const uint64_t time = std::get<0>(node->first);
+    Event event = std::move(node->second);
+    sEvents.erase(node);
+    Release(event);
+
+    // (tasks blocking with delay() may have advanced the time already)
+    sNow = (time > sNow) ? time : sNow;
+
+    // Periodic events keep their id, so they can still be cancelled.
+    if (event.period) {
+      Insert(time + event.period, event);
+    }
+    event.fn();
+  }
+  sNow = (sStopped || (end < sNow)) ? sNow : end;
+  sRunning = false;
+}
+
+void Stop()
+{
+  sStopped = true;
+}
+
+void StartThread(std::function<void()> task)
+{
+  sThreads.push_back(std::move(task));
+}
+
+void RunThreads()
+{
+  // Threads run the event queues, which share the same timeline.
+  while (!sThreads.empty()) {
+    auto task = std::move(sThreads.front());
+    sThreads.erase(sThreads.begin());
+    task();
+  }
+}
+
+} // namespace sim
+
+/* -------------------------------------------------------------------------- */
@@ -0,0 +1,189 @@
+#include "uhid.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+
+/* -------------------------------------------------------------------------- */
+
+namespace uhid {
+
+int Create(const std::string &name, unsigned index, const uint8_t *reportMap, uint16_t length)
+{
+  const int fd = open("/dev/uhid", O_RDWR | O_CLOEXEC | O_NONBLOCK);
+  if (fd < 0) {
+    fprintf(stderr, "could not open /dev/uhid : %s\n", strerror(errno));
+    return -1;
+  }
+
+  uhid_event ev{};
+  ev.type = UHID_CREATE2;
+  snprintf(reinterpret_cast<char*>(ev.u.create2.name), sizeof(ev.u.create2.name), "%s", name.c_str());
+  snprintf(reinterpret_cast<char*>(ev.u.create2.phys), sizeof(ev.u.create2.phys), "mbed-ble-hid/uhid%u", index);
+  ev.u.create2.rd_size = std::min<size_t>(length, sizeof(ev.u.create2.rd_data));
+  ev.u.create2.bus     = BUS_BLUETOOTH;
+  memcpy(ev.u.create2.rd_data, reportMap, ev.u.create2.rd_size);
+
+  if (!WriteEvent(fd, ev)) {
+    fprintf(stderr, "could not create the uhid device : %s\n", strerror(errno));
+    close(fd);
+    return -1;
+  }
+  fprintf(stderr, "created \"%s\" (%u bytes report map)\n", name.c_str(), ev.u.create2.rd_size);
+  return fd;
+}
+
+void Destroy(int fd)
+{
+  uhid_event ev{};
+  ev.type = UHID_DESTROY;
+  WriteEvent(fd, ev);
+  close(fd);
+}
+
+bool Input(int fd, uint8_t reportID, const uint8_t *data, size_t size)
+{
+  uhid_event ev{};
+  ev.type = UHID_INPUT2;
+  const size_t prefix = (reportID != 0) ? 1 : 0;
+  ev.u.input2.data[0] = reportID;
+  ev.u.input2.size    = std::min<size_t>(size + prefix, sizeof(ev.u.input2.data));
+  memcpy(ev.u.input2.data + prefix, data, ev.u.input2.size - prefix);
+  return WriteEvent(fd, ev);
+}
+
+bool WriteEvent(int fd, const uhid_event &ev)
+{
+  return write(fd, &ev, sizeof(ev)) == static_cast<ssize_t>(sizeof(ev));
+}
+
+bool ReadEvent(int fd, uhid_event &ev)
+{
+  return read(fd, &ev, sizeof(ev)) > 0;
+}
+
+void RejectRequest(int fd, const uhid_event &ev)
+{
+  uhid_event reply{};
+  if (ev.type == UHID_GET_REPORT) {
+    reply.type = UHID_GET_REPORT_REPLY;
+    reply.u.get_report_reply.id  = ev.u.get_report.id;
+    reply.u.get_report_reply.err = EIO;
+  } else if (ev.type == UHID_SET_REPORT) {
+    reply.type = UHID_SET_REPORT_REPLY;
+    reply.u.set_report_reply.id  = ev.u.set_report.id;
+    reply.u.set_report_reply.err = EIO;
+  } else {
+    return;
+  }
+  WriteEvent(fd, reply);
+}
+
+/* -------------------------------------------------------------------------- */
+
+std::vector<int> OpenInputDevices(unsigned index)
+{
+  std::vector<int> evdevs;
+  DIR *dir = opendir("/dev/input");
+  if (!dir) {
+    return evdevs;
+  }
+
+  // The input devices share the physical path of their HID device.
+  const std::string phys = "mbed-ble-hid/uhid" + std::to_string(index);
+  while (dirent *entry = readdir(dir)) {
+    if (strncmp(entry->d_name, "event", 5)) {
+      continue;
+    }
+    const std::string path = std::string("/dev/input/") + entry->d_name;
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    if (fd < 0) {
+      continue;
+    }
+    char evdevPhys[256]{};
+    ioctl(fd, EVIOCGPHYS(sizeof(evdevPhys) - 1), evdevPhys);
+
+    const char next = evdevPhys[std::min(phys.size(), sizeof(evdevPhys) - 1)];
+    if (!strncmp(evdevPhys, phys.c_str(), phys.size()) && ((next == '\0') || (next == '/'))) {
+      int clock = CLOCK_MONOTONIC;
+      ioctl(fd, EVIOCSCLOCKID, &clock);
+      evdevs.push_back(fd);
+
+      char name[256]{};
+      ioctl(fd, EVIOCGNAME(sizeof(name) - 1), name);
+      fprintf(stderr, "reading %s (%s)\n", path.c_str(), name);
+    } else {
+      close(fd);
+    }
+  }
+  closedir(dir);
+  return evdevs;
+}
+
+void FlushInputEvents(const std::vector<int> &evdevs)
+{
+  input_event events[64];
+  for (int evdev : evdevs) {
+    while (read(evdev, events, sizeof(events)) > 0) {}
+  }
+}
+
+uint64_t WaitInputEvents(const std::vector<int> &evdevs, int timeoutMs)
+{
+  std::vector<pollfd> fds;
+  for (int evdev : evdevs) {
+    fds.push_back({ evdev, POLLIN, 0 });
+  }
+  if (fds.empty() || (poll(fds.data(), fds.size(), timeoutMs) <= 0)) {
+    return 0;
+  }
+
+  uint64_t first = 0;
+  input_event events[64];
+  for (const auto &pfd : fds) {
+    ssize_t bytes;
+    while ((bytes = read(pfd.fd, events, sizeof(events))) > 0) {
+      for (size_t i = 0; i < bytes / sizeof(input_event); ++i) {
+        const uint64_t t = events[i].input_event_sec * 1000000uLL + events[i].input_event_usec;
+        first = (!first || (t < first)) ? t : first;
+      }
+    }
+  }
+  return first;
+}
+
+uint64_t MonotonicTime()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000uLL + ts.tv_nsec / 1000;
+}
+
+void LatencyStats::print()
+{
+  if (latencies_.empty()) {
+    fprintf(stderr, "no injection latency measured (%u reports without events)\n", missed_);
+    return;
+  }
+  std::sort(latencies_.begin(), latencies_.end());
+  auto percentile = [this](float p) {
+    return latencies_[static_cast<size_t>(p * (latencies_.size() - 1))];
+  };
+  printf("injection latency (us) : count %u  min %u  p50 %u  p99 %u  max %u  (%u reports without events)\n",
+    static_cast<unsigned>(latencies_.size()), latencies_.front(), percentile(0.5f), percentile(0.99f),
+    latencies_.back(), missed_
+  );
+}
+
+} // namespace uhid
+
+/* -------------------------------------------------------------------------- */
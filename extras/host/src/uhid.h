@@ -0,0 +1,69 @@
+#ifndef HOST_UHID_H_
+#define HOST_UHID_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <linux/uhid.h>
+
+/* -------------------------------------------------------------------------- */
+//
+// Minimal /dev/uhid device helpers, shared by the host tools.
+//
+/* -------------------------------------------------------------------------- */
+
+namespace uhid {
+
+/**
+ * Create a local HID device from @p reportMap, return its file descriptor or -1.
+ * Its physical path is "mbed-ble-hid/uhid<index>".
+ */
+int Create(const std::string &name, unsigned index, const uint8_t *reportMap, uint16_t length);
+
+/** Remove the device and close @p fd. */
+void Destroy(int fd);
+
+/** Inject an input report, prefixed with @p reportID when not 0. */
+bool Input(int fd, uint8_t reportID, const uint8_t *data, size_t size);
+
+bool WriteEvent(int fd, const uhid_event &ev);
+
+/** Read the next request of the kernel without blocking, return false when there is none. */
+bool ReadEvent(int fd, uhid_event &ev);
+
+/** Answer a get or set report request with an error, when there is nothing to forward it to. */
+void RejectRequest(int fd, const uhid_event &ev);
+
+// -- Input devices created by the kernel, to measure the injection latency --
+
+/** Open the evdev nodes of the device @p index, timestamped on CLOCK_MONOTONIC. */
+std::vector<int> OpenInputDevices(unsigned index);
+
+/** Drop the pending events. */
+void FlushInputEvents(const std::vector<int> &evdevs);
+
+/** Wait up to @p timeoutMs for events, return the timestamp of the first one or 0. */
+uint64_t WaitInputEvents(const std::vector<int> &evdevs, int timeoutMs);
+
+/** Monotonic time in microseconds, the time base of the input events. */
+uint64_t MonotonicTime();
+
+/** Injection latencies, from the input report write to the first evdev event. */
+class LatencyStats {
+ public:
+  void add(uint32_t latency) { latencies_.push_back(latency); }
+  void miss() { ++missed_; }
+  void print();
+
+ private:
+  std::vector<uint32_t> latencies_;
+  unsigned missed_ = 0;
+};
+
+} // namespace uhid
+
+/* -------------------------------------------------------------------------- */
+
+#endif // HOST_UHID_H_
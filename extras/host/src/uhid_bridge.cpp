@@ -0,0 +1,391 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "Arduino.h"
+#include "ble/BLE.h"
+#include "uhid.h"
+
+/* -------------------------------------------------------------------------- */
+//
+// Replay the reports of a sketch through /dev/uhid, so the local kernel HID
+// stack parses them as it would for the real device.
+//
+// Each HID service of the sketch becomes a uhid device created from its report
+// map. In live mode the simulated timeline is paced on the wall clock and the
+// notifications are injected as the host receives them, in replay mode they
+// are read from a capture written with --csv. Output and feature reports from
+// the kernel are forwarded to the device.
+//
+// When the input devices created by the kernel can be opened, the injection
+// latency is measured up to the evdev events.
+//
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+// Report types of the Report Reference descriptors.
+enum ReportType : uint8_t {
+  INPUT_REPORT   = 1,
+  OUTPUT_REPORT  = 2,
+  FEATURE_REPORT = 3,
+};
+
+struct Device {
+  int fd = -1;
+  std::vector<sim::Report> reports;
+  std::vector<int> evdevs;
+};
+
+struct Options {
+  const char *replayFilename = nullptr;
+  bool latency = true;
+};
+
+std::vector<Device> sDevices;
+uhid::LatencyStats sLatencies;
+uint64_t sWallStart = 0;
+
+/* Time waited for the evdev events of a report when measuring the latency. */
+const int kEvdevTimeoutMs = 5;
+
+void SleepUntil(uint64_t wallTime)
+{
+  const uint64_t now = uhid::MonotonicTime();
+  if (wallTime > now) {
+    usleep(static_cast<useconds_t>(wallTime - now));
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool CreateDevices(const std::string &name)
+{
+  for (auto &service : sim::HIDServices()) {
+    const unsigned index = sDevices.size();
+    Device device;
+    device.fd = uhid::Create(
+      name + ((index > 0) ? " " + std::to_string(index) : ""), index,
+      service.reportMap->value, service.reportMap->length
+    );
+    if (device.fd < 0) {
+      return false;
+    }
+    device.reports = std::move(service.reports);
+    sDevices.push_back(std::move(device));
+  }
+  return !sDevices.empty();
+}
+
+void DestroyDevices()
+{
+  for (auto &device : sDevices) {
+    for (int evdev : device.evdevs) {
+      close(evdev);
+    }
+    uhid::Destroy(device.fd);
+  }
+  sDevices.clear();
+}
+
+/* Open the input devices the kernel created for each uhid device. */
+void OpenInputDevices()
+{
+  for (size_t i = 0; i < sDevices.size(); ++i) {
+    if (sDevices[i].evdevs.empty()) {
+      sDevices[i].evdevs = uhid::OpenInputDevices(i);
+    }
+  }
+}
+
+const sim::Report* FindReport(const Device &device, uint8_t type, uint8_t id)
+{
+  for (const auto &report : device.reports) {
+    if ((report.type == type) && (report.id == id)) {
+      return &report;
+    }
+  }
+  return nullptr;
+}
+
+/* Forward the requests of the kernel to the device. */
+void ProcessHostEvents()
+{
+  for (auto &device : sDevices) {
+    uhid_event ev;
+    while (uhid::ReadEvent(device.fd, ev)) {
+      switch (ev.type) {
+        case UHID_OUTPUT: {
+          // Numbered reports are prefixed with their ID, which is not part of the characteristic value.
+          const sim::Report *report = FindReport(device, OUTPUT_REPORT, 0);
+          const uint8_t *data = ev.u.output.data;
+          uint16_t size       = ev.u.output.size;
+          if (!report && size) {
+            report = FindReport(device, OUTPUT_REPORT, data[0]);
+            ++data;
+            --size;
+          }
+          if (report) {
+            sim::HostWrite(report->handle, data, size);
+          }
+        }
+        break;
+
+        case UHID_GET_REPORT: {
+          const uint8_t type = (ev.u.get_report.rtype == UHID_FEATURE_REPORT) ? FEATURE_REPORT
+                             : (ev.u.get_report.rtype == UHID_OUTPUT_REPORT) ? OUTPUT_REPORT
+                             : INPUT_REPORT;
+          const sim::Report *report = FindReport(device, type, ev.u.get_report.rnum);
+          const sim::Attribute *attribute = report ? sim::FindAttribute(report->handle) : nullptr;
+          if (!attribute) {
+            uhid::RejectRequest(device.fd, ev);
+            break;
+          }
+          uhid_event reply{};
+          reply.type = UHID_GET_REPORT_REPLY;
+          reply.u.get_report_reply.id = ev.u.get_report.id;
+          const bool bNumbered = (report->id != 0);
+          reply.u.get_report_reply.data[0] = report->id;
+          memcpy(reply.u.get_report_reply.data + bNumbered, attribute->value, attribute->length);
+          reply.u.get_report_reply.size = attribute->length + bNumbered;
+          uhid::WriteEvent(device.fd, reply);
+        }
+        break;
+
+        case UHID_SET_REPORT: {
+          const sim::Report *report = FindReport(device, FEATURE_REPORT, ev.u.set_report.rnum);
+          if (!report) {
+            uhid::RejectRequest(device.fd, ev);
+            break;
+          }
+          const bool bNumbered = (report->id != 0);
+          sim::HostWrite(report->handle, ev.u.set_report.data + bNumbered, ev.u.set_report.size - bNumbered);
+
+          uhid_event reply{};
+          reply.type = UHID_SET_REPORT_REPLY;
+          reply.u.set_report_reply.id = ev.u.set_report.id;
+          uhid::WriteEvent(device.fd, reply);
+        }
+        break;
+
+        default:
+        break;
+      }
+    }
+  }
+}
+
+/* Inject an input report notified on @p handle, measuring its latency. */
+void Inject(uint16_t handle, const uint8_t *data, size_t size, bool latency)
+{
+  for (auto &device : sDevices) {
+    for (const auto &report : device.reports) {
+      if (report.handle != handle) {
+        continue;
+      }
+      if (latency) {
+        uhid::FlushInputEvents(device.evdevs);
+      }
+      const uint64_t t = uhid::MonotonicTime();
+      if (!uhid::Input(device.fd, report.id, data, size)) {
+        fprintf(stderr, "could not inject a report : %s\n", strerror(errno));
+        return;
+      }
+      if (latency && !device.evdevs.empty()) {
+        // Reports identical to the previous one produce no event.
+        const uint64_t eventTime = uhid::WaitInputEvents(device.evdevs, kEvdevTimeoutMs);
+        if (eventTime >= t) {
+          sLatencies.add(static_cast<uint32_t>(eventTime - t));
+        } else {
+          sLatencies.miss();
+        }
+      }
+      return;
+    }
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* Keep the simulated timeline on the wall clock, once the devices exist. */
+void PaceTask(const std::string &name, bool latency)
+{
+  static bool sCreated = false;
+  if (!sCreated && !sim::Attributes().empty()) {
+    if (!CreateDevices(name)) {
+      exit(EXIT_FAILURE);
+    }
+    sCreated   = true;
+    sWallStart = uhid::MonotonicTime() - sim::Now();
+  }
+
+  if (sCreated) {
+    SleepUntil(sWallStart + sim::Now());
+    ProcessHostEvents();
+
+    // The kernel creates the input devices shortly after the uhid ones.
+    static uint64_t sLookupTime = 0;
+    if (latency && (sim::Now() >= sLookupTime) && (sim::Now() < 2000000uLL)) {
+      OpenInputDevices();
+      sLookupTime = sim::Now() + 200000uLL;
+    }
+  }
+  sim::Schedule(1000, [name, latency]() { PaceTask(name, latency); });
+}
+
+/* Inject the notifications of a capture written with --csv, at their pace. */
+bool Replay(const char *filename, bool latency)
+{
+  FILE *fd = fopen(filename, "r");
+  if (!fd) {
+    fprintf(stderr, "could not read %s\n", filename);
+    return false;
+  }
+
+  char line[2 * UHID_DATA_MAX + 64];
+  uint64_t firstTimestamp = 0;
+  bool bFirst = true;
+  unsigned count = 0;
+
+  while (fgets(line, sizeof(line), fd)) {
+    unsigned long long timestamp;
+    unsigned connection, handle;
+    char hex[2 * UHID_DATA_MAX + 1];
+    if (sscanf(line, "%llu,%u,%u,%8192s", &timestamp, &connection, &handle, hex) != 4) {
+      continue; // header.
+    }
+    uint8_t data[UHID_DATA_MAX];
+    size_t size = 0;
+    for (const char *p = hex; p[0] && p[1] && (size < sizeof(data)); p += 2) {
+      unsigned byte;
+      sscanf(p, "%2x", &byte);
+      data[size++] = static_cast<uint8_t>(byte);
+    }
+
+    if (bFirst) {
+      firstTimestamp = timestamp;
+      sWallStart     = uhid::MonotonicTime();
+      bFirst         = false;
+    }
+    SleepUntil(sWallStart + (timestamp - firstTimestamp));
+    ProcessHostEvents();
+    Inject(static_cast<uint16_t>(handle), data, size, latency);
+    ++count;
+  }
+  fclose(fd);
+  fprintf(stderr, "replayed %u reports\n", count);
+  return true;
+}
+
+void PrintUsage(const char *name)
+{
+  fprintf(stderr,
+    "usage: %s [options]\n"
+    "  --duration MS        run duration (default 10000)\n"
+    "  --interval US        connection interval, multiple of 1250 (default 7500)\n"
+    "  --replay FILE        inject the reports of a capture written with --csv\n"
+    "  --no-latency         do not read the input devices to measure the latency\n"
+    "Requires write access to /dev/uhid, and read access to /dev/input for the latency.\n",
+    name
+  );
+}
+
+bool ParseArgs(int argc, char *argv[], Options *options)
+{
+  auto &config = sim::GetConfig();
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+    if (!strcmp(arg, "--no-latency")) {
+      options->latency = false;
+      continue;
+    }
+    if (!value) {
+      return false;
+    }
+    ++i;
+    if (!strcmp(arg, "--duration")) {
+      config.durationMs = atoi(value);
+    } else if (!strcmp(arg, "--interval")) {
+      config.connectionInterval = atoi(value);
+    } else if (!strcmp(arg, "--replay")) {
+      options->replayFilename = value;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+  Options options;
+  if (!ParseArgs(argc, argv, &options)) {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::string name = strrchr(argv[0], '/') ? strrchr(argv[0], '/') + 1 : argv[0];
+  name = name.substr(0, name.rfind("_uhid"));
+
+  if (options.replayFilename) {
+    // Only run the sketch until its services are registered, which happens on connection.
+    std::function<void()> waitTask = [&waitTask]() {
+      if (!sim::Attributes().empty()) {
+        sim::Stop();
+      } else {
+        sim::Schedule(1000, waitTask);
+      }
+    };
+    sim::Schedule(0, waitTask);
+    setup();
+    if (sim::Attributes().empty()) {
+      sim::Run();
+    }
+
+    if (!CreateDevices(name)) {
+      return EXIT_FAILURE;
+    }
+    if (options.latency) {
+      // (let the kernel create the input devices)
+      usleep(500000);
+      OpenInputDevices();
+    }
+    const bool bDone = Replay(options.replayFilename, options.latency);
+    sLatencies.print();
+    DestroyDevices();
+    return bDone ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  sim::OnNotification([&options](const sim::Notification &notification) {
+    Inject(notification.handle, notification.data.data(), notification.data.size(), options.latency);
+  });
+  sim::Schedule(0, [&name, &options]() { PaceTask(name, options.latency); });
+
+  // As with the simulation runner, sketches without event thread get their loop run here.
+  setup();
+  if (sim::Now() < sim::GetConfig().durationMs * 1000uLL) {
+    std::function<void()> loopTask = [&loopTask]() {
+      loop();
+      sim::Schedule(1000, loopTask);
+    };
+    sim::Schedule(0, loopTask);
+    sim::Run();
+  }
+
+  sLatencies.print();
+  DestroyDevices();
+  return EXIT_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""
+Host-side throughput benchmark for HIDRawService.
+
+Reads the chunks streamed by the ble_raw_stream example over the vendor-defined
+HID channel (usage page 0xFF00), checks their sequence numbers and the blob
+pattern, and reports the payload throughput.
+
+Requires the hidapi python bindings (pip install hidapi) and the device to be
+paired with the host.
+
+usage: raw_throughput.py [--duration SECONDS] [--report-size BYTES] [--echo]
+"""
+
+import argparse
+import sys
+import time
+
+import hid
+
+VENDOR_USAGE_PAGE = 0xFF00
+HEADER_SIZE = 3
+CHUNK_START = 1 << 0
+CHUNK_END = 1 << 1
+
+
+def find_device():
+    for info in hid.enumerate():
+        if info.get("usage_page") == VENDOR_USAGE_PAGE:
+            return info
+    return None
+
+
+def chunks(message, report_size, sequence):
+    """Split a message into output reports, as HIDRawService expects them."""
+    payload_size = report_size - HEADER_SIZE
+    offset = 0
+    while offset < len(message):
+        part = message[offset:offset + payload_size]
+        flags = (CHUNK_START if offset == 0 else 0)
+        flags |= (CHUNK_END if offset + len(part) == len(message) else 0)
+        report = bytes([sequence & 0xFF, flags, len(part)]) + part
+        yield report.ljust(report_size, b"\0")
+        sequence += 1
+        offset += len(part)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--duration", type=float, default=10.0,
+                        help="measurement duration in seconds")
+    parser.add_argument("--report-size", type=int, default=244,
+                        help="MBED_BLE_HID_RAW_REPORT_SIZE used by the firmware")
+    parser.add_argument("--echo", action="store_true",
+                        help="send a message first and wait for its echo")
+    args = parser.parse_args()
+
+    info = find_device()
+    if info is None:
+        sys.exit("No vendor-defined HID device (usage page 0xFF00) found.")
+
+    device = hid.device()
+    device.open_path(info["path"])
+    print("Device : %s" % info.get("product_string"))
+
+    if args.echo:
+        message = bytes(range(64))
+        for report in chunks(message, args.report_size, 0):
+            # (report ID 0 prefix expected by hidapi)
+            device.write(b"\0" + report)
+
+    payload_bytes = 0
+    max_length = 0
+    reports = 0
+    messages = 0
+    sequence_errors = 0
+    pattern_errors = 0
+    expected_sequence = None
+    blob = bytearray()
+
+    start = time.monotonic()
+    end = start + args.duration
+    while time.monotonic() < end:
+        data = device.read(args.report_size, 100)
+        if not data:
+            continue
+        reports += 1
+
+        sequence, flags, length = data[0], data[1], data[2]
+        payload = bytes(data[HEADER_SIZE:HEADER_SIZE + length])
+
+        if expected_sequence is not None and sequence != expected_sequence:
+            sequence_errors += 1
+        expected_sequence = (sequence + 1) & 0xFF
+
+        if flags & CHUNK_START:
+            blob = bytearray()
+        blob += payload
+        payload_bytes += length
+        max_length = max(max_length, length)
+
+        if flags & CHUNK_END:
+            messages += 1
+            # Streamed blobs are a rolling pattern : blob[i] = blob[0] + i.
+            if any(b != ((blob[0] + i) & 0xFF) for i, b in enumerate(blob)):
+                pattern_errors += 1
+
+    elapsed = time.monotonic() - start
+    device.close()
+
+    print("Duration        : %.2f s" % elapsed)
+    print("Reports         : %d (%.1f /s)" % (reports, reports / elapsed))
+    print("Messages        : %d" % messages)
+    print("Throughput      : %.2f kB/s" % (payload_bytes / elapsed / 1000.0))
+    # Chunks fill the notification payload of the link, minus their header.
+    if reports:
+        print("Chunk payload   : %.1f bytes average, %d max (link ceiling %d)"
+              % (payload_bytes / reports, max_length, max_length + HEADER_SIZE))
+    print("Sequence errors : %d" % sequence_errors)
+    print("Pattern errors  : %d" % pattern_errors)
+
+
+if __name__ == "__main__":
+    main()
@@ -1,4 +1,6 @@
 
+#include <atomic>
+
 #include "Mbed_BLE_HID.h"
 
 /* -------------------------------------------------------------------------- */
@@ -24,15 +26,218 @@ namespace {
 static constexpr bool bAcceptConnectionParams = true; //
 static constexpr bool bAcceptPairingRequest   = true; //
 
-/* Mbed event queue. */
-static const int kEventQueueSize = 16 * EVENTS_EVENT_SIZE;
-static events::EventQueue eventQueue(kEventQueueSize);
+/* Default storage of the events queue and thread, to avoid heap allocations. */
+static unsigned char sEventQueueBuffer[MBED_BLE_HID_EVENT_QUEUE_SIZE];
+MBED_ALIGN(8) static unsigned char sEventThreadStack[MBED_BLE_HID_EVENT_THREAD_STACK_SIZE];
+
+static MbedBleHID::EventThreadConfig sEventThreadConfig;
+
+/* Mbed event queue, built on first use following the configuration. */
+static InPlace<events::EventQueue> sEventQueue;
+
+/* Counters of the events posted to the queue by the library. */
+static struct {
+  std::atomic<uint32_t> failedPosts { 0 };
+  std::atomic<uint32_t> pending     { 0 };
+  std::atomic<uint32_t> maxPending  { 0 };
+} sEventQueueStats;
+
+events::EventQueue& GetEventQueue()
+{
+  if (!sEventQueue) {
+    // (sizes were checked against the static buffers by SetEventThreadConfig)
+    const auto &config = sEventThreadConfig;
+    unsigned char *memory = config.queueMemory ? config.queueMemory : sEventQueueBuffer;
+    sEventQueue.emplace(config.queueSize, memory);
+  }
+  return *sEventQueue;
+}
+
+/* Count the event @p id returned by the queue as failed when 0 (queue full), and return it. */
+int CheckPost(int id)
+{
+  if (!id) {
+    ++sEventQueueStats.failedPosts;
+  }
+  return id;
+}
+
+/* Post a one-shot event, keeping track of the pending events and failures.
+ * The posted function must call EventDispatched() first. */
+bool PostEvent(void (*fn)())
+{
+  const uint32_t pending = ++sEventQueueStats.pending;
+  if (!CheckPost(GetEventQueue().call(fn))) {
+    --sEventQueueStats.pending;
+    return false;
+  }
+  uint32_t maxPending = sEventQueueStats.maxPending.load();
+  while ((pending > maxPending) 
+      && !sEventQueueStats.maxPending.compare_exchange_weak(maxPending, pending)) {
+  }
+  return true;
+}
+
+inline void EventDispatched()
+{
+  --sEventQueueStats.pending;
+}
+
+/* Update task scheduling. */
+static struct {
+  void (*task)()                    = nullptr;
+  MbedBleHID::PollingMode mode      = MbedBleHID::POLLING_NONE;
+
+  // HID services whose queued input events are applied before the task.
+  HIDService *const *services       = nullptr;
+  int numServices                   = 0;
+
+  int fallbackPeriod                = 0;
+  int pollingPeriod                 = 0;
+  int pollingEventId                = 0;
+  std::atomic<bool> updateRequested { false };
+
+  // Connection interval in microseconds (0 when disconnected), and time of
+  // the last alignment on a connection event.
+  uint32_t connectionInterval       = 0;
+  uint32_t lastAlignment            = 0;
+} sScheduler;
+
+/* Advertising interval and duration limits, in milliseconds and seconds. */
+static const uint32_t kMinAdvertisingInterval = 20;
+static const uint32_t kMaxAdvertisingInterval = 10240;
+static const uint32_t kMaxAdvertisingDuration = 655;
+
+/* Clamp an advertising interval to the range of the specification. */
+inline uint32_t ClampAdvertisingInterval(uint32_t interval)
+{
+  return (interval < kMinAdvertisingInterval) ? kMinAdvertisingInterval
+       : (interval > kMaxAdvertisingInterval) ? kMaxAdvertisingInterval
+       : interval;
+}
+
+/* Time to sample and commit a report before the connection event, in microseconds. */
+static const uint32_t kConnectionEventLeadTime = 2000;
+
+/* Run the user update task, after the input events queued by the services. */
+void RunUpdateTask()
+{
+  sScheduler.updateRequested = false;
+  for (int i = 0; i < sScheduler.numServices; ++i) {
+    sScheduler.services[i]->processInputEvents();
+  }
+  sScheduler.task();
+}
+
+/* Run the update task posted by RequestUpdate(). */
+void RunRequestedUpdateTask()
+{
+  EventDispatched();
+  RunUpdateTask();
+}
+
+/* (Re)start polling the update task with the given period in milliseconds. */
+void SchedulePolling(int period)
+{
+  if (!sScheduler.task || (period == sScheduler.pollingPeriod)) {
+    return;
+  }
+  if (sScheduler.pollingEventId) {
+    GetEventQueue().cancel(sScheduler.pollingEventId);
+    sScheduler.pollingEventId = 0;
+  }
+  sScheduler.pollingPeriod = period;
+  if (period > 0) {
+    sScheduler.pollingEventId = CheckPost(GetEventQueue().call_every(period, RunUpdateTask));
+    // (retried on the next scheduling when the queue was full)
+    sScheduler.pollingPeriod  = sScheduler.pollingEventId ? period : 0;
+  }
+}
+
+/* Polling period matching the connection interval, in milliseconds (rounded up). */
+int ConnectionPollingPeriod()
+{
+  return (sScheduler.connectionInterval + 999) / 1000;
+}
+
+/* Poll once per connection interval when the scheduling follows it. */
+void SchedulePollingOnConnection(ble::conn_interval_t interval)
+{
+  // (connection intervals are in units of 1.25ms)
+  sScheduler.connectionInterval = interval.value() * 1250;
+
+  if (sScheduler.mode == MbedBleHID::POLLING_CONNECTION_INTERVAL) {
+    SchedulePolling(ConnectionPollingPeriod());
+  }
+}
+
+/* Poll at the fallback period when disconnected. */
+void SchedulePollingOnDisconnection()
+{
+  sScheduler.connectionInterval = 0;
+
+  if (sScheduler.mode == MbedBleHID::POLLING_CONNECTION_INTERVAL) {
+    SchedulePolling(sScheduler.fallbackPeriod);
+  }
+}
+
+/* Run the update task aligned on a connection event, then resume polling
+ * in case no report is sent during this event. */
+void RunAlignedUpdateTask()
+{
+  sScheduler.pollingEventId = 0;
+  sScheduler.pollingPeriod  = 0;
+  SchedulePolling(ConnectionPollingPeriod());
+  RunUpdateTask();
+}
+
+/**
+ * Schedule the next update task run just before the next connection event.
+ * 
+ * Mbed does not expose the radio activity, so connection events are estimated
+ * from the completion of notifications, reported right after the event which
+ * sent them.
+ */
+void ScheduleBeforeConnectionEvent()
+{
+  if ((sScheduler.mode != MbedBleHID::POLLING_CONNECTION_INTERVAL)
+   || !sScheduler.task || !sScheduler.connectionInterval) {
+    return;
+  }
+
+  // Several notifications complete on the same event, align only once.
+  const uint32_t now = us_ticker_read();
+  if ((sScheduler.pollingPeriod == 0) 
+   && (now - sScheduler.lastAlignment < sScheduler.connectionInterval / 2)) {
+    return;
+  }
+  sScheduler.lastAlignment = now;
+
+  if (sScheduler.pollingEventId) {
+    GetEventQueue().cancel(sScheduler.pollingEventId);
+  }
+  const uint32_t lead = (sScheduler.connectionInterval > kConnectionEventLeadTime) 
+                      ? kConnectionEventLeadTime : 0;
+  const int delay = (sScheduler.connectionInterval - lead) / 1000;
+  sScheduler.pollingPeriod  = 0;
+  sScheduler.pollingEventId = CheckPost(GetEventQueue().call_in(delay, RunAlignedUpdateTask));
+  if (!sScheduler.pollingEventId) {
+    // Keep polling rather than stopping the task.
+    SchedulePolling(ConnectionPollingPeriod());
+  }
+}
+
+/* Process the BLE stack events. */
+void ProcessBleEvents()
+{
+  EventDispatched();
+  BLE::Instance().processEvents();
+}
 
 /* BLE events scheduling callback. */
 void bleScheduleEventsProcessing(BLE::OnEventsToProcessCallbackContext* context) 
 {
-  BLE &ble = BLE::Instance();
-  eventQueue.call(mbed::Callback<void()>(&ble, &BLE::processEvents));
+  PostEvent(ProcessBleEvents);
 }
 
 /* Redefines Arduino millis() method when on PlatformIO. */
@@ -65,14 +270,46 @@ const int MbedBleHID::kDefaultBatteryLevel        = 98;
 
 /* -------------------------------------------------------------------------- */
 
-void MbedBleHID::RunEventThread( void (*task_fn)() )
+bool MbedBleHID::SetEventThreadConfig(const EventThreadConfig &config)
 {
-  // Transform the Arduino loop into an update event task.
-  eventQueue.call_every(10, task_fn);
+  MBED_ASSERT(!sEventQueue);
+
+  // Never fall back to the heap.
+  const bool queueFits = config.queueMemory || (config.queueSize <= sizeof(sEventQueueBuffer));
+  const bool stackFits = config.stackMemory || (config.stackSize <= sizeof(sEventThreadStack));
+  MBED_ASSERT(queueFits && stackFits);
+  if (!queueFits || !stackFits) {
+    return false;
+  }
+  sEventThreadConfig = config;
+  return true;
+}
+
+MbedBleHID::EventQueueStats MbedBleHID::GetEventQueueStats()
+{
+  EventQueueStats stats;
+  stats.failedPosts = sEventQueueStats.failedPosts;
+  stats.pending     = sEventQueueStats.pending;
+  stats.maxPending  = sEventQueueStats.maxPending;
+  return stats;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void MbedBleHID::RunEventThread( void (*task_fn)(), PollingMode mode, int pollingPeriod )
+{
+  // Transform the Arduino loop into an update event task, run on requests
+  // and polled following the scheduling mode.
+  sScheduler.task = task_fn;
+  sScheduler.mode = mode;
+  sScheduler.fallbackPeriod = pollingPeriod;
+  SchedulePolling((mode != POLLING_NONE) ? pollingPeriod : 0);
 
   // Launch a new thread for handling events.
-  rtos::Thread eventThread;
-  eventThread.start(mbed::callback(&eventQueue, &events::EventQueue::dispatch_forever));
+  const auto &config = sEventThreadConfig;
+  unsigned char *stack = config.stackMemory ? config.stackMemory : sEventThreadStack;
+  rtos::Thread eventThread(config.priority, config.stackSize, stack);
+  eventThread.start(mbed::callback(&GetEventQueue(), &events::EventQueue::dispatch_forever));
 
   // Put the main thread to sleep.
   rtos::ThisThread::sleep_for(osWaitForever);
@@ -80,6 +317,18 @@ void MbedBleHID::RunEventThread( void (*task_fn)() )
 
 /* -------------------------------------------------------------------------- */
 
+void MbedBleHID::RequestUpdate()
+{
+  if (!sScheduler.task || sScheduler.updateRequested.exchange(true)) {
+    return;
+  }
+  if (!PostEvent(RunRequestedUpdateTask)) {
+    sScheduler.updateRequested = false;
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+
 void MbedBleHID::initialize()
 {
   BLE &ble = BLE::Instance();
@@ -88,7 +337,61 @@ void MbedBleHID::initialize()
 }
 
 uint64_t MbedBleHID::connection_time() const {
-  return GetElapsedTimeMilliseconds() - lastConnection_;
+  return GetElapsedTimeMilliseconds() - activeHost().lastConnection;
+}
+
+uint16_t MbedBleHID::payload_size() const {
+  // A notification adds a 3 bytes ATT header, and a 4 bytes L2CAP header
+  // to the link layer packet.
+  const uint16_t attPayload = att_mtu() - 3;
+  const uint16_t llPayload  = data_length() - 3 - 4;
+  return (attPayload < llPayload) ? attPayload : llPayload;
+}
+
+int MbedBleHID::num_hosts() const {
+  int count = 0;
+  for (const auto &host : hosts_) {
+    count += host.connected ? 1 : 0;
+  }
+  return count;
+}
+
+int MbedBleHID::findHost(ble::connection_handle_t connectionHandle) const {
+  for (int i = 0; i < kMaxHosts; ++i) {
+    if (hosts_[i].connected && (hosts_[i].handle == connectionHandle)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool MbedBleHID::set_active_host(int index)
+{
+  if ((index < 0) || (index >= kMaxHosts) || !hosts_[index].connected) {
+    return false;
+  }
+  activateHost(index);
+  return true;
+}
+
+void MbedBleHID::activateHost(int index)
+{
+  activeHost_ = index;
+  const host_t &host = hosts_[index];
+
+  // With several hosts, each report goes to the active one only.
+  if (kMaxHosts > 1) {
+    for (int i = 0; i < services_.numHID; ++i) {
+      services_.hid[i]->routeReports(host.handle);
+    }
+  }
+  notifyPayloadSize();
+
+  if (host.connected) {
+    SchedulePollingOnConnection(host.interval);
+  } else {
+    SchedulePollingOnDisconnection();
+  }
 }
 
 void MbedBleHID::postInitialization(BLE::InitializationCompleteCallbackContext *params)
@@ -102,16 +405,31 @@ void MbedBleHID::postInitialization(BLE::InitializationCompleteCallbackContext *
   // Services.
   {
     // Add the required BLE services for the HID-over-GATT Profile.
-    services_.deviceInformation = std::make_unique<DeviceInformationService>(ble,
-      kManufacturerName_.c_str(),
-      kVersionString_.c_str(),    // Model Number
-      kVersionString_.c_str(),    // Serial Number
-      kVersionString_.c_str(),    // Hardware Revision
-      kVersionString_.c_str(),    // Firmware Revision
-      kVersionString_.c_str()     // Software Revision
+    services_.deviceInformation.emplace(ble,
+      kManufacturerName_,
+      kVersionString_,    // Model Number
+      kVersionString_,    // Serial Number
+      kVersionString_,    // Hardware Revision
+      kVersionString_,    // Firmware Revision
+      kVersionString_     // Software Revision
     );
-    services_.battery = std::make_unique<BatteryService>(ble, kDefaultBatteryLevel); //
-    services_.hid = CreateHIDService(ble);
+    services_.battery.emplace(ble, kDefaultBatteryLevel); //
+    services_.numHID = CreateHIDServices(ble, services_.hid);
+    for (int i = 0; i < services_.numHID; ++i) {
+      // (once constructed, with the feature reports they declared)
+      error_ = services_.hid[i]->registerService();
+      if (has_error()) {
+        // Stop there, whatever HANDLE_ERROR : a device missing one of its
+        // services must not advertise as a HID.
+        return;
+      }
+      services_.hid[i]->setReportRecorder(reportRecorder_);
+    }
+    sScheduler.services    = services_.hid;
+    sScheduler.numServices = services_.numHID;
+
+    // GATT events callbacks, to route client writes to the services.
+    ble.gattServer().setEventHandler(this);
   }
 
   // Security Manager.
@@ -121,15 +439,14 @@ void MbedBleHID::postInitialization(BLE::InitializationCompleteCallbackContext *
     auto &securityManager = ble.securityManager();
 
     // Initialized Security manager with no Man-in-the-middle (MITM) protection.
-    // @note: When bonding is enabled subsequents pairing after the initial one
-    //        might fail, which could be a security parameters issue. 
+    // Bonding lets known hosts reconnect without pairing again.
     error_ = securityManager.init(
-      false,                          // enable bonding ?
+      bonding_,                       // enable bonding ?
       false,                          // enable MITM protection ?
       SecurityManager::IO_CAPS_NONE,  // security IO capabilities.
       nullptr,                        // passkey.
       false,                          // enable signing ?
-      nullptr                         // dbFilepath.
+      bondDbFilepath_                 // dbFilepath.
     );
     HANDLE_ERROR();
 
@@ -142,6 +459,11 @@ void MbedBleHID::postInitialization(BLE::InitializationCompleteCallbackContext *
 
     // Add events callbacks for pairing requests.
     securityManager.setSecurityManagerEventHandler(this);
+
+    // Retrieve the hosts bonded before a reset for the filter accept list.
+    if (bonding_) {
+      securityManager.generateWhitelistFromBondTable(&whitelist_);
+    }
   }
 
   // GAP Advertising parameters.
@@ -161,35 +483,102 @@ void MbedBleHID::postInitialization(BLE::InitializationCompleteCallbackContext *
         .setFlags(adv_data_flags_t::BREDR_NOT_SUPPORTED       // Peripheral device is LE only. 
                 | adv_data_flags_t::LE_GENERAL_DISCOVERABLE   // Peripheral device is discoverable at any moment. 
         )
-        .setName(kDeviceName_.c_str(), true)
-        .setAppearance(services_.hid->appearance())
+        .setName(kDeviceName_, true)
+        .setAppearance(services_.hid[0]->appearance())
         .setLocalService(GattService::UUID_HUMAN_INTERFACE_DEVICE_SERVICE)
         .getAdvertisingData()
     );
+  }
 
+  startAdvertising();
+}
+
+void MbedBleHID::setAdvertisingParameters(bool directed, uint16_t interval)
+{
+  using namespace ble;
+  Gap &gap = BLE::Instance().gap();
+
+  // High duty cycle directed advertising, to the last bonded host only.
+  if (directed) {
     gap.setAdvertisingParameters(
       LEGACY_ADVERTISING_HANDLE,
       AdvertisingParameters()
-        .setType(advertising_type_t::CONNECTABLE_UNDIRECTED)
-        .setPrimaryInterval(
-          conn_interval_t(millisecond_t(100)), //
-          conn_interval_t(millisecond_t(200))  //
-        )
+        .setType(advertising_type_t::CONNECTABLE_DIRECTED)
+        .setPeer(lastBondedHost_.address, lastBondedHost_.type)
         .setUseLegacyPDU(true)
         .setOwnAddressType(own_address_type_t::RANDOM)
-        .setPhy(phy_t::LE_1M, phy_t::LE_CODED)
     );
+    return;
   }
 
-  startAdvertising();
+  // Filter the connection requests with the bonded hosts when asked to.
+  const bool filter = bondedHostsOnly_ && (whitelist_.size > 0);
+
+  // The controller picks each interval in [interval, 1.5 * interval].
+  const uint32_t minInterval = ClampAdvertisingInterval(interval);
+  const uint32_t maxInterval = ClampAdvertisingInterval(minInterval + minInterval / 2);
+
+  gap.setAdvertisingParameters(
+    LEGACY_ADVERTISING_HANDLE,
+    AdvertisingParameters()
+      .setType(advertising_type_t::CONNECTABLE_UNDIRECTED)
+      .setPrimaryInterval(
+        adv_interval_t(millisecond_t(minInterval)),
+        adv_interval_t(millisecond_t(maxInterval))
+      )
+      .setUseLegacyPDU(true)
+      .setOwnAddressType(own_address_type_t::RANDOM)
+      .setPhy(phy_t::LE_1M, phy_t::LE_CODED)
+      .setFilter(filter ? advertising_filter_policy_t::FILTER_SCAN_AND_CONNECTION_REQUESTS
+                        : advertising_filter_policy_t::NO_FILTER)
+  );
 }
 
 void MbedBleHID::startAdvertising()
 {
+  using namespace ble;
   BLE &ble = BLE::Instance();
 
-  // Start Advertising.
-  error_ = ble.gap().startAdvertising(ble::LEGACY_ADVERTISING_HANDLE);
+  if (directedAdvertising_) {
+    // Directed advertising is limited to 1.28s by the specification, then
+    // onAdvertisingEnd resumes the advertising schedule.
+    setAdvertisingParameters(true);
+    error_ = ble.gap().startAdvertising(
+      LEGACY_ADVERTISING_HANDLE,
+      adv_duration_t(millisecond_t(1280))
+    );
+  } else {
+    const AdvertisingPolicy &policy = advertisingPolicy_;
+
+    // Fast interval first, then doubled at each step up to the slow one,
+    // which is kept until the timeout.
+    uint32_t interval = policy.fastInterval;
+    uint32_t duration = policy.fastDuration;
+    if (advertisingStep_ > 0) {
+      interval = (advertisingStep_ < 16) ? (interval << advertisingStep_) : policy.slowInterval;
+      duration = policy.stepDuration;
+    }
+    if (interval >= policy.slowInterval) {
+      interval = policy.slowInterval;
+      duration = 0;
+    }
+    interval = ClampAdvertisingInterval(interval);
+
+    if (policy.timeout) {
+      if (advertisingTime_ >= policy.timeout) {
+        advertisingStopped_ = true;
+        return;
+      }
+      const uint32_t remaining = policy.timeout - advertisingTime_;
+      duration = (duration && (duration < remaining)) ? duration : remaining;
+    }
+    duration = (duration < kMaxAdvertisingDuration) ? duration : kMaxAdvertisingDuration;
+    advertisingStepDuration_ = duration;
+
+    setAdvertisingParameters(false, interval);
+    error_ = duration ? ble.gap().startAdvertising(LEGACY_ADVERTISING_HANDLE, adv_duration_t(millisecond_t(duration * 1000)))
+                      : ble.gap().startAdvertising(LEGACY_ADVERTISING_HANDLE);
+  }
   HANDLE_ERROR();
 
   // Tell the stack the app needs to authorize pairing request via callbacks.
@@ -219,17 +608,159 @@ void MbedBleHID::onConnectionComplete(const ble::ConnectionCompleteEvent &event)
   // );
   // ---------------------------------
 
-  connected_ = !has_error();
-  
-  if (connected_) {
-    lastConnection_ = GetElapsedTimeMilliseconds();
+  // Take the slot the host left last, otherwise the first free one.
+  const ble::address_t &peerAddress = event.getPeerAddress();
+  int index = -1;
+  bool returning = false;
+  for (int i = 0; i < kMaxHosts; ++i) {
+    const host_t &slot = hosts_[i];
+    if (slot.connected) {
+      continue;
+    }
+    if (slot.address.valid && (slot.address.address == peerAddress)) {
+      index = i;
+      returning = true;
+      break;
+    }
+    index = (index < 0) ? i : index;
+  }
+
+  if (!has_error() && (index >= 0)) {
+    // The first host receives the reports, and the update task period is
+    // aligned on its connection interval (decided before its slot is taken,
+    // as the active slot may be this one).
+    const bool activate = !hosts_[activeHost_].connected;
+
+    host_t &host = hosts_[index];
+    const bool linkLost = returning && host.linkLost;
+    host = host_t();
+    host.linkLost       = linkLost;
+    host.connected      = true;
+    host.handle         = handle;
+    host.lastConnection = GetElapsedTimeMilliseconds();
+    host.interval       = event.getConnectionInterval();
+
+    // Keep the host address in case it bonds.
+    using peer_type = ble::peer_address_type_t;
+    const peer_type addressType = event.getPeerAddressType();
+    host.address.address = event.getPeerAddress();
+    host.address.type    = ((addressType == peer_type::PUBLIC) || (addressType == peer_type::PUBLIC_IDENTITY))
+                         ? ble::target_peer_address_type_t::PUBLIC
+                         : ble::target_peer_address_type_t::RANDOM;
+    host.address.valid   = true;
+    directedAdvertising_ = false;
+
+#if BLE_FEATURE_GATT_CLIENT
+    // Ask for a larger ATT MTU, the LE Data Length Extension being requested
+    // by the stack itself following its configuration (cordio.desired-att-mtu
+    // and cordio.rx-acl-buffer-size).
+    ble.gattClient().negotiateAttMtu(handle);
+#endif
+
+    requestPreferredPhy(handle);
+
+    if (activate) {
+      activateHost(index);
+    }
+  }
+
+  // Let more hosts connect while slots remain.
+  if (num_hosts() < kMaxHosts) {
+    resetAdvertisingSchedule();
+    startAdvertising();
   }
 }
 
 void MbedBleHID::onDisconnectionComplete(const ble::DisconnectionCompleteEvent &event)
 {
-  error_     = BLE_ERROR_NONE;
-  connected_ = false;
+  error_ = BLE_ERROR_NONE;
+
+  const int index = findHost(event.getConnectionHandle());
+  if (index < 0) {
+    return;
+  }
+  const host_address_t address = hosts_[index].address;
+  hosts_[index] = host_t();
+
+  // Keep who left and how, for its reconnection. A supervision timeout
+  // usually means the peer went out of range.
+  hosts_[index].address  = address;
+  hosts_[index].linkLost = (event.getReason() == ble::disconnection_reason_t::CONNECTION_TIMEOUT);
+
+  // (before the reports are routed to another host)
+  for (int i = 0; i < services_.numHID; ++i) {
+    services_.hid[i]->onDisconnection(event.getConnectionHandle());
+  }
+
+  // Switch to another connected host, if any.
+  if (index == activeHost_) {
+    int next = 0;
+    while ((next < kMaxHosts) && !hosts_[next].connected) {
+      ++next;
+    }
+    activateHost((next < kMaxHosts) ? next : index);
+  }
+
+  // Reconnect to the host first when it was bonded, eg. after it went to sleep.
+  directedAdvertising_ = bonding_ && lastBondedHost_.valid
+                      && (address.address == lastBondedHost_.address);
+  resetAdvertisingSchedule();
+
+  // (advertising is still running when slots were left)
+  Gap &gap = BLE::Instance().gap();
+  if (gap.isAdvertisingActive(ble::LEGACY_ADVERTISING_HANDLE)) {
+    gap.stopAdvertising(ble::LEGACY_ADVERTISING_HANDLE);
+  }
+  startAdvertising();
+}
+
+void MbedBleHID::resetAdvertisingSchedule()
+{
+  advertisingStep_    = 0;
+  advertisingTime_    = 0;
+  advertisingStopped_ = false;
+}
+
+void MbedBleHID::set_advertising_policy(const AdvertisingPolicy &policy)
+{
+  advertisingPolicy_ = policy;
+  advertisingPolicy_.fastInterval = ClampAdvertisingInterval(policy.fastInterval);
+  advertisingPolicy_.slowInterval = ClampAdvertisingInterval(policy.slowInterval);
+}
+
+void MbedBleHID::wake_advertising()
+{
+  if ((num_hosts() == kMaxHosts) || !advertisingStopped_) {
+    return;
+  }
+  resetAdvertisingSchedule();
+  startAdvertising();
+}
+
+void MbedBleHID::set_report_recorder(ReportRecorder *recorder)
+{
+  reportRecorder_ = recorder;
+  for (int i = 0; i < services_.numHID; ++i) {
+    services_.hid[i]->setReportRecorder(recorder);
+  }
+}
+
+void MbedBleHID::onAdvertisingEnd(const ble::AdvertisingEndEvent &event)
+{
+  // (ignore the end of an advertising set which was already restarted)
+  if (event.isConnected() 
+   || BLE::Instance().gap().isAdvertisingActive(ble::LEGACY_ADVERTISING_HANDLE)) {
+    return;
+  }
+
+  if (directedAdvertising_) {
+    // The bonded host did not come back, let any host connect.
+    directedAdvertising_ = false;
+  } else if (advertisingStepDuration_) {
+    // Step to a slower interval.
+    advertisingTime_ += advertisingStepDuration_;
+    ++advertisingStep_;
+  }
   startAdvertising();
 }
 
@@ -252,6 +783,112 @@ void MbedBleHID::onUpdateConnectionParametersRequest(const ble::UpdateConnection
   }
 }
 
+void MbedBleHID::onConnectionParametersUpdateComplete(const ble::ConnectionParametersUpdateCompleteEvent &event)
+{
+  const int index = findHost(event.getConnectionHandle());
+  if ((event.getStatus() != BLE_ERROR_NONE) || (index < 0)) {
+    return;
+  }
+  hosts_[index].interval = event.getConnectionInterval();
+
+  if (index == activeHost_) {
+    SchedulePollingOnConnection(hosts_[index].interval);
+  }
+}
+
+void MbedBleHID::requestPreferredPhy(ble::connection_handle_t connectionHandle)
+{
+#if BLE_FEATURE_PHY_MANAGEMENT
+  using namespace ble;
+  auto &gap = BLE::Instance().gap();
+
+  if (phyPolicy_ == PHY_POLICY_1M) {
+    return;
+  }
+
+  // After a link loss of this host, trade throughput for range.
+  const int index = findHost(connectionHandle);
+  if ((phyPolicy_ == PHY_POLICY_2M_CODED_FALLBACK) && (index >= 0) && hosts_[index].linkLost
+   && gap.isFeatureSupported(controller_supported_features_t::LE_CODED_PHY)) {
+    const phy_set_t phys(false, false, true);
+    gap.setPhy(connectionHandle, &phys, &phys, coded_symbol_per_bit_t::S8);
+    return;
+  }
+
+  // The 2M PHY shortens the air time of each notification. The controller
+  // keeps the current PHY when the peer does not support it.
+  if (gap.isFeatureSupported(controller_supported_features_t::LE_2M_PHY)) {
+    const phy_set_t phys(false, true, false);
+    gap.setPhy(connectionHandle, &phys, &phys, coded_symbol_per_bit_t::UNDEFINED);
+  }
+#endif
+}
+
+void MbedBleHID::onPhyUpdateComplete(ble_error_t status, ble::connection_handle_t connectionHandle, ble::phy_t txPhy, ble::phy_t rxPhy)
+{
+  const int index = findHost(connectionHandle);
+  if ((status != BLE_ERROR_NONE) || (index < 0)) {
+    return;
+  }
+  hosts_[index].txPhy = txPhy;
+  hosts_[index].rxPhy = rxPhy;
+
+  if (phyUpdateCallback_) {
+    phyUpdateCallback_(txPhy, rxPhy);
+  }
+}
+
+void MbedBleHID::onDataLengthChange(ble::connection_handle_t connectionHandle, uint16_t txSize, uint16_t rxSize)
+{
+  const int index = findHost(connectionHandle);
+  if (index < 0) {
+    return;
+  }
+  hosts_[index].dataLength = txSize;
+
+  if (index == activeHost_) {
+    notifyPayloadSize();
+  }
+}
+
+void MbedBleHID::onAttMtuChange(ble::connection_handle_t connectionHandle, uint16_t attMtuSize)
+{
+  const int index = findHost(connectionHandle);
+  if (index < 0) {
+    return;
+  }
+  hosts_[index].attMtu = attMtuSize;
+
+  if (index == activeHost_) {
+    notifyPayloadSize();
+  }
+}
+
+void MbedBleHID::notifyPayloadSize()
+{
+  const uint16_t size = payload_size();
+  for (int i = 0; i < services_.numHID; ++i) {
+    services_.hid[i]->onPayloadSizeChange(size);
+  }
+}
+
+void MbedBleHID::onDataWritten(const GattWriteCallbackParams &params)
+{
+  for (int i = 0; i < services_.numHID; ++i) {
+    services_.hid[i]->onDataWritten(params);
+  }
+}
+
+void MbedBleHID::onDataSent(const GattDataSentCallbackParams &params)
+{
+  for (int i = 0; i < services_.numHID; ++i) {
+    services_.hid[i]->onDataSent(params);
+  }
+
+  // Sample the next reports just before the next connection event.
+  ScheduleBeforeConnectionEvent();
+}
+
 void MbedBleHID::pairingRequest(ble::connection_handle_t connectionHandle)
 {
   auto &sm = BLE::Instance().securityManager();
@@ -263,5 +900,37 @@ void MbedBleHID::pairingRequest(ble::connection_handle_t connectionHandle)
   }
 }
 
+void MbedBleHID::pairingResult(ble::connection_handle_t connectionHandle, SecurityManager::SecurityCompletionStatus_t result)
+{
+  // Add the new bond to the filter accept list.
+  if (bonding_ && (result == SecurityManager::SEC_STATUS_SUCCESS)) {
+    BLE::Instance().securityManager().generateWhitelistFromBondTable(&whitelist_);
+  }
+}
+
+void MbedBleHID::linkEncryptionResult(ble::connection_handle_t connectionHandle, ble::link_encryption_t result)
+{
+  // With bonding enabled, hosts encrypting the link are taken as bonded.
+  const int index = findHost(connectionHandle);
+  if (bonding_ && (index >= 0)
+   && (result != ble::link_encryption_t::NOT_ENCRYPTED)
+   && (result != ble::link_encryption_t::ENCRYPTION_IN_PROGRESS)) {
+    lastBondedHost_ = hosts_[index].address;
+  }
+}
+
+void MbedBleHID::whitelistFromBondTable(ble::whitelist_t *whitelist)
+{
+  Gap &gap = BLE::Instance().gap();
+  gap.setWhitelist(*whitelist);
+
+  // Apply the filter to the ongoing advertising.
+  if (bondedHostsOnly_ && !directedAdvertising_
+   && gap.isAdvertisingActive(ble::LEGACY_ADVERTISING_HANDLE)) {
+    gap.stopAdvertising(ble::LEGACY_ADVERTISING_HANDLE);
+    startAdvertising();
+  }
+}
+
 
 /* -------------------------------------------------------------------------- */
@@ -1,7 +1,8 @@
 #ifndef MBED_BLE_HID_H_
 #define MBED_BLE_HID_H_
 
-#include <memory>
+#include <tuple>
+#include <type_traits>
 
 // from the Mbed SDK.
 #include <mbed.h>
@@ -9,6 +10,29 @@
 #include <BatteryService.h>
 
 #include "services/HIDService.h"
+#include "inplace.h"
+#include "spsc_queue.h"
+
+/* -------------------------------------------------------------------------- */
+
+/* [build options] Defaults of the events thread and queue, see EventThreadConfig. */
+#ifndef MBED_BLE_HID_EVENT_THREAD_PRIORITY
+#define MBED_BLE_HID_EVENT_THREAD_PRIORITY    osPriorityNormal
+#endif
+
+#ifndef MBED_BLE_HID_EVENT_THREAD_STACK_SIZE
+#define MBED_BLE_HID_EVENT_THREAD_STACK_SIZE  OS_STACK_SIZE
+#endif
+
+#ifndef MBED_BLE_HID_EVENT_QUEUE_SIZE
+#define MBED_BLE_HID_EVENT_QUEUE_SIZE         (16 * EVENTS_EVENT_SIZE)
+#endif
+
+/* [build option] Number of hosts connected at the same time, limited by the
+ * stack configuration (cordio.max-connections). */
+#ifndef MBED_BLE_HID_MAX_HOSTS
+#define MBED_BLE_HID_MAX_HOSTS                1
+#endif
 
 /* -------------------------------------------------------------------------- */
 
@@ -17,17 +41,109 @@
 * using the bluetooth low energy HID over GATT Profile on Mbed stack.
 */
 class MbedBleHID : public Gap::EventHandler,
+                   public GattServer::EventHandler,
                    public SecurityManager::EventHandler
 {
-  private:
+  protected:
     static constexpr int kDefaultStringSize = 32;
     static const char kDefaultDeviceName[kDefaultStringSize];
     static const char kDefaultManufacturerName[kDefaultStringSize];
     static const char kDefaultVersionString[kDefaultStringSize];
     static const int  kDefaultBatteryLevel;
 
+    // Maximum number of HID services hosted by a single device.
+    static constexpr int kMaxHIDServices = 4;
+
+    // Default polling period of the update task, in milliseconds.
+    static constexpr int kDefaultPollingPeriod = 10;
+
+    // Link defaults before any negotiation (Bluetooth Core v4.2).
+    static constexpr uint16_t kDefaultAttMtu     = 23;
+    static constexpr uint16_t kDefaultDataLength = 27;
+
+    // Maximum number of bonded hosts in the filter accept list.
+    static constexpr int kMaxBondedHosts = 4;
+
+  public:
+    // Maximum number of hosts connected at the same time.
+    static constexpr int kMaxHosts = MBED_BLE_HID_MAX_HOSTS;
+
+    /** PHY requested once connected. */
+    enum PhyPolicy {
+      PHY_POLICY_1M,                  // Keep the 1M PHY.
+      PHY_POLICY_2M,                  // Switch to the 2M PHY when supported by both sides.
+      PHY_POLICY_2M_CODED_FALLBACK,   // Same as 2M, but use the Coded PHY after a link loss.
+    };
+
+    typedef mbed::Callback<void(ble::phy_t txPhy, ble::phy_t rxPhy)> PhyUpdateCallback_t;
+
+    /** How the update task is polled, besides the updates requested by input sources. */
+    enum PollingMode {
+      POLLING_NONE,                 // Only run on RequestUpdate().
+      POLLING_FIXED,                // Run every polling period.
+      POLLING_CONNECTION_INTERVAL,  // Run once per connection interval when connected,
+                                    // every polling period otherwise.
+    };
+
+    /**
+     * Events thread and queue parameters.
+     * When no memory is provided, static buffers of the default sizes are used,
+     * hence larger sizes must come with their memory.
+     */
+    struct EventThreadConfig {
+      osPriority_t priority      = MBED_BLE_HID_EVENT_THREAD_PRIORITY;
+      uint32_t stackSize         = MBED_BLE_HID_EVENT_THREAD_STACK_SIZE;
+      unsigned char *stackMemory = nullptr;
+      uint32_t queueSize         = MBED_BLE_HID_EVENT_QUEUE_SIZE;   // in bytes.
+      unsigned char *queueMemory = nullptr;
+    };
+
+    /** Counters of the events posted to the queue, to size it. */
+    struct EventQueueStats {
+      uint32_t failedPosts;   // Events dropped because the queue was full.
+      uint32_t pending;       // Events currently waiting to be dispatched.
+      uint32_t maxPending;    // High-water mark of the pending events.
+    };
+
+    /**
+     * Advertising schedule : a fast interval for a while after boot or a
+     * disconnection, then an interval doubling at each step up to the slow one.
+     * Intervals are in milliseconds, durations in seconds.
+     */
+    struct AdvertisingPolicy {
+      uint16_t fastInterval = 20;
+      uint16_t fastDuration = 30;
+      uint16_t slowInterval = 1000;
+      uint16_t stepDuration = 10;   // Time spent at each intermediate interval.
+      uint16_t timeout      = 0;    // Stop advertising after it, 0 to never stop.
+    };
+
   public:
-    static void RunEventThread( void (*task_fn)() );
+    /**
+     * Change the events thread and queue parameters.
+     * Must be called before initialize(), the queue being used from then on.
+     * @return false, keeping the current parameters, when a size exceeds its
+     * static buffer and no memory is provided.
+     */
+    static bool SetEventThreadConfig(const EventThreadConfig &config);
+
+    /** Return the events queue counters, safe to call from any thread. */
+    static EventQueueStats GetEventQueueStats();
+
+    /**
+     * Run the BLE events and the update task on a dedicated thread, and halt
+     * the calling thread.
+     */
+    static void RunEventThread( void (*task_fn)(),
+                                PollingMode mode = POLLING_CONNECTION_INTERVAL,
+                                int pollingPeriod = kDefaultPollingPeriod );
+
+    /**
+     * Schedule a run of the update task as soon as possible, eg. when an input
+     * changed. Multiple requests before the task runs are merged.
+     * Safe to call from interrupts.
+     */
+    static void RequestUpdate();
 
   public:
     MbedBleHID(const char* deviceName = kDefaultDeviceName,
@@ -43,20 +159,88 @@ class MbedBleHID : public Gap::EventHandler,
     /** Initialize Bluetooth Low Energy */
     void initialize();
 
+    /** Set the PHY requested on the next connections (default to PHY_POLICY_2M). */
+    inline void set_phy_policy(PhyPolicy policy) { phyPolicy_ = policy; }
+
+    /** Set a function called on each PHY update, eg. to log them. */
+    inline void on_phy_update(PhyUpdateCallback_t callback) { phyUpdateCallback_ = callback; }
+
+    /**
+     * Enable bonding (default), to be called before initialize().
+     * Bonds are kept in @p dbFilepath when given, otherwise in the stack
+     * security database (persistent when configured on KVStore).
+     */
+    inline void set_bonding(bool enable, const char *dbFilepath = nullptr) {
+      bonding_ = enable;
+      bondDbFilepath_ = dbFilepath;
+    }
+
+    /** Only accept connections from the bonded hosts, once there is one. */
+    inline void set_bonded_hosts_only(bool enable) { bondedHostsOnly_ = enable; }
+
+    /**
+     * Set the advertising schedule, applied from the next advertising start.
+     * Intervals are clamped to the [20, 10240] ms range of the specification.
+     */
+    void set_advertising_policy(const AdvertisingPolicy &policy);
+
+    /**
+     * Restart advertising from the fast interval when it stopped on timeout,
+     * eg. on user input. Must be called from the BLE events thread.
+     */
+    void wake_advertising();
+
+    /**
+     * Send the reports to the host connected in slot @p index (in [0, kMaxHosts[),
+     * the other hosts staying connected.
+     * @return false when no host is connected in this slot.
+     */
+    bool set_active_host(int index);
+
+    /**
+     * Record the input reports sent by every HID service into @p recorder,
+     * eg. to dump them when a glitch is reported. nullptr stops the recording.
+     * To be called before initialize(), or from the BLE events thread.
+     */
+    void set_report_recorder(ReportRecorder *recorder);
+
     // -- Getters --
-    inline bool connected() const { return connected_; }
+    // (link getters refer to the active host)
+    inline bool connected() const { return activeHost().connected; }
     inline bool has_error() const { return error_ != BLE_ERROR_NONE; }
+    inline uint16_t att_mtu() const { return activeHost().attMtu; }
+    inline uint16_t data_length() const { return activeHost().dataLength; }
+    uint16_t payload_size() const;
     uint64_t connection_time() const;
+    inline ble::phy_t tx_phy() const { return activeHost().txPhy; }
+    inline ble::phy_t rx_phy() const { return activeHost().rxPhy; }
+    inline bool advertising_stopped() const { return advertisingStopped_; }
+    inline int active_host() const { return activeHost_; }
+    inline bool host_connected(int index) const { return hosts_[index].connected; }
+    int num_hosts() const;
 
   protected:
-    /** */
-    virtual std::shared_ptr<HIDService> CreateHIDService(BLE &ble) = 0;
+    /** 
+     * Build the HID services in storage owned by the derived class.
+     * Fill @p services with them and return their count (at least one).
+     * The first service defines the device appearance.
+     */
+    virtual int CreateHIDServices(BLE &ble, HIDService *services[kMaxHIDServices]) = 0;
 
     /** Setup the bluetooth HID after BLE initialization. */
     void postInitialization(BLE::InitializationCompleteCallbackContext *params);
 
-    /** Make the device available for connection. */
+    /**
+     * Make the device available for connection, first to the last bonded host
+     * only when it just disconnected.
+     */
     void startAdvertising();
+
+    /** Set the advertising parameters, directed to the last bonded host or not. */
+    void setAdvertisingParameters(bool directed, uint16_t interval = 0);
+
+    /** Restart the advertising schedule from its fast interval. */
+    void resetAdvertisingSchedule();
   
     // -- Gap::EventHandler Callbacks --
     /** Callback when the ble device connect to another device. */
@@ -69,44 +253,147 @@ class MbedBleHID : public Gap::EventHandler,
     void onUpdateConnectionParametersRequest(const ble::UpdateConnectionParametersRequestEvent &event) override;
     
     /** Callback when connection parameters have been updated. */
-    void onConnectionParametersUpdateComplete(const ble::ConnectionParametersUpdateCompleteEvent &event) override {}
+    void onConnectionParametersUpdateComplete(const ble::ConnectionParametersUpdateCompleteEvent &event) override;
+
+    /** Callback when an advertising set stopped, eg. directed advertising timed out. */
+    void onAdvertisingEnd(const ble::AdvertisingEndEvent &event) override;
+
+    /** Callback when the PHY used by the connection changed. */
+    void onPhyUpdateComplete(ble_error_t status, ble::connection_handle_t connectionHandle, ble::phy_t txPhy, ble::phy_t rxPhy) override;
+
+    /** Callback when the link layer maximum payload size changed (LE Data Length Extension). */
+    void onDataLengthChange(ble::connection_handle_t connectionHandle, uint16_t txSize, uint16_t rxSize) override;
+
+    // -- GattServer::EventHandler Callbacks --
+    /** Callback when the ATT MTU has been negotiated. */
+    void onAttMtuChange(ble::connection_handle_t connectionHandle, uint16_t attMtuSize) override;
+
+    /** Callback when a client wrote an attribute, forwarded to the HID services. */
+    void onDataWritten(const GattWriteCallbackParams &params) override;
+
+    /** Callback when a notification has been sent, forwarded to the HID services. */
+    void onDataSent(const GattDataSentCallbackParams &params) override;
 
     // -- SecurityManager::EventHandler Callbacks --
     void pairingRequest(ble::connection_handle_t connectionHandle) override;
-    // void pairingResult(ble::connection_handle_t connectionHandle, SecurityManager::SecurityCompletionStatus_t result) override;
+    void pairingResult(ble::connection_handle_t connectionHandle, SecurityManager::SecurityCompletionStatus_t result) override;
+
+    /** Callback when the link is encrypted, with a new pairing or a known bond. */
+    void linkEncryptionResult(ble::connection_handle_t connectionHandle, ble::link_encryption_t result) override;
+
+    /** Callback with the bonded hosts addresses, set as the filter accept list. */
+    void whitelistFromBondTable(ble::whitelist_t *whitelist) override;
+
+    /** Request the PHY preferred by the policy for a new connection. */
+    void requestPreferredPhy(ble::connection_handle_t connectionHandle);
+
+    /** Tell the HID services the usable payload size of a notification. */
+    void notifyPayloadSize();
+
+    /** Route the reports and align the update task on the host in slot @p index. */
+    void activateHost(int index);
+
+    /** Return the slot of the host connected with @p connectionHandle, or -1. */
+    int findHost(ble::connection_handle_t connectionHandle) const;
 
   protected:
-    const std::string kDeviceName_;
-    const std::string kManufacturerName_;
-    const std::string kVersionString_;
+    // Names are not copied and must outlive the device (eg. string literals).
+    const char *const kDeviceName_;
+    const char *const kManufacturerName_;
+    const char *const kVersionString_;
 
     // The HID-over-GATT Profile (HOGP) requires at least those three services
     // for the device to be recognized as an HID.
+    // They are built in place once the BLE stack is initialized.
     struct {
-      std::unique_ptr<DeviceInformationService> deviceInformation;
-      std::unique_ptr<BatteryService> battery;
-      std::shared_ptr<HIDService> hid;
+      InPlace<DeviceInformationService> deviceInformation;
+      InPlace<BatteryService> battery;
+      HIDService *hid[kMaxHIDServices]{};
+      int numHID = 0;
     } services_;
 
-    // Last connection time tick.
-    uint64_t lastConnection_ = 0uL;
-
     // Last ble error captured.
     ble_error_t error_       = BLE_ERROR_NONE;
-    
-    // State of the connection.
-    bool connected_          = false;
 
+    // PHY policy.
+    PhyPolicy phyPolicy_     = PHY_POLICY_2M;
+    PhyUpdateCallback_t phyUpdateCallback_;
+
+    struct host_address_t {
+      ble::address_t address;
+      ble::target_peer_address_type_t type;
+      bool valid = false;
+    };
+
+    // State of each connection, reset when disconnected but for the address
+    // of the host and how it left, kept until the slot is reused.
+    struct host_t {
+      bool connected           = false;
+      ble::connection_handle_t handle = 0;
+      host_address_t address;
+
+      // Connection time tick and interval.
+      uint64_t lastConnection  = 0uL;
+      ble::conn_interval_t interval;
+
+      // Negotiated ATT MTU and link layer maximum transmit payload size.
+      uint16_t attMtu          = kDefaultAttMtu;
+      uint16_t dataLength      = kDefaultDataLength;
+
+      // PHY currently used by the connection.
+      ble::phy_t txPhy         = ble::phy_t::LE_1M;
+      ble::phy_t rxPhy         = ble::phy_t::LE_1M;
+
+      // Set when the previous connection of this host was lost, used by
+      // PHY_POLICY_2M_CODED_FALLBACK.
+      bool linkLost            = false;
+    };
+    host_t hosts_[kMaxHosts];
+
+    // Slot of the host receiving the reports (disconnected when no host is).
+    int activeHost_          = 0;
+    inline const host_t& activeHost() const { return hosts_[activeHost_]; }
+
+    // Bonding and filter accept list of the bonded hosts.
+    bool bonding_            = true;
+    bool bondedHostsOnly_    = false;
+    const char *bondDbFilepath_ = nullptr;
+    std::remove_pointer<decltype(ble::whitelist_t::addresses)>::type bondedHosts_[kMaxBondedHosts];
+    ble::whitelist_t whitelist_{ bondedHosts_, 0, kMaxBondedHosts };
+
+    // Last bonded host seen, the target of directed advertising right after
+    // it disconnects.
+    host_address_t lastBondedHost_;
+    bool directedAdvertising_ = false;
+
+    // Advertising schedule, with its current step and the time spent in the
+    // previous ones, in seconds.
+    AdvertisingPolicy advertisingPolicy_;
+    int advertisingStep_      = 0;
+    uint32_t advertisingTime_ = 0;
+    uint32_t advertisingStepDuration_ = 0;
+    bool advertisingStopped_  = false;
+
+    // Capture of the input reports, when set.
+    ReportRecorder *reportRecorder_ = nullptr;
 };
 
 /* -------------------------------------------------------------------------- */
 
 /**
-* Wrapper around MbedBleHID for simple HIDService with no parameters other than
-* the BLE instance in their constructors.
+* Wrapper around MbedBleHID for one or several HIDService with no parameters
+* other than the BLE instance in their constructors.
+*
+* Services are stored by value inside the device and are accessed with get<T>(),
+* hence each service type can appear only once.
 */
-template<typename T>
+template<typename... Services>
 class BasicMbedBleHID : public MbedBleHID {
+  static_assert(sizeof...(Services) >= 1, "BasicMbedBleHID requires at least one service.");
+  static_assert(sizeof...(Services) <= kMaxHIDServices, "Too many services for BasicMbedBleHID.");
+
+  using FirstService = typename std::tuple_element<0, std::tuple<Services...>>::type;
+
   public:
     BasicMbedBleHID(const char* deviceName = kDefaultDeviceName,
                     const char* manufacturerName = kDefaultManufacturerName,
@@ -115,17 +402,27 @@ class BasicMbedBleHID : public MbedBleHID {
     {}
     ~BasicMbedBleHID() override {}
 
-    /** Return a raw pointer to the underlying HIDService for user updates. */
-    inline T* hid() { 
-      // [ Hacky, a safer approach would require ffti to use dynamic_pointer_cast
-      // to return the polymorphic shared_ptr. ] 
-      return reinterpret_cast<T *const>(services_.hid.get());
+    /** Return the service of type T for user updates. */
+    template<typename T>
+    inline T& get() {
+      return *std::get<InPlace<T>>(hidServices_);
+    }
+
+    /** Return a raw pointer to the first HIDService for user updates. */
+    inline FirstService* hid() { 
+      return std::get<0>(hidServices_).get();
     }
 
   private:
-    std::shared_ptr<HIDService> CreateHIDService(BLE &ble) override {
-      return std::static_pointer_cast<HIDService>( std::make_shared<T>(ble) );
+    int CreateHIDServices(BLE &ble, HIDService *services[kMaxHIDServices]) override {
+      int count = 0;
+      // (braced lists are evaluated in order, following the Services pack)
+      int expand[] = { 0, (services[count++] = std::get<InPlace<Services>>(hidServices_).emplace(ble), 0)... };
+      (void)expand;
+      return count;
     }
+
+    std::tuple<InPlace<Services>...> hidServices_;
 };
 
 /* -------------------------------------------------------------------------- */
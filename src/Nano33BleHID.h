@@ -6,16 +6,18 @@
 /* -------------------------------------------------------------------------- */
 
 /** Use "Nano33" as an alias for Arduino users. */
-template<typename T>
-using Nano33BleHID = BasicMbedBleHID<T>;
+template<typename... Services>
+using Nano33BleHID = BasicMbedBleHID<Services...>;
 
 #include "services/HIDMouseService.h"
 #include "services/HIDKeyboardService.h"
 #include "services/HIDGamepadService.h"
+#include "services/HIDRawService.h"
 
 using Nano33BleMouse    = Nano33BleHID<HIDMouseService>;
 using Nano33BleKeyboard = Nano33BleHID<HIDKeyboardService>;
 using Nano33BleGamepad  = Nano33BleHID<HIDGamepadService>;
+using Nano33BleRaw      = Nano33BleHID<HIDRawService>;
 
 /* -------------------------------------------------------------------------- */
 
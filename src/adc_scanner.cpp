@@ -0,0 +1,287 @@
+#include <Arduino.h>
+
+#include "adc_scanner.h"
+
+#if defined(NRF52840_XXAA)
+
+#include "nrf_ppi.h"
+#include "nrf_timer.h"
+
+/* -------------------------------------------------------------------------- */
+//
+// Notes :
+//  * A scan is triggered by the SAMPLE task, each channel being converted
+//    kOversample times in a row (burst mode) before its average is written.
+//  * START latches the buffer pointer, so the next one is set as soon as the
+//    STARTED event comes, and the buffer is swapped on the END event.
+//  * The SAMPLE task is triggered through PPI by the COMPARE0 event of a
+//    TIMER, cleared on compare, rather than by a ticker interrupt.
+//
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+static constexpr nrf_saadc_oversample_t kOversample = NRF_SAADC_OVERSAMPLE_8X;
+
+/* Low priority, the BLE stack interrupts coming first. */
+static constexpr uint32_t kInterruptPriority = 6;
+
+/* Timer of the scans and its PPI channel, unused by the Mbed port (its us
+ * ticker runs on TIMER1, the BLE link layer on TIMER0). */
+static NRF_TIMER_Type *const kTimer = NRF_TIMER4;
+static constexpr nrf_ppi_channel_t kPpiChannel = NRF_PPI_CHANNEL19;
+
+/* nRF52840 pins of the analog inputs AIN0 to AIN7. */
+static constexpr int kInputPins[] = { 2, 3, 4, 5, 28, 29, 30, 31 };
+
+static constexpr uint32_t kInterrupts = NRF_SAADC_INT_STARTED
+                                      | NRF_SAADC_INT_END
+                                      | NRF_SAADC_INT_CALIBRATEDONE
+                                      ;
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+AdcScanner& AdcScanner::Get()
+{
+  static AdcScanner sInstance;
+  return sInstance;
+}
+
+AdcScanner::AdcScanner()
+  : numChannels_(0)
+  , running_(false)
+  , filling_(0)
+  , sequence_(0)
+  , numCalibrationBuffers_(0)
+  , calibrationRemaining_(-1)
+{
+  for (int i = 0; i < kMaxChannels; ++i) {
+    pins_[i]   = -1;
+    inputs_[i] = NRF_SAADC_INPUT_DISABLED;
+    values_[i].store(kMaxValue / 2, std::memory_order_relaxed);
+    calibrationSums_[i] = 0;
+  }
+}
+
+int AdcScanner::addPin(int pin)
+{
+  for (int i = 0; i < numChannels_; ++i) {
+    if (pins_[i] == pin) {
+      return i;
+    }
+  }
+  const nrf_saadc_input_t input = PinToInput(pin);
+  if (running_ || (numChannels_ >= kMaxChannels) || (input == NRF_SAADC_INPUT_DISABLED)) {
+    return -1;
+  }
+  pins_[numChannels_]   = pin;
+  inputs_[numChannels_] = input;
+  return numChannels_++;
+}
+
+bool AdcScanner::start(uint32_t periodUs)
+{
+  if (running_) {
+    return true;
+  }
+  if (numChannels_ == 0) {
+    return false;
+  }
+
+  // (the SAADC may have been left enabled by analogRead)
+  nrf_saadc_int_disable(NRF_SAADC_INT_ALL);
+  nrf_saadc_disable();
+
+  // 12-bit over [0, VDD], with a gain of 1/4 on a VDD/4 reference.
+  nrf_saadc_resolution_set(NRF_SAADC_RESOLUTION_12BIT);
+  nrf_saadc_oversample_set(kOversample);
+  for (int i = 0; i < kMaxChannels; ++i) {
+    if (i >= numChannels_) {
+      nrf_saadc_channel_input_set(i, NRF_SAADC_INPUT_DISABLED, NRF_SAADC_INPUT_DISABLED);
+      continue;
+    }
+    nrf_saadc_channel_config_t config;
+    config.resistor_p = NRF_SAADC_RESISTOR_DISABLED;
+    config.resistor_n = NRF_SAADC_RESISTOR_DISABLED;
+    config.gain       = NRF_SAADC_GAIN1_4;
+    config.reference  = NRF_SAADC_REFERENCE_VDD4;
+    config.acq_time   = NRF_SAADC_ACQTIME_10US;
+    config.mode       = NRF_SAADC_MODE_SINGLE_ENDED;
+    config.burst      = NRF_SAADC_BURST_ENABLED;    // (required to oversample in scan mode)
+    config.pin_p      = inputs_[i];
+    config.pin_n      = NRF_SAADC_INPUT_DISABLED;
+    nrf_saadc_channel_init(i, &config);
+  }
+
+  nrf_saadc_event_clear(NRF_SAADC_EVENT_STARTED);
+  nrf_saadc_event_clear(NRF_SAADC_EVENT_END);
+  nrf_saadc_event_clear(NRF_SAADC_EVENT_CALIBRATEDONE);
+  nrf_saadc_event_clear(NRF_SAADC_EVENT_STOPPED);
+  sequence_.store(0, std::memory_order_relaxed);
+  filling_  = 0;
+  running_  = true;
+
+  nrf_saadc_int_enable(kInterrupts);
+  NVIC_SetVector(SAADC_IRQn, reinterpret_cast<uintptr_t>(&AdcScanner::IRQHandler));
+  NVIC_SetPriority(SAADC_IRQn, kInterruptPriority);
+  NVIC_ClearPendingIRQ(SAADC_IRQn);
+  NVIC_EnableIRQ(SAADC_IRQn);
+  nrf_saadc_enable();
+
+  // The conversions start once the offset is calibrated.
+  nrf_saadc_task_trigger(NRF_SAADC_TASK_CALIBRATEOFFSET);
+
+  // A scan every period, counted at 1MHz.
+  nrf_timer_task_trigger(kTimer, NRF_TIMER_TASK_STOP);
+  nrf_timer_mode_set(kTimer, NRF_TIMER_MODE_TIMER);
+  nrf_timer_bit_width_set(kTimer, NRF_TIMER_BIT_WIDTH_32);
+  nrf_timer_frequency_set(kTimer, NRF_TIMER_FREQ_1MHz);
+  nrf_timer_cc_write(kTimer, NRF_TIMER_CC_CHANNEL0, periodUs);
+  nrf_timer_shorts_enable(kTimer, NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK);
+  nrf_timer_task_trigger(kTimer, NRF_TIMER_TASK_CLEAR);
+  nrf_ppi_channel_endpoint_setup(kPpiChannel,
+                                 nrf_timer_event_address_get(kTimer, NRF_TIMER_EVENT_COMPARE0),
+                                 nrf_saadc_task_address_get(NRF_SAADC_TASK_SAMPLE));
+  nrf_ppi_channel_enable(kPpiChannel);
+  nrf_timer_task_trigger(kTimer, NRF_TIMER_TASK_START);
+
+  return true;
+}
+
+void AdcScanner::stop()
+{
+  if (!running_) {
+    return;
+  }
+  running_ = false;
+  nrf_ppi_channel_disable(kPpiChannel);
+  nrf_timer_task_trigger(kTimer, NRF_TIMER_TASK_SHUTDOWN);
+
+  NVIC_DisableIRQ(SAADC_IRQn);
+  nrf_saadc_int_disable(NRF_SAADC_INT_ALL);
+  nrf_saadc_task_trigger(NRF_SAADC_TASK_STOP);
+  while (!nrf_saadc_event_check(NRF_SAADC_EVENT_STOPPED)) {
+  }
+  nrf_saadc_event_clear(NRF_SAADC_EVENT_STOPPED);
+  nrf_saadc_disable();
+}
+
+uint32_t AdcScanner::read(uint16_t *values) const
+{
+  // Read again when the interrupt published new values in between.
+  uint32_t sequence;
+  do {
+    sequence = sequence_.load(std::memory_order_acquire);
+    for (int i = 0; i < numChannels_; ++i) {
+      values[i] = values_[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((sequence & 1) || (sequence != sequence_.load(std::memory_order_relaxed)));
+
+  return sequence / 2;
+}
+
+void AdcScanner::calibrate(int numBuffers)
+{
+  // (stop the accumulation before clearing it, the interrupt may come anytime)
+  calibrationRemaining_.store(-1, std::memory_order_release);
+  for (auto &sum : calibrationSums_) {
+    sum = 0;
+  }
+  numCalibrationBuffers_ = (numBuffers > 0) ? numBuffers : 1;
+  calibrationRemaining_.store(numCalibrationBuffers_, std::memory_order_release);
+}
+
+float AdcScanner::calibration(int channel) const
+{
+  if (!calibrated()) {
+    return kMaxValue / 2.0f;
+  }
+  return static_cast<float>(calibrationSums_[channel]) / (numCalibrationBuffers_ * kScansPerBuffer);
+}
+
+void AdcScanner::Average(const nrf_saadc_value_t *buffer, int numChannels, int numScans, uint16_t *out)
+{
+  for (int i = 0; i < numChannels; ++i) {
+    uint32_t sum = 0;
+    for (int scan = 0; scan < numScans; ++scan) {
+      const nrf_saadc_value_t value = buffer[scan * numChannels + i];
+      sum += (value > 0) ? value : 0;
+    }
+    out[i] = static_cast<uint16_t>((sum + numScans / 2) / numScans);
+  }
+}
+
+nrf_saadc_input_t AdcScanner::PinToInput(int pin)
+{
+  const int pinName = static_cast<int>(digitalPinToPinName(pin));
+  for (int i = 0; i < static_cast<int>(sizeof(kInputPins) / sizeof(*kInputPins)); ++i) {
+    if (kInputPins[i] == pinName) {
+      return static_cast<nrf_saadc_input_t>(NRF_SAADC_INPUT_AIN0 + i);
+    }
+  }
+  return NRF_SAADC_INPUT_DISABLED;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AdcScanner::IRQHandler()
+{
+  Get().onInterrupt();
+}
+
+void AdcScanner::onInterrupt()
+{
+  if (nrf_saadc_event_check(NRF_SAADC_EVENT_CALIBRATEDONE)) {
+    nrf_saadc_event_clear(NRF_SAADC_EVENT_CALIBRATEDONE);
+    nrf_saadc_buffer_init(buffers_[filling_], bufferSize());
+    nrf_saadc_task_trigger(NRF_SAADC_TASK_START);
+  }
+
+  if (nrf_saadc_event_check(NRF_SAADC_EVENT_STARTED)) {
+    nrf_saadc_event_clear(NRF_SAADC_EVENT_STARTED);
+    nrf_saadc_buffer_init(buffers_[filling_ ^ 1], bufferSize());
+  }
+
+  if (nrf_saadc_event_check(NRF_SAADC_EVENT_END)) {
+    nrf_saadc_event_clear(NRF_SAADC_EVENT_END);
+    const int done = filling_;
+    filling_ ^= 1;
+    if (running_) {
+      nrf_saadc_task_trigger(NRF_SAADC_TASK_START);
+    }
+    publish(buffers_[done]);
+  }
+}
+
+void AdcScanner::publish(const nrf_saadc_value_t *buffer)
+{
+  uint16_t averages[kMaxChannels];
+  Average(buffer, numChannels_, kScansPerBuffer, averages);
+
+  const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+  sequence_.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (int i = 0; i < numChannels_; ++i) {
+    values_[i].store(averages[i], std::memory_order_relaxed);
+  }
+  sequence_.store(sequence + 2, std::memory_order_release);
+
+  // Background calibration, on the samples rather than their rounded average.
+  const int remaining = calibrationRemaining_.load(std::memory_order_acquire);
+  if (remaining > 0) {
+    for (int scan = 0; scan < kScansPerBuffer; ++scan) {
+      for (int i = 0; i < numChannels_; ++i) {
+        const nrf_saadc_value_t value = buffer[scan * numChannels_ + i];
+        calibrationSums_[i] += (value > 0) ? value : 0;
+      }
+    }
+    calibrationRemaining_.store(remaining - 1, std::memory_order_release);
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+
+#endif // NRF52840_XXAA
@@ -0,0 +1,117 @@
+#ifndef ADC_SCANNER_H_
+#define ADC_SCANNER_H_
+
+// The scanner drives the nRF52840 SAADC, TIMER and PPI peripherals directly.
+#if defined(NRF52840_XXAA)
+
+#include <atomic>
+#include <cstdint>
+
+#include "nrf_saadc.h"
+
+/* -------------------------------------------------------------------------- */
+
+/**
+* Background acquisition of analog pins with the nRF52 SAADC.
+*
+* The pins are converted in scan mode, each one oversampled 8 times by the
+* hardware, and EasyDMA writes the scans into one half of a double buffer
+* while the other half is averaged by the SAADC interrupt. A TIMER compare
+* event triggers a scan every period through PPI, so the CPU only wakes up for
+* the SAADC events, and reading the latest values never blocks nor waits for
+* a conversion.
+*
+* The offset of the rest position can be averaged in the background too, over
+* the next buffers following calibrate().
+*
+* There is a single SAADC : pins are added to the shared instance before
+* start(), and analogRead() must not be used while it runs.
+*/
+class AdcScanner {
+  public:
+    static constexpr int kMaxChannels       = NRF_SAADC_CHANNEL_COUNT;
+    static constexpr int kScansPerBuffer    = 2;
+    static constexpr int kMaxValue          = 4095;     // 12-bit conversions.
+    static constexpr uint32_t kDefaultPeriodUs        = 1000;
+    static constexpr int kDefaultCalibrationBuffers   = 32;
+
+    static AdcScanner& Get();
+
+    /** Add the analog Arduino @p pin to the scan, return its channel or -1. */
+    int addPin(int pin);
+
+    /** Start scanning every @p periodUs, return false without pins. */
+    bool start(uint32_t periodUs = kDefaultPeriodUs);
+    void stop();
+
+    /**
+     * Copy the latest averaged value of every channel to @p values, in
+     * [0, kMaxValue]. Return the number of buffers averaged since start(), 0
+     * while there is none.
+     */
+    uint32_t read(uint16_t *values) const;
+
+    /** Latest averaged value of @p channel, in [0, kMaxValue]. */
+    inline uint16_t value(int channel) const {
+      return values_[channel].load(std::memory_order_relaxed);
+    }
+
+    /** Average the @p numBuffers next buffers as the rest position. */
+    void calibrate(int numBuffers = kDefaultCalibrationBuffers);
+
+    inline bool calibrated() const {
+      return calibrationRemaining_.load(std::memory_order_acquire) == 0;
+    }
+
+    /** Rest position of @p channel, in [0, kMaxValue], mid-range until calibrated. */
+    float calibration(int channel) const;
+
+    inline int numChannels() const { return numChannels_; }
+    inline bool running() const { return running_; }
+
+    /**
+     * Average the @p numScans interleaved scans of @p numChannels samples of
+     * @p buffer into @p out, rounded to nearest. Negative samples (the
+     * single-ended offset) count as 0.
+     */
+    static void Average(const nrf_saadc_value_t *buffer, int numChannels, int numScans, uint16_t *out);
+
+    /** SAADC input of an Arduino pin, NRF_SAADC_INPUT_DISABLED when not analog. */
+    static nrf_saadc_input_t PinToInput(int pin);
+
+  private:
+    AdcScanner();
+    AdcScanner(const AdcScanner&) = delete;
+    AdcScanner& operator=(const AdcScanner&) = delete;
+
+    static void IRQHandler();
+
+    void onInterrupt();
+    void publish(const nrf_saadc_value_t *buffer);
+
+    inline uint32_t bufferSize() const { return kScansPerBuffer * numChannels_; }
+
+    int pins_[kMaxChannels];
+    nrf_saadc_input_t inputs_[kMaxChannels];
+    int numChannels_;
+    bool running_;
+
+    // Double buffer written by EasyDMA, filling_ being the one in use.
+    nrf_saadc_value_t buffers_[2][kScansPerBuffer * kMaxChannels];
+    int filling_;
+
+    // Latest averages, with a sequence counter odd while they are written.
+    std::atomic<uint16_t> values_[kMaxChannels];
+    std::atomic<uint32_t> sequence_;
+
+    // Sums of the calibration buffers, complete when no buffer remains.
+    uint32_t calibrationSums_[kMaxChannels];
+    int numCalibrationBuffers_;
+    std::atomic<int> calibrationRemaining_;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // NRF52840_XXAA
+
+#endif // ADC_SCANNER_H_
@@ -0,0 +1,204 @@
+#ifndef AIR_MOUSE_H_
+#define AIR_MOUSE_H_
+
+#include <cstdint>
+
+#include "fixed_point.h"
+#include "gyro_bias_estimator.h"
+#include "mahony_filter.h"
+#include "signal_utils.h"
+
+/* -------------------------------------------------------------------------- */
+
+/**
+* Air mouse : the pointer follows the rotations of an IMU pointing along the
+* X axis of its sensor.
+*
+* Each sample goes through the gyro bias estimation and the Mahony fusion,
+* whose tilt gives the earth vertical in the sensor frame. The horizontal
+* motion is the angular rate around the vertical and the vertical motion the
+* rate around the horizontal axis orthogonal to the pointing direction, so
+* the pointer does not depend on how the device is rolled in the hand.
+*
+* The rates below a threshold are faded out by a smoothstep to hide the hand
+* tremor and the residual bias, then scaled to HID counts by the gain. The
+* fractions of counts are kept from one report to the next.
+*
+* Samples are processed at the fixed IMU output rate, in integer arithmetic
+* only, eg. in bursts read from the IMU FIFO.
+*/
+class AirMouse {
+  public:
+    /** Raw IMU sample, in the sensor axes and LSB. */
+    struct sample_t {
+      int16_t accel[3];
+      int16_t gyro[3];
+    };
+
+    static constexpr float kDefaultGain           = 16.0f;  // In counts per degree.
+    static constexpr float kDefaultMinRate        = 1.0f;   // Rate faded out, in degrees per second.
+    static constexpr float kDefaultFullRate       = 4.0f;   // Rate fully followed, in degrees per second.
+    static constexpr float kStillThreshold        = 3.0f;   // Variation of a still gyro, in degrees per second.
+    static constexpr float kMinHorizontal         = 0.2f;   // Horizontal part of the pointing axis to move vertically.
+    static constexpr float kAccelTolerance        = 0.25f;  // Accelerometer deviation from 1g used by the fusion, in g.
+    static constexpr int kMaxCount                = 127;    // HID counts per report.
+
+    /**
+     * @p sampleRate       : IMU output rate, in Hz.
+     * @p gyroSensitivity  : in degrees per second per LSB.
+     * @p accelSensitivity : in g per LSB.
+     */
+    AirMouse(float sampleRate, float gyroSensitivity, float accelSensitivity)
+      : sampleRate_(sampleRate)
+      , gyroSensitivity_(gyroSensitivity)
+      , accelMin2_(Square((1.0f - kAccelTolerance) / accelSensitivity))
+      , accelMax2_(Square((1.0f + kAccelTolerance) / accelSensitivity))
+      , minHorizontal_(Q30(kMinHorizontal))
+      , bias_(static_cast<int32_t>(kStillThreshold / gyroSensitivity))
+      , fusion_(sampleRate, gyroSensitivity * (3.14159265f / 180.0f) / (1 << GyroBiasEstimator::kFracBits))
+    {
+      setGain(kDefaultGain);
+      setDeadZone(kDefaultMinRate, kDefaultFullRate);
+      reset();
+    }
+
+    /** Set the pointer speed, in counts per degree. */
+    void setGain(float countsPerDegree) {
+      // Counts of a corrected gyro unit during a sample, in 2^-kCountFracBits.
+      const float scale = countsPerDegree * gyroSensitivity_ / sampleRate_ / (1 << GyroBiasEstimator::kFracBits);
+      countScale_ = static_cast<int64_t>(scale * static_cast<float>(int64_t(1) << kCountFracBits) + 0.5f);
+    }
+
+    /** Fade out the rates below @p fullRate, ignoring those below @p minRate (in degrees per second). */
+    void setDeadZone(float minRate, float fullRate) {
+      // (in corrected gyro units, smoothstep only using their ratio)
+      const float unit = gyroSensitivity_ / (1 << GyroBiasEstimator::kFracBits);
+      minRate_  = Q16::FromRaw(static_cast<int32_t>(minRate / unit));
+      fullRate_ = Q16::FromRaw(static_cast<int32_t>(fullRate / unit));
+    }
+
+    /** Start over, estimating the gyro bias again. */
+    void reset() {
+      bias_.reset();
+      fusion_.reset();
+      initialized_ = false;
+      remainder_x_ = 0;
+      remainder_y_ = 0;
+    }
+
+    /** Process the next IMU sample. */
+    void update(const sample_t &sample) {
+      const bool biased = !bias_.valid();
+      bias_.update(sample.gyro);
+
+      const int64_t accel2 = int64_t(sample.accel[0]) * sample.accel[0]
+                           + int64_t(sample.accel[1]) * sample.accel[1]
+                           + int64_t(sample.accel[2]) * sample.accel[2];
+      const bool gravity = (accel2 >= accelMin2_) && (accel2 <= accelMax2_);
+      if (!initialized_ || (biased && bias_.valid())) {
+        // Start from the measured tilt rather than converging to it, and
+        // again once the bias is known as it was integrated until then.
+        if (!gravity) {
+          return;
+        }
+        fusion_.reset(sample.accel);
+        initialized_ = true;
+      }
+
+      int32_t gyro[3];
+      bias_.correct(sample.gyro, gyro);
+      fusion_.update(gyro, gravity ? sample.accel : nullptr);
+
+      if (!bias_.valid()) {
+        return;
+      }
+
+      // Vertical, and horizontal axis orthogonal to the pointing one : up x X.
+      Q30 up[3];
+      fusion_.up(up);
+      const uint32_t horizontal = ISqrt(uint64_t(int64_t(up[1].raw()) * up[1].raw()
+                                               + int64_t(up[2].raw()) * up[2].raw()));
+
+      // Rates around them, in corrected gyro units (pointer y going down).
+      const int32_t rate_x = -Dot(gyro, up);
+      const int32_t rate_y = (horizontal < static_cast<uint32_t>(minHorizontal_.raw())) ? 0
+        : static_cast<int32_t>((int64_t(gyro[1]) * up[2].raw() - int64_t(gyro[2]) * up[1].raw()) / horizontal);
+
+      const int32_t abs_x = (rate_x < 0) ? -rate_x : rate_x;
+      const int32_t abs_y = (rate_y < 0) ? -rate_y : rate_y;
+      const Q16 weight = smoothstep(minRate_, fullRate_, Q16::FromRaw((abs_x > abs_y) ? abs_x : abs_y));
+
+      remainder_x_ = Accumulate(remainder_x_, scaleRate(rate_x, weight));
+      remainder_y_ = Accumulate(remainder_y_, scaleRate(rate_y, weight));
+    }
+
+    /** Take the whole counts moved since the last call, in [-kMaxCount, kMaxCount]. */
+    void takeMotion(int *dx, int *dy) {
+      *dx = Take(&remainder_x_);
+      *dy = Take(&remainder_y_);
+    }
+
+    /** Is the gyro bias known ? The pointer does not move until then. */
+    inline bool ready() const { return bias_.valid(); }
+
+    inline const GyroBiasEstimator& bias() const { return bias_; }
+    inline const MahonyFilter& fusion() const { return fusion_; }
+
+  private:
+    static constexpr int kCountFracBits     = 40;   // Count scale, in 2^-40 counts.
+    static constexpr int kRemainderFracBits = 16;   // Pending counts, in 2^-16 counts.
+    static constexpr int32_t kMaxRemainder  = (2 * kMaxCount) << kRemainderFracBits;
+
+    static constexpr int64_t Square(float x) {
+      return static_cast<int64_t>(x * x);
+    }
+
+    /* Dot product of a corrected gyro sample and a Q30 vector, in corrected gyro units. */
+    static inline int32_t Dot(const int32_t gyro[3], const Q30 v[3]) {
+      const int64_t dot = int64_t(gyro[0]) * v[0].raw()
+                        + int64_t(gyro[1]) * v[1].raw()
+                        + int64_t(gyro[2]) * v[2].raw();
+      return static_cast<int32_t>(dot >> Q30::kFractionalBits);
+    }
+
+    /* Counts of @p rate during a sample, faded by @p weight, in 2^-kRemainderFracBits. */
+    inline int64_t scaleRate(int32_t rate, Q16 weight) const {
+      const int64_t counts = (rate * countScale_) >> (kCountFracBits - kRemainderFracBits);
+      return (counts * weight.raw()) >> Q16::kFractionalBits;
+    }
+
+    /* Add @p counts to the pending ones, bounded to a couple of reports. */
+    static inline int32_t Accumulate(int32_t remainder, int64_t counts) {
+      const int64_t sum = remainder + counts;
+      return static_cast<int32_t>((sum > kMaxRemainder) ? kMaxRemainder : (sum < -kMaxRemainder) ? -kMaxRemainder : sum);
+    }
+
+    /* Take the pending counts rounded to nearest, keeping their fraction. */
+    static inline int Take(int32_t *remainder) {
+      int32_t counts = (*remainder + (1 << (kRemainderFracBits - 1))) >> kRemainderFracBits;
+      counts = (counts > kMaxCount) ? kMaxCount : (counts < -kMaxCount) ? -kMaxCount : counts;
+      *remainder -= counts * (1 << kRemainderFracBits);
+      return counts;
+    }
+
+    float sampleRate_;
+    float gyroSensitivity_;
+    int64_t accelMin2_;
+    int64_t accelMax2_;
+    Q30 minHorizontal_;
+    int64_t countScale_;
+    Q16 minRate_;
+    Q16 fullRate_;
+
+    GyroBiasEstimator bias_;
+    MahonyFilter fusion_;
+    bool initialized_;
+
+    // Pending counts, in 2^-kRemainderFracBits.
+    int32_t remainder_x_;
+    int32_t remainder_y_;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // AIR_MOUSE_H_
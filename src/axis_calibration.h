@@ -0,0 +1,102 @@
+#ifndef AXIS_CALIBRATION_H_
+#define AXIS_CALIBRATION_H_
+
+#include <cmath>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+* Calibration of an analog axis : its rest position and its range, in ADC
+* units, mapping the samples to [-1, 1].
+*
+* The range grows with the extreme samples, from a default span around the
+* rest position. The rest position follows the samples slowly while the axis
+* is still close to it, so it tracks the drift of the potentiometer (eg. with
+* the temperature) without any explicit calibration step.
+*/
+class AxisCalibration {
+  public:
+    /** Persistent state. */
+    struct data_t {
+      float center;
+      float minimum;
+      float maximum;
+    };
+
+    static constexpr float kDefaultSpan       = 0.8f;     // Initial range, fraction of the full scale.
+    static constexpr float kRestThreshold     = 0.03f;    // Distance to the center at rest, fraction of the range.
+    static constexpr float kStillThreshold    = 0.005f;   // Variation between samples at rest, fraction of the range.
+    static constexpr float kRestDelay         = 0.25f;    // Time still before tracking, in seconds.
+    static constexpr float kDriftTimeConstant = 2.0f;     // In seconds.
+
+    explicit AxisCalibration(float fullScale)
+      : fullScale_(fullScale)
+    {
+      reset(0.5f * fullScale);
+    }
+
+    /** Start over from the rest position @p center, with the default range. */
+    void reset(float center) {
+      const float halfSpan = 0.5f * kDefaultSpan * fullScale_;
+      data_.center  = center;
+      data_.minimum = (center - halfSpan > 0.0f) ? center - halfSpan : 0.0f;
+      data_.maximum = (center + halfSpan < fullScale_) ? center + halfSpan : fullScale_;
+      restTime_     = 0.0f;
+      last_         = NAN;
+    }
+
+    /** Use a stored calibration, return false when it is not consistent. */
+    bool load(const data_t &data) {
+      if (!(data.minimum >= 0.0f) || !(data.maximum <= fullScale_)
+       || !(data.minimum < data.center) || !(data.center < data.maximum)) {
+        return false;
+      }
+      data_     = data;
+      restTime_ = 0.0f;
+      last_     = NAN;
+      return true;
+    }
+
+    /** Refine the calibration with a sample taken @p dt seconds after the previous one. */
+    void track(float sample, float dt) {
+      data_.minimum = (sample < data_.minimum) ? sample : data_.minimum;
+      data_.maximum = (sample > data_.maximum) ? sample : data_.maximum;
+
+      const float range = data_.maximum - data_.minimum;
+      const bool still = fabsf(sample - last_) < kStillThreshold * range;
+      const bool close = fabsf(sample - data_.center) < kRestThreshold * range;
+      restTime_ = (still && close) ? restTime_ + dt : 0.0f;
+      last_ = sample;
+
+      if (restTime_ >= kRestDelay) {
+        data_.center += dt / (kDriftTimeConstant + dt) * (sample - data_.center);
+      }
+    }
+
+    /** Map @p sample to [-1, 1], each side of the rest position on its own. */
+    float normalize(float sample) const {
+      const float x = (sample < data_.center) ? (sample - data_.center) / (data_.center - data_.minimum)
+                                              : (sample - data_.center) / (data_.maximum - data_.center);
+      return (x < -1.0f) ? -1.0f : (x > 1.0f) ? 1.0f : x;
+    }
+
+    /** Has the calibration moved by more than @p tolerance ADC units from @p data ? */
+    bool differs(const data_t &data, float tolerance) const {
+      return (fabsf(data_.center - data.center) > tolerance)
+          || (fabsf(data_.minimum - data.minimum) > tolerance)
+          || (fabsf(data_.maximum - data.maximum) > tolerance);
+    }
+
+    inline bool resting() const { return restTime_ >= kRestDelay; }
+    inline const data_t& data() const { return data_; }
+
+  private:
+    float fullScale_;
+    data_t data_;
+    float restTime_;
+    float last_;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // AXIS_CALIBRATION_H_
@@ -0,0 +1,88 @@
+#include <cstring>
+
+#include <mbed.h>
+#include "kvstore_global_api.h"
+
+#include "calibration_store.h"
+
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+/* Header stored before the record. */
+struct header_t {
+  uint16_t version;
+  uint16_t size;
+  uint32_t checksum;
+};
+
+/* CRC-32 (IEEE 802.3) of the record, bitwise as records are small and rare. */
+uint32_t Checksum(const uint8_t *data, size_t size)
+{
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < size; ++i) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+  }
+  return ~crc;
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+namespace calibration_store {
+
+bool Load(const char *key, uint16_t version, void *data, size_t size)
+{
+  if (size > kMaxSize) {
+    return false;
+  }
+
+  uint8_t buffer[sizeof(header_t) + kMaxSize];
+  size_t actualSize = 0;
+  if (kv_get(key, buffer, sizeof(buffer), &actualSize) != MBED_SUCCESS) {
+    return false;
+  }
+
+  header_t header;
+  memcpy(&header, buffer, sizeof(header));
+  const uint8_t *record = buffer + sizeof(header);
+  if ((actualSize != sizeof(header) + size)
+   || (header.version != version)
+   || (header.size != size)
+   || (header.checksum != Checksum(record, size))) {
+    return false;
+  }
+
+  memcpy(data, record, size);
+  return true;
+}
+
+bool Save(const char *key, uint16_t version, const void *data, size_t size)
+{
+  if (size > kMaxSize) {
+    return false;
+  }
+
+  uint8_t buffer[sizeof(header_t) + kMaxSize];
+  header_t header;
+  header.version  = version;
+  header.size     = static_cast<uint16_t>(size);
+  header.checksum = Checksum(static_cast<const uint8_t*>(data), size);
+  memcpy(buffer, &header, sizeof(header));
+  memcpy(buffer + sizeof(header), data, size);
+
+  return kv_set(key, buffer, sizeof(header) + size, 0) == MBED_SUCCESS;
+}
+
+bool Remove(const char *key)
+{
+  return kv_remove(key) == MBED_SUCCESS;
+}
+
+} // namespace calibration_store
+
+/* -------------------------------------------------------------------------- */
@@ -0,0 +1,50 @@
+#ifndef CALIBRATION_STORE_H_
+#define CALIBRATION_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+* Calibration records kept across resets in the Mbed KVStore.
+*
+* Records are stored with their version, size and checksum : those written by
+* another version of the firmware, or corrupted, are ignored so the caller
+* falls back to its defaults.
+*
+* Saving erases and writes flash pages, which takes a few milliseconds and
+* wears the flash : save rarely, and preferably while disconnected.
+*/
+namespace calibration_store {
+
+/** Largest record, in bytes. */
+static constexpr size_t kMaxSize = 64;
+
+/** Read the record @p key of @p version into @p data, return false when missing or invalid. */
+bool Load(const char *key, uint16_t version, void *data, size_t size);
+
+bool Save(const char *key, uint16_t version, const void *data, size_t size);
+
+bool Remove(const char *key);
+
+template<typename T>
+inline bool Load(const char *key, uint16_t version, T *data) {
+  static_assert(std::is_trivially_copyable<T>::value, "Calibration records must be trivially copyable.");
+  static_assert(sizeof(T) <= kMaxSize, "Calibration record too large.");
+  return Load(key, version, data, sizeof(T));
+}
+
+template<typename T>
+inline bool Save(const char *key, uint16_t version, const T &data) {
+  static_assert(std::is_trivially_copyable<T>::value, "Calibration records must be trivially copyable.");
+  static_assert(sizeof(T) <= kMaxSize, "Calibration record too large.");
+  return Save(key, version, &data, sizeof(T));
+}
+
+} // namespace calibration_store
+
+/* -------------------------------------------------------------------------- */
+
+#endif // CALIBRATION_STORE_H_
@@ -0,0 +1,81 @@
+#ifndef DELAY_HISTOGRAM_H_
+#define DELAY_HISTOGRAM_H_
+
+#include <cstdint>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+* Fixed-size histogram of delays in microseconds, with linear buckets.
+*
+* Delays beyond the last bucket are accumulated in it, min and max being
+* tracked exactly.
+*
+* When a bucket is about to saturate, every bucket is halved : the
+* distribution keeps its shape and older delays weigh less, so percentiles
+* stay meaningful over long runs (a bucket fills in 8 minutes at 7.5 ms).
+*/
+class DelayHistogram {
+  public:
+    static constexpr int      kNumBuckets  = 64;
+    static constexpr uint32_t kBucketWidth = 500;   // in microseconds.
+
+    DelayHistogram() { reset(); }
+
+    void reset() {
+      for (auto &b : buckets_) {
+        b = 0;
+      }
+      count_ = 0;
+      min_   = UINT32_MAX;
+      max_   = 0;
+    }
+
+    void add(uint32_t delay) {
+      uint32_t index = delay / kBucketWidth;
+      index = (index < kNumBuckets) ? index : kNumBuckets - 1;
+      if (buckets_[index] == UINT16_MAX) {
+        for (auto &b : buckets_) {
+          b = (b + 1) / 2;
+        }
+      }
+      ++buckets_[index];
+      ++count_;
+      min_ = (delay < min_) ? delay : min_;
+      max_ = (delay > max_) ? delay : max_;
+    }
+
+    /* Return the upper bound of the bucket holding the p-th percentile (p in [0, 100]). */
+    uint32_t percentile(uint32_t p) const {
+      uint32_t total = 0;
+      for (auto b : buckets_) {
+        total += b;
+      }
+      const uint32_t rank = (total * p + 99) / 100;
+      uint32_t accum = 0;
+      for (int i = 0; i < kNumBuckets; ++i) {
+        accum += buckets_[i];
+        if (accum >= rank && accum > 0) {
+          const uint32_t upper = (i + 1) * kBucketWidth;
+          return (upper < max_) ? upper : max_;
+        }
+      }
+      return max_;
+    }
+
+    /* Number of delays added, the buckets only keep their distribution. */
+    inline uint32_t count() const { return count_; }
+    inline uint32_t minimum() const { return count_ ? min_ : 0; }
+    inline uint32_t maximum() const { return max_; }
+    inline uint16_t bucket(int i) const { return buckets_[i]; }
+
+  private:
+    uint16_t buckets_[kNumBuckets];
+    uint32_t count_;
+    uint32_t min_;
+    uint32_t max_;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // DELAY_HISTOGRAM_H_
@@ -0,0 +1,122 @@
+#ifndef FIXED_POINT_H_
+#define FIXED_POINT_H_
+
+#include <cstdint>
+#include <limits>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+* Signed fixed-point number with kFracBits fractional bits, stored in Storage
+* and computed in Wide, for signal processing without the FPU.
+*
+* Every operation saturates instead of wrapping around, as the Cortex-M4 DSP
+* instructions do, and conversions round to nearest. All of it is constexpr,
+* so constants are converted at compile time.
+*/
+template<int kFracBits, typename Storage, typename Wide>
+class Fixed {
+  public:
+    static constexpr int kFractionalBits = kFracBits;
+    static constexpr Wide kOne = Wide(1) << kFracBits;
+
+    constexpr Fixed() : raw_(0) {}
+
+    /** Convert @p value, saturated to the range of the type. */
+    constexpr explicit Fixed(float value) : raw_(FromFloatRaw(value)) {}
+
+    static constexpr Fixed FromRaw(Storage raw) {
+      return Fixed(raw, 0);
+    }
+
+    /** Return the value of @p raw saturated to the range of the type. */
+    static constexpr Fixed Saturate(Wide raw) {
+      return Fixed(
+        (raw > kMaxRaw) ? kMaxRaw : (raw < kMinRaw) ? kMinRaw : static_cast<Storage>(raw), 0
+      );
+    }
+
+    static constexpr Fixed Max() { return FromRaw(kMaxRaw); }
+    static constexpr Fixed Min() { return FromRaw(kMinRaw); }
+
+    constexpr Storage raw() const { return raw_; }
+    constexpr float toFloat() const { return static_cast<float>(raw_) / kOne; }
+
+    constexpr Fixed operator-() const { return Saturate(-Wide(raw_)); }
+
+    constexpr Fixed operator+(Fixed b) const { return Saturate(Wide(raw_) + b.raw_); }
+    constexpr Fixed operator-(Fixed b) const { return Saturate(Wide(raw_) - b.raw_); }
+
+    constexpr Fixed operator*(Fixed b) const {
+      return Saturate((Wide(raw_) * b.raw_ + (kOne >> 1)) >> kFracBits);
+    }
+
+    /** Division, saturated when dividing by zero. */
+    constexpr Fixed operator/(Fixed b) const {
+      return (b.raw_ == 0) ? ((raw_ < 0) ? Min() : Max())
+                           : Saturate((Wide(raw_) * kOne) / b.raw_);
+    }
+
+    Fixed& operator+=(Fixed b) { return *this = *this + b; }
+    Fixed& operator-=(Fixed b) { return *this = *this - b; }
+    Fixed& operator*=(Fixed b) { return *this = *this * b; }
+    Fixed& operator/=(Fixed b) { return *this = *this / b; }
+
+    constexpr bool operator==(Fixed b) const { return raw_ == b.raw_; }
+    constexpr bool operator!=(Fixed b) const { return raw_ != b.raw_; }
+    constexpr bool operator< (Fixed b) const { return raw_ <  b.raw_; }
+    constexpr bool operator> (Fixed b) const { return raw_ >  b.raw_; }
+    constexpr bool operator<=(Fixed b) const { return raw_ <= b.raw_; }
+    constexpr bool operator>=(Fixed b) const { return raw_ >= b.raw_; }
+
+  private:
+    static constexpr Storage kMaxRaw = std::numeric_limits<Storage>::max();
+    static constexpr Storage kMinRaw = std::numeric_limits<Storage>::min();
+
+    constexpr Fixed(Storage raw, int) : raw_(raw) {}
+
+    static constexpr Storage FromFloatRaw(float value) {
+      return (value * kOne >= static_cast<float>(kMaxRaw)) ? kMaxRaw
+           : (value * kOne <= static_cast<float>(kMinRaw)) ? kMinRaw
+           : static_cast<Storage>(value * kOne + ((value < 0.0f) ? -0.5f : 0.5f));
+    }
+
+    Storage raw_;
+};
+
+// (definitions of the static members, which may be odr-used in C++14)
+template<int kFracBits, typename Storage, typename Wide>
+constexpr int Fixed<kFracBits, Storage, Wide>::kFractionalBits;
+template<int kFracBits, typename Storage, typename Wide>
+constexpr Wide Fixed<kFracBits, Storage, Wide>::kOne;
+template<int kFracBits, typename Storage, typename Wide>
+constexpr Storage Fixed<kFracBits, Storage, Wide>::kMaxRaw;
+template<int kFracBits, typename Storage, typename Wide>
+constexpr Storage Fixed<kFracBits, Storage, Wide>::kMinRaw;
+
+/* Values in [-1, 1[ with a 2^-15 resolution, as the 16-bit DSP instructions. */
+using Q15 = Fixed<15, int16_t, int32_t>;
+
+/* Values in [-32768, 32768[ with a 2^-16 resolution. */
+using Q16 = Fixed<16, int32_t, int64_t>;
+
+/* Values in [-2, 2[ with a 2^-30 resolution, eg. for unit vectors and quaternions. */
+using Q30 = Fixed<30, int32_t, int64_t>;
+
+/* Integer square root of @p x, rounded down, bit by bit. */
+constexpr uint32_t ISqrt(uint64_t x) {
+  uint64_t root = 0;
+  for (uint64_t bit = uint64_t(1) << 62; bit != 0; bit >>= 2) {
+    if (x >= root + bit) {
+      x    -= root + bit;
+      root  = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+  }
+  return static_cast<uint32_t>(root);
+}
+
+/* -------------------------------------------------------------------------- */
+
+#endif // FIXED_POINT_H_
@@ -0,0 +1,113 @@
+#ifndef GYRO_BIAS_ESTIMATOR_H_
+#define GYRO_BIAS_ESTIMATOR_H_
+
+#include <cstdint>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+* Estimation of the zero-rate offset of a gyroscope, from the windows of
+* samples where the device is still.
+*
+* The samples are gathered in consecutive windows, keeping only their sum and
+* range : a window is still when no axis varies by more than the threshold,
+* and its mean then updates the bias (set by the first one, then followed with
+* an exponential average so it tracks the drift with the temperature).
+*
+* Integer arithmetic only, the bias being kept in 1/256 LSB.
+*/
+class GyroBiasEstimator {
+  public:
+    static constexpr int kFracBits      = 8;      // Bias and corrected samples in 2^-8 LSB.
+    static constexpr int kDefaultWindow = 128;    // In samples, about 0.5s at 238Hz.
+    static constexpr int kUpdateShift   = 2;      // Weight of a still window, as 2^-kUpdateShift.
+
+    /** @p stillThreshold : largest variation of an axis over a still window, in LSB. */
+    explicit GyroBiasEstimator(int32_t stillThreshold, int window = kDefaultWindow)
+      : stillThreshold_(stillThreshold)
+      , window_(window)
+    {
+      reset();
+    }
+
+    /** Forget the bias, until the next still window. */
+    void reset() {
+      for (int i = 0; i < 3; ++i) {
+        bias_[i] = 0;
+      }
+      valid_ = false;
+      still_ = false;
+      restart();
+    }
+
+    /** Add a sample, in LSB. Return true when it completed a still window. */
+    bool update(const int16_t gyro[3]) {
+      for (int i = 0; i < 3; ++i) {
+        sum_[i] += gyro[i];
+        min_[i]  = (gyro[i] < min_[i]) ? gyro[i] : min_[i];
+        max_[i]  = (gyro[i] > max_[i]) ? gyro[i] : max_[i];
+      }
+      if (++count_ < window_) {
+        return false;
+      }
+
+      still_ = true;
+      for (int i = 0; i < 3; ++i) {
+        still_ = still_ && (max_[i] - min_[i] <= stillThreshold_);
+      }
+      if (still_) {
+        for (int i = 0; i < 3; ++i) {
+          // Mean of the window, rounded to nearest.
+          const int64_t scaled = int64_t(sum_[i]) * (1 << kFracBits);
+          const int32_t mean = static_cast<int32_t>((scaled + ((scaled < 0) ? -window_ : window_) / 2) / window_);
+          bias_[i] = valid_ ? bias_[i] + ((mean - bias_[i]) >> kUpdateShift) : mean;
+        }
+        valid_ = true;
+      }
+      restart();
+      return still_;
+    }
+
+    /** Write @p gyro without its bias to @p out, in 2^-kFracBits LSB. */
+    void correct(const int16_t gyro[3], int32_t out[3]) const {
+      for (int i = 0; i < 3; ++i) {
+        out[i] = gyro[i] * (1 << kFracBits) - bias_[i];
+      }
+    }
+
+    /** Bias of @p axis, in 2^-kFracBits LSB. */
+    inline int32_t bias(int axis) const { return bias_[axis]; }
+
+    /** Has a still window been seen yet ? */
+    inline bool valid() const { return valid_; }
+
+    /** Was the last complete window still ? */
+    inline bool still() const { return still_; }
+
+  private:
+    void restart() {
+      for (int i = 0; i < 3; ++i) {
+        sum_[i] = 0;
+        min_[i] = INT16_MAX;
+        max_[i] = INT16_MIN;
+      }
+      count_ = 0;
+    }
+
+    int32_t stillThreshold_;
+    int window_;
+
+    int32_t bias_[3];
+    bool valid_;
+    bool still_;
+
+    // Current window.
+    int32_t sum_[3];
+    int16_t min_[3];
+    int16_t max_[3];
+    int count_;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // GYRO_BIAS_ESTIMATOR_H_
@@ -0,0 +1,53 @@
+#ifndef INPLACE_H_
+#define INPLACE_H_
+
+#include <new>
+#include <utility>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+* Aligned in-object storage for a single object of type T.
+*
+* The object is built in place on demand, which allows members that can only
+* be created once the BLE stack is ready to live inside their owner without
+* any heap allocation.
+*/
+template<typename T>
+class InPlace {
+  public:
+    InPlace() = default;
+    ~InPlace() { reset(); }
+
+    InPlace(const InPlace&) = delete;
+    InPlace& operator=(const InPlace&) = delete;
+
+    /** Construct the object, destroying the previous one if any. */
+    template<typename... Args>
+    T* emplace(Args&&... args) {
+      reset();
+      ptr_ = new (storage_) T(std::forward<Args>(args)...);
+      return ptr_;
+    }
+
+    /** Destroy the object if it was constructed. */
+    void reset() {
+      if (ptr_) {
+        ptr_->~T();
+        ptr_ = nullptr;
+      }
+    }
+
+    inline T* get() const { return ptr_; }
+    inline T* operator->() const { return ptr_; }
+    inline T& operator*() const { return *ptr_; }
+    inline explicit operator bool() const { return ptr_ != nullptr; }
+
+  private:
+    alignas(T) unsigned char storage_[sizeof(T)];
+    T *ptr_ = nullptr;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // INPLACE_H_
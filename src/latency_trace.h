@@ -0,0 +1,155 @@
+#ifndef LATENCY_TRACE_H_
+#define LATENCY_TRACE_H_
+
+/* [build option] Set MBED_BLE_HID_LATENCY_TRACE to 1 to timestamp each input
+ * report along its way to the air. Compiled out otherwise. */
+#ifndef MBED_BLE_HID_LATENCY_TRACE
+#define MBED_BLE_HID_LATENCY_TRACE  0
+#endif
+
+#if MBED_BLE_HID_LATENCY_TRACE
+
+#include <cstdint>
+#include <cstdio>
+
+#include "delay_histogram.h"
+
+/* -------------------------------------------------------------------------- */
+
+/**
+* Timestamps of the input reports at each stage of their sending, in
+* microseconds, kept in a ring of the last completed reports, with the
+* distribution of the delays between consecutive stages.
+*
+* Stages :
+*  - sample : the inputs were read (marked by the application, defaults to send),
+*  - send   : SendReport() was called,
+*  - accept : the stack accepted the notification,
+*  - sent   : the connection event which sent it completed.
+*/
+class LatencyTrace {
+  public:
+    enum Stage {
+      STAGE_SAMPLE,
+      STAGE_SEND,
+      STAGE_ACCEPT,
+      STAGE_SENT,
+      kNumStages
+    };
+
+    struct record_t {
+      uint32_t timestamps[kNumStages];
+    };
+
+    static constexpr int kNumRecords  = 32;
+    static constexpr int kMaxInFlight = 8;
+
+    LatencyTrace() { reset(); }
+
+    void reset() {
+      for (auto &h : delays_) {
+        h.reset();
+      }
+      total_.reset();
+      numRecords_   = 0;
+      nextRecord_   = 0;
+      inFlightHead_ = 0;
+      inFlightTail_ = 0;
+      hasSample_    = false;
+    }
+
+    /** Mark the sampling time of the next report. */
+    inline void sample(uint32_t timestamp) {
+      sampleTime_ = timestamp;
+      hasSample_  = true;
+    }
+
+    /** A report has been accepted by the stack. */
+    void accepted(uint32_t sendTime, uint32_t acceptTime) {
+      const int next = (inFlightHead_ + 1) % kMaxInFlight;
+      if (next == inFlightTail_) {
+        return;
+      }
+      auto &r = inFlight_[inFlightHead_];
+      r.timestamps[STAGE_SAMPLE] = hasSample_ ? sampleTime_ : sendTime;
+      r.timestamps[STAGE_SEND]   = sendTime;
+      r.timestamps[STAGE_ACCEPT] = acceptTime;
+      r.timestamps[STAGE_SENT]   = 0;
+      inFlightHead_ = next;
+      hasSample_    = false;
+    }
+
+    /** The oldest report accepted has been sent. */
+    void sent(uint32_t sentTime) {
+      if (inFlightTail_ == inFlightHead_) {
+        return;
+      }
+      auto &r = inFlight_[inFlightTail_];
+      inFlightTail_ = (inFlightTail_ + 1) % kMaxInFlight;
+      r.timestamps[STAGE_SENT] = sentTime;
+
+      for (int i = STAGE_SEND; i < kNumStages; ++i) {
+        delays_[i].add(r.timestamps[i] - r.timestamps[i-1]);
+      }
+      total_.add(sentTime - r.timestamps[STAGE_SAMPLE]);
+
+      records_[nextRecord_] = r;
+      nextRecord_ = (nextRecord_ + 1) % kNumRecords;
+      numRecords_ += (numRecords_ < kNumRecords) ? 1 : 0;
+    }
+
+    /** Delays between the previous stage and @p stage. */
+    inline const DelayHistogram& delays(Stage stage) const { return delays_[stage]; }
+
+    /** Delays between the sampling and the sending of the reports. */
+    inline const DelayHistogram& total() const { return total_; }
+
+    /** Last completed reports, @p index 0 being the oldest. */
+    inline int numRecords() const { return numRecords_; }
+    inline const record_t& record(int index) const {
+      return records_[(nextRecord_ + kNumRecords - numRecords_ + index) % kNumRecords];
+    }
+
+    /** Write a summary table of the delays into @p buffer (eg. for Serial), return its length. */
+    int format(char *buffer, size_t size) const {
+      static const char* kNames[kNumStages] = { "", "sample>send", "send>accept", "accept>sent" };
+
+      int length = snprintf(buffer, size, "%-12s %6s %6s %6s %6s %6s (us)\n",
+                            "stage", "count", "min", "p50", "p99", "max");
+      for (int i = STAGE_SEND; i <= kNumStages; ++i) {
+        const DelayHistogram &h = (i < kNumStages) ? delays_[i] : total_;
+        const int written = (length < (int)size) ? length : (int)size;
+        length += snprintf(buffer + written, size - written,
+          "%-12s %6lu %6lu %6lu %6lu %6lu\n",
+          (i < kNumStages) ? kNames[i] : "total",
+          (unsigned long)h.count(),
+          (unsigned long)h.minimum(),
+          (unsigned long)h.percentile(50),
+          (unsigned long)h.percentile(99),
+          (unsigned long)h.maximum()
+        );
+      }
+      return length;
+    }
+
+  private:
+    DelayHistogram delays_[kNumStages];   // (the sample stage is unused)
+    DelayHistogram total_;
+
+    record_t records_[kNumRecords];
+    int numRecords_;
+    int nextRecord_;
+
+    record_t inFlight_[kMaxInFlight];
+    int inFlightHead_;
+    int inFlightTail_;
+
+    uint32_t sampleTime_;
+    bool hasSample_;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // MBED_BLE_HID_LATENCY_TRACE
+
+#endif // LATENCY_TRACE_H_
@@ -0,0 +1,146 @@
+#ifndef MAHONY_FILTER_H_
+#define MAHONY_FILTER_H_
+
+#include <cmath>
+#include <cstdint>
+
+#include "fixed_point.h"
+
+/* -------------------------------------------------------------------------- */
+
+/**
+* Mahony complementary filter : the orientation of an IMU, as a unit
+* quaternion integrating the gyroscope, pulled towards the gravity measured by
+* the accelerometer by a proportional-integral feedback.
+*
+* The quaternion rotates the sensor frame to the earth frame (z up). It is
+* updated at a fixed sample rate, in Q30 with integer arithmetic only : the
+* gyro samples are converted to angle increments, the gains are folded with
+* the sample period, and the quaternion is renormalized with a Newton step.
+* Floats are only used to set the constants, and to initialize the orientation
+* from a first accelerometer sample.
+*
+* Without a magnetometer the heading is free : only the tilt is corrected.
+*
+* @see Mahony, Hamel, Pflimlin, "Nonlinear Complementary Filters on the
+* Special Orthogonal Group", IEEE Transactions on Automatic Control, 2008.
+*/
+class MahonyFilter {
+  public:
+    static constexpr float kDefaultKp = 1.0f;   // In 1/s.
+    static constexpr float kDefaultKi = 0.0f;   // In 1/s^2.
+
+    /**
+     * @p sampleRate : update rate, in Hz.
+     * @p gyroScale  : angular rate of a gyro unit, in rad/s.
+     */
+    MahonyFilter(float sampleRate, float gyroScale, float kp = kDefaultKp, float ki = kDefaultKi)
+      : increment_(static_cast<int64_t>(gyroScale / sampleRate * static_cast<float>(int64_t(1) << kIncrementFracBits) + 0.5f))
+    {
+      setGains(sampleRate, kp, ki);
+      reset();
+    }
+
+    void setGains(float sampleRate, float kp, float ki) {
+      kp_ = Q30(kp / sampleRate);
+      ki_ = Q30(ki / (sampleRate * sampleRate));
+    }
+
+    /** Start over from the identity orientation. */
+    void reset() {
+      q_[0] = Q30(1.0f);
+      q_[1] = q_[2] = q_[3] = Q30();
+      integral_[0] = integral_[1] = integral_[2] = Q30();
+    }
+
+    /** Start over from the tilt measured by @p accel, with a null heading. */
+    void reset(const int16_t accel[3]) {
+      reset();
+      const float roll  = atan2f(accel[1], accel[2]);
+      const float pitch = atan2f(-accel[0], sqrtf(float(accel[1]) * accel[1] + float(accel[2]) * accel[2]));
+      const float cr = cosf(0.5f * roll),  sr = sinf(0.5f * roll);
+      const float cp = cosf(0.5f * pitch), sp = sinf(0.5f * pitch);
+      q_[0] = Q30( cr * cp);
+      q_[1] = Q30( sr * cp);
+      q_[2] = Q30( cr * sp);
+      q_[3] = Q30(-sr * sp);
+    }
+
+    /**
+     * Integrate a @p gyro sample (in gyro units), corrected towards the
+     * gravity when @p accel (in any unit) is given.
+     */
+    void update(const int32_t gyro[3], const int16_t *accel) {
+      // Half angle increments of the sample, in Q30.
+      Q30 h[3];
+      for (int i = 0; i < 3; ++i) {
+        h[i] = Q30::Saturate((gyro[i] * increment_) >> (kIncrementFracBits - Q30::kFractionalBits + 1));
+      }
+
+      const int64_t norm2 = accel ? int64_t(accel[0]) * accel[0]
+                                  + int64_t(accel[1]) * accel[1]
+                                  + int64_t(accel[2]) * accel[2]
+                                  : 0;
+      if (norm2 > 0) {
+        // Measured and estimated directions of the gravity.
+        const int64_t norm = ISqrt(static_cast<uint64_t>(norm2));
+        Q30 a[3];
+        for (int i = 0; i < 3; ++i) {
+          a[i] = Q30::Saturate((int64_t(accel[i]) << Q30::kFractionalBits) / norm);
+        }
+        Q30 v[3];
+        up(v);
+
+        // Error, as the rotation between them.
+        const Q30 e[3] = {
+          a[1] * v[2] - a[2] * v[1],
+          a[2] * v[0] - a[0] * v[2],
+          a[0] * v[1] - a[1] * v[0],
+        };
+        for (int i = 0; i < 3; ++i) {
+          integral_[i] += ki_ * e[i];
+          h[i] += Q30::FromRaw((kp_ * e[i] + integral_[i]).raw() / 2);
+        }
+      }
+
+      // q += q * (0, h)
+      const Q30 q0 = q_[0], q1 = q_[1], q2 = q_[2], q3 = q_[3];
+      q_[0] = q0 - q1 * h[0] - q2 * h[1] - q3 * h[2];
+      q_[1] = q1 + q0 * h[0] + q2 * h[2] - q3 * h[1];
+      q_[2] = q2 + q0 * h[1] - q1 * h[2] + q3 * h[0];
+      q_[3] = q3 + q0 * h[2] + q1 * h[1] - q2 * h[0];
+
+      // Renormalize, with a Newton step of 1 / sqrt(n) around 1.
+      const Q30 n = q_[0] * q_[0] + q_[1] * q_[1] + q_[2] * q_[2] + q_[3] * q_[3];
+      const Q30 scale = Q30(1.5f) - Q30::FromRaw(n.raw() / 2);
+      for (int i = 0; i < 4; ++i) {
+        q_[i] *= scale;
+      }
+    }
+
+    /** Direction of the earth up (the gravity reaction) in the sensor frame, unit vector. */
+    void up(Q30 v[3]) const {
+      const Q30 x = q_[1] * q_[3] - q_[0] * q_[2];
+      const Q30 y = q_[0] * q_[1] + q_[2] * q_[3];
+      v[0] = x + x;
+      v[1] = y + y;
+      v[2] = q_[0] * q_[0] - q_[1] * q_[1] - q_[2] * q_[2] + q_[3] * q_[3];
+    }
+
+    /** Orientation, as the quaternion (w, x, y, z). */
+    inline const Q30* quaternion() const { return q_; }
+
+  private:
+    static constexpr int kIncrementFracBits = 46;   // Angle increment of a gyro unit, in 2^-46 rad.
+
+    int64_t increment_;
+    Q30 kp_;
+    Q30 ki_;
+
+    Q30 q_[4];
+    Q30 integral_[3];
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // MAHONY_FILTER_H_
@@ -0,0 +1,88 @@
+#ifndef ONE_EURO_FILTER_H_
+#define ONE_EURO_FILTER_H_
+
+/* -------------------------------------------------------------------------- */
+
+/**
+* One Euro filter : a low-pass filter whose cutoff frequency rises with the
+* speed of the signal, removing jitter at rest while keeping the lag low
+* during fast motions.
+*
+* minCutoff (in Hz) sets the smoothing at rest, beta how fast the cutoff
+* rises with the speed (in units per second), and derivativeCutoff the
+* smoothing of the speed estimate.
+*
+* @see Casiez, Roussel, Vogel, "1 Euro Filter: A Simple Speed-based Low-pass
+* Filter for Noisy Input in Interactive Systems", CHI 2012.
+*/
+class OneEuroFilter {
+  public:
+    static constexpr float kDefaultMinCutoff        = 1.0f;
+    static constexpr float kDefaultBeta             = 0.0f;
+    static constexpr float kDefaultDerivativeCutoff = 1.0f;
+
+    OneEuroFilter(float minCutoff = kDefaultMinCutoff,
+                  float beta = kDefaultBeta,
+                  float derivativeCutoff = kDefaultDerivativeCutoff)
+      : minCutoff_(minCutoff)
+      , beta_(beta)
+      , derivativeCutoff_(derivativeCutoff)
+    {
+      reset();
+    }
+
+    void setParameters(float minCutoff, float beta, float derivativeCutoff = kDefaultDerivativeCutoff) {
+      minCutoff_        = minCutoff;
+      beta_             = beta;
+      derivativeCutoff_ = derivativeCutoff;
+    }
+
+    /** Forget the signal, the next sample being passed through. */
+    void reset() {
+      x_           = 0.0f;
+      dx_          = 0.0f;
+      initialized_ = false;
+    }
+
+    /** Filter the sample @p x, taken @p dt seconds after the previous one. */
+    float filter(float x, float dt) {
+      if (!initialized_) {
+        x_           = x;
+        dx_          = 0.0f;
+        initialized_ = true;
+        return x_;
+      }
+      if (dt <= 0.0f) {
+        return x_;
+      }
+
+      // Smoothed speed, setting the cutoff of the signal.
+      dx_ += Alpha(derivativeCutoff_, dt) * ((x - x_) / dt - dx_);
+      const float speed  = (dx_ < 0.0f) ? -dx_ : dx_;
+      const float cutoff = minCutoff_ + beta_ * speed;
+
+      x_ += Alpha(cutoff, dt) * (x - x_);
+      return x_;
+    }
+
+    inline float value() const { return x_; }
+
+  private:
+    /* Smoothing factor of an exponential filter with a @p cutoff frequency. */
+    static inline float Alpha(float cutoff, float dt) {
+      const float tau = 1.0f / (2.0f * 3.14159265f * cutoff);
+      return 1.0f / (1.0f + tau / dt);
+    }
+
+    float minCutoff_;
+    float beta_;
+    float derivativeCutoff_;
+
+    float x_;
+    float dx_;
+    bool initialized_;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // ONE_EURO_FILTER_H_
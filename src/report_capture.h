@@ -0,0 +1,369 @@
+#ifndef REPORT_CAPTURE_H_
+#define REPORT_CAPTURE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/* -------------------------------------------------------------------------- */
+//
+// Capture of the input reports sent to the host, to replay them later.
+//
+// Format, little-endian :
+//
+//  header  : "HIDC", version (u8), number of report maps (u8), reserved (u16),
+//            base timestamp in microseconds (u32), dropped records (u32),
+//            size of the records (u32).
+//  maps    : for each report map, the ID of its input report (u8, 0 when
+//            unnumbered), its length (u16) then its bytes.
+//  records : timestamp delta from the previous record, or from the base
+//            timestamp for the first one (LEB128 varint, in microseconds),
+//            report map index (u8), report length (u8), then the report.
+//
+// eg. the 3 bytes report of HIDMouseService, sent every 7.5ms connection
+// event, takes 7 bytes : a 2 bytes delta, the map index, the length and the
+// report.
+//
+/* -------------------------------------------------------------------------- */
+
+namespace report_capture {
+
+static constexpr uint8_t kMagic[4]       = { 'H', 'I', 'D', 'C' };
+static constexpr uint8_t kVersion        = 1;
+static constexpr size_t  kHeaderSize     = 20;
+static constexpr size_t  kMaxVarintSize  = 5;
+static constexpr size_t  kMaxRecordSize  = kMaxVarintSize + 2 + UINT8_MAX;
+
+inline void WriteU16(uint8_t *dst, uint16_t v) {
+  dst[0] = v & 0xff;
+  dst[1] = v >> 8;
+}
+
+inline void WriteU32(uint8_t *dst, uint32_t v) {
+  for (int i = 0; i < 4; ++i) {
+    dst[i] = (v >> (8 * i)) & 0xff;
+  }
+}
+
+inline uint16_t ReadU16(const uint8_t *src) {
+  return src[0] | (src[1] << 8);
+}
+
+inline uint32_t ReadU32(const uint8_t *src) {
+  return src[0] | (src[1] << 8) | (src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+} // namespace report_capture
+
+/* -------------------------------------------------------------------------- */
+
+/**
+* Record the input reports into a RAM ring buffer, the oldest records being
+* dropped when it is full, so the last moments before a glitch are kept.
+*
+* Recording a report costs a few byte copies. The recorder is not thread-safe :
+* record() is called by the services from the BLE events thread, so dump() must
+* be called from it too (eg. in the update task).
+*/
+class ReportRecorder {
+  public:
+    static constexpr int kMaxReportMaps = 4;
+
+    ReportRecorder(uint8_t *buffer, size_t size)
+      : buffer_(buffer)
+      , capacity_(size)
+      , numReportMaps_(0)
+    {
+      reset();
+    }
+
+    /** Remove all the records, keeping the report maps. */
+    void reset() {
+      head_     = 0;
+      tail_     = 0;
+      used_     = 0;
+      baseTime_ = 0;
+      lastTime_ = 0;
+      dropped_  = 0;
+    }
+
+    /**
+     * Register the report map of a service, whose input reports use @p reportID,
+     * return its index for record() or -1 when full.
+     */
+    int addReportMap(const uint8_t *reportMap, uint16_t length, uint8_t reportID = 0) {
+      for (int i = 0; i < numReportMaps_; ++i) {
+        if (reportMaps_[i].data == reportMap) {
+          return i;
+        }
+      }
+      if (numReportMaps_ >= kMaxReportMaps) {
+        return -1;
+      }
+      reportMaps_[numReportMaps_] = { reportMap, length, reportID };
+      return numReportMaps_++;
+    }
+
+    /** Record a report sent at @p timestamp, in microseconds. */
+    void record(int reportMap, const uint8_t *report, uint8_t length, uint32_t timestamp) {
+      if (used_ == 0) {
+        baseTime_ = timestamp;
+        lastTime_ = timestamp;
+      }
+
+      uint8_t prefix[report_capture::kMaxVarintSize + 2];
+      size_t prefixSize = 0;
+      for (uint32_t delta = timestamp - lastTime_; ; delta >>= 7) {
+        prefix[prefixSize++] = (delta & 0x7f) | ((delta > 0x7f) ? 0x80 : 0);
+        if (delta <= 0x7f) {
+          break;
+        }
+      }
+      prefix[prefixSize++] = static_cast<uint8_t>(reportMap);
+      prefix[prefixSize++] = length;
+
+      const size_t recordSize = prefixSize + length;
+      if (recordSize > capacity_) {
+        ++dropped_;
+        return;
+      }
+      while (capacity_ - used_ < recordSize) {
+        dropOldest();
+      }
+      write(prefix, prefixSize);
+      write(report, length);
+      lastTime_ = timestamp;
+    }
+
+    /** Size of the capture written by dump(). */
+    size_t captureSize() const {
+      size_t size = report_capture::kHeaderSize + used_;
+      for (int i = 0; i < numReportMaps_; ++i) {
+        size += 3 + reportMaps_[i].length;
+      }
+      return size;
+    }
+
+    /**
+     * Write the capture through @p sink, called as sink(const uint8_t *data, size_t size)
+     * several times, eg. to send it on a serial port.
+     */
+    template<typename Sink>
+    void dump(Sink sink) const {
+      using namespace report_capture;
+
+      uint8_t header[kHeaderSize];
+      memcpy(header, kMagic, sizeof(kMagic));
+      header[4] = kVersion;
+      header[5] = static_cast<uint8_t>(numReportMaps_);
+      WriteU16(header + 6, 0);
+      WriteU32(header + 8, baseTime_);
+      WriteU32(header + 12, dropped_);
+      WriteU32(header + 16, static_cast<uint32_t>(used_));
+      sink(header, sizeof(header));
+
+      for (int i = 0; i < numReportMaps_; ++i) {
+        uint8_t prefix[3];
+        prefix[0] = reportMaps_[i].reportID;
+        WriteU16(prefix + 1, reportMaps_[i].length);
+        sink(prefix, sizeof(prefix));
+        sink(reportMaps_[i].data, reportMaps_[i].length);
+      }
+
+      // Records, in up to two parts around the end of the ring.
+      const size_t first = (tail_ + used_ <= capacity_) ? used_ : capacity_ - tail_;
+      if (first > 0) {
+        sink(buffer_ + tail_, first);
+      }
+      if (used_ > first) {
+        sink(buffer_, used_ - first);
+      }
+    }
+
+    /** Number of records dropped, to make room or being too large. */
+    inline uint32_t dropped() const { return dropped_; }
+
+    /** Bytes used by the records. */
+    inline size_t size() const { return used_; }
+
+  private:
+    inline uint8_t at(size_t offset) const {
+      return buffer_[(tail_ + offset) % capacity_];
+    }
+
+    void write(const uint8_t *data, size_t size) {
+      if (size == 0) {
+        return;
+      }
+      const size_t first = (head_ + size <= capacity_) ? size : capacity_ - head_;
+      memcpy(buffer_ + head_, data, first);
+      memcpy(buffer_, data + first, size - first);
+      head_ = (head_ + size) % capacity_;
+      used_ += size;
+    }
+
+    /* Drop the oldest record, moving the base timestamp to the next one. */
+    void dropOldest() {
+      uint32_t delta = 0;
+      size_t offset = 0;
+      uint8_t byte;
+      do {
+        byte   = at(offset);
+        delta |= (uint32_t)(byte & 0x7f) << (7 * offset);
+        ++offset;
+      } while (byte & 0x80);
+
+      const size_t recordSize = offset + 2 + at(offset + 1);
+      tail_      = (tail_ + recordSize) % capacity_;
+      used_     -= recordSize;
+      baseTime_ += delta;
+      ++dropped_;
+    }
+
+    struct report_map_t {
+      const uint8_t *data;
+      uint16_t length;
+      uint8_t reportID;
+    };
+
+    uint8_t *buffer_;
+    size_t capacity_;
+    size_t head_;
+    size_t tail_;
+    size_t used_;
+
+    report_map_t reportMaps_[kMaxReportMaps];
+    int numReportMaps_;
+
+    uint32_t baseTime_;   // Timestamp the oldest record delta is relative to.
+    uint32_t lastTime_;
+    uint32_t dropped_;
+};
+
+/* -------------------------------------------------------------------------- */
+
+/**
+* Read a capture written by ReportRecorder::dump(), held in memory.
+*/
+class ReportCaptureReader {
+  public:
+    struct record_t {
+      uint32_t timestamp;     // in microseconds.
+      uint8_t reportMap;
+      uint8_t length;
+      const uint8_t *data;
+    };
+
+    ReportCaptureReader(const uint8_t *data, size_t size)
+      : data_(data)
+      , numReportMaps_(0)
+      , records_(0)
+      , recordsEnd_(0)
+      , valid_(false)
+    {
+      using namespace report_capture;
+
+      if ((size < kHeaderSize) || memcmp(data, kMagic, sizeof(kMagic)) || (data[4] != kVersion)) {
+        return;
+      }
+      numReportMaps_ = data[5];
+      baseTime_      = ReadU32(data + 8);
+      dropped_       = ReadU32(data + 12);
+
+      size_t offset = kHeaderSize;
+      for (int i = 0; i < numReportMaps_; ++i) {
+        if ((offset + 3 > size) || (i >= ReportRecorder::kMaxReportMaps)) {
+          return;
+        }
+        const uint16_t length = ReadU16(data + offset + 1);
+        if (offset + 3 + length > size) {
+          return;
+        }
+        reportMaps_[i] = { data + offset + 3, length, data[offset] };
+        offset += 3 + length;
+      }
+
+      const uint32_t recordsSize = ReadU32(data + 16);
+      if (offset + recordsSize > size) {
+        return;
+      }
+      records_    = offset;
+      recordsEnd_ = offset + recordsSize;
+      valid_      = true;
+      rewind();
+    }
+
+    /** Is the capture well-formed, up to its records ? */
+    inline bool valid() const { return valid_; }
+
+    inline int numReportMaps() const { return numReportMaps_; }
+    inline const uint8_t* reportMap(int index) const { return reportMaps_[index].data; }
+    inline uint16_t reportMapLength(int index) const { return reportMaps_[index].length; }
+    inline uint8_t reportID(int index) const { return reportMaps_[index].reportID; }
+
+    inline uint32_t baseTimestamp() const { return baseTime_; }
+    inline uint32_t dropped() const { return dropped_; }
+
+    /** Restart reading from the first record. */
+    void rewind() {
+      offset_ = records_;
+      time_   = baseTime_;
+    }
+
+    /** Read the next record, return false at the end or on a truncated record. */
+    bool next(record_t &record) {
+      if (!valid_) {
+        return false;
+      }
+      uint32_t delta = 0;
+      int shift = 0;
+      uint8_t byte;
+      do {
+        if ((offset_ >= recordsEnd_) || (shift > 28)) {
+          return false;
+        }
+        byte   = data_[offset_++];
+        delta |= (uint32_t)(byte & 0x7f) << shift;
+        shift += 7;
+      } while (byte & 0x80);
+
+      if (offset_ + 2 > recordsEnd_) {
+        return false;
+      }
+      record.reportMap = data_[offset_];
+      record.length    = data_[offset_ + 1];
+      record.data      = data_ + offset_ + 2;
+      if (offset_ + 2 + record.length > recordsEnd_) {
+        return false;
+      }
+      offset_ += 2 + record.length;
+
+      time_ += delta;
+      record.timestamp = time_;
+      return true;
+    }
+
+  private:
+    struct report_map_t {
+      const uint8_t *data;
+      uint16_t length;
+      uint8_t reportID;
+    };
+
+    const uint8_t *data_;
+
+    report_map_t reportMaps_[ReportRecorder::kMaxReportMaps];
+    int numReportMaps_;
+    uint32_t baseTime_ = 0;
+    uint32_t dropped_  = 0;
+
+    size_t records_;
+    size_t recordsEnd_;
+    size_t offset_ = 0;
+    uint32_t time_ = 0;
+    bool valid_;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // REPORT_CAPTURE_H_
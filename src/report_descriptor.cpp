@@ -0,0 +1,318 @@
+#include "report_descriptor.h"
+
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+// Item types.
+enum {
+  ITEM_MAIN   = 0,
+  ITEM_GLOBAL = 1,
+  ITEM_LOCAL  = 2,
+  ITEM_LONG   = 0xFE,   // (prefix of the long items)
+};
+
+// Main item tags.
+enum {
+  MAIN_INPUT          = 0x8,
+  MAIN_OUTPUT         = 0x9,
+  MAIN_COLLECTION     = 0xA,
+  MAIN_FEATURE        = 0xB,
+  MAIN_END_COLLECTION = 0xC,
+};
+
+// Global item tags.
+enum {
+  GLOBAL_USAGE_PAGE       = 0x0,
+  GLOBAL_LOGICAL_MINIMUM  = 0x1,
+  GLOBAL_LOGICAL_MAXIMUM  = 0x2,
+  GLOBAL_REPORT_SIZE      = 0x7,
+  GLOBAL_REPORT_ID        = 0x8,
+  GLOBAL_REPORT_COUNT     = 0x9,
+  GLOBAL_PUSH             = 0xA,
+  GLOBAL_POP              = 0xB,
+};
+
+// Local item tags.
+enum {
+  LOCAL_USAGE         = 0x0,
+  LOCAL_USAGE_MINIMUM = 0x1,
+};
+
+// Main item data flags.
+enum {
+  FLAG_CONSTANT = 1 << 0,
+};
+
+struct global_state_t {
+  uint16_t usagePage;
+  int32_t  logicalMinimum;
+  uint32_t logicalMaximum;  // (raw, its sign depends on the minimum)
+  uint8_t  logicalMaximumSize;
+  bool     hasLogicalMinimum;
+  bool     hasLogicalMaximum;
+  uint8_t  reportSize;
+  uint16_t reportCount;
+  uint8_t  reportID;
+};
+
+inline uint32_t ReadData(const uint8_t *data, int size)
+{
+  uint32_t value = 0;
+  for (int i = 0; i < size; ++i) {
+    value |= (uint32_t)data[i] << (8 * i);
+  }
+  return value;
+}
+
+inline int32_t SignExtend(uint32_t value, int size)
+{
+  switch (size) {
+    case 1:  return (int8_t)value;
+    case 2:  return (int16_t)value;
+    default: return (int32_t)value;
+  }
+}
+
+/* Logical Maximum is signed only when Logical Minimum is negative (as hosts parse it). */
+inline int32_t LogicalMaximum(const global_state_t &g)
+{
+  return (g.logicalMinimum < 0) ? SignExtend(g.logicalMaximum, g.logicalMaximumSize)
+                                : (int32_t)g.logicalMaximum;
+}
+
+} // namespace ""
+
+/* -------------------------------------------------------------------------- */
+
+void ReportDescriptor::reset()
+{
+  numReports_  = 0;
+  numFields_   = 0;
+  error_       = NO_ERROR;
+  errorOffset_ = 0;
+}
+
+ReportDescriptor::report_t* ReportDescriptor::findOrAddReport(ReportType type, uint8_t id)
+{
+  for (int i = 0; i < numReports_; ++i) {
+    if ((reports_[i].type == type) && (reports_[i].id == id)) {
+      return &reports_[i];
+    }
+  }
+  if (numReports_ >= kMaxReports) {
+    return nullptr;
+  }
+  reports_[numReports_] = { type, id, 0 };
+  return &reports_[numReports_++];
+}
+
+const ReportDescriptor::report_t* ReportDescriptor::find(ReportType type, uint8_t id) const
+{
+  for (int i = 0; i < numReports_; ++i) {
+    if ((reports_[i].type == type) && (reports_[i].id == id)) {
+      return &reports_[i];
+    }
+  }
+  return nullptr;
+}
+
+ReportDescriptor::Error ReportDescriptor::parse(const uint8_t *reportMap, size_t length,
+                                                field_t *fields, int maxFields)
+{
+  reset();
+
+  global_state_t global{};
+  global_state_t globalStack[kMaxGlobalStack];
+  int globalStackSize = 0;
+
+  // Local state, cleared after each main item.
+  uint16_t usage   = 0;
+  bool hasUsage    = false;
+
+  int collectionDepth = 0;
+  bool hasReportIDs   = false;
+  bool hasNoReportID  = false;
+
+  size_t offset = 0;
+  auto fail = [&](Error error, size_t at) {
+    error_       = error;
+    errorOffset_ = at;
+    return error;
+  };
+
+  while (offset < length) {
+    const size_t itemOffset = offset;
+    const uint8_t prefix = reportMap[offset++];
+
+    // Long items (none is defined) are skipped.
+    if (prefix == ITEM_LONG) {
+      if ((offset + 2 > length) || (offset + 2 + reportMap[offset] > length)) {
+        return fail(ERROR_TRUNCATED, itemOffset);
+      }
+      offset += 2 + reportMap[offset];
+      continue;
+    }
+
+    const int size = ((prefix & 0x3) == 3) ? 4 : (prefix & 0x3);
+    const int type = (prefix >> 2) & 0x3;
+    const int tag  = prefix >> 4;
+    if (offset + size > length) {
+      return fail(ERROR_TRUNCATED, itemOffset);
+    }
+    const uint32_t data = ReadData(reportMap + offset, size);
+    offset += size;
+
+    if (type == ITEM_MAIN) {
+      switch (tag) {
+        case MAIN_INPUT:
+        case MAIN_OUTPUT:
+        case MAIN_FEATURE: {
+          const ReportType reportType = (tag == MAIN_INPUT) ? INPUT
+                                      : (tag == MAIN_OUTPUT) ? OUTPUT
+                                      : FEATURE;
+          if ((global.reportSize == 0) || (global.reportCount == 0)) {
+            return fail(ERROR_REPORT_SIZE, itemOffset);
+          }
+          const bool bConstant = data & FLAG_CONSTANT;
+          const int32_t logicalMaximum = LogicalMaximum(global);
+          if (!bConstant && (!global.hasLogicalMinimum || !global.hasLogicalMaximum
+                          || (global.logicalMinimum > logicalMaximum))) {
+            return fail(ERROR_LOGICAL_RANGE, itemOffset);
+          }
+
+          hasReportIDs  = hasReportIDs  || (global.reportID != 0);
+          hasNoReportID = hasNoReportID || (global.reportID == 0);
+          if (hasReportIDs && hasNoReportID) {
+            return fail(ERROR_REPORT_ID, itemOffset);
+          }
+
+          report_t *report = findOrAddReport(reportType, global.reportID);
+          if (!report) {
+            return fail(ERROR_TOO_MANY_REPORTS, itemOffset);
+          }
+          const uint32_t bitLength = report->bitLength + uint32_t(global.reportSize) * global.reportCount;
+          if (bitLength > UINT16_MAX) {
+            return fail(ERROR_REPORT_OVERFLOW, itemOffset);
+          }
+
+          if (numFields_ < maxFields) {
+            fields[numFields_] = {
+              static_cast<uint8_t>(report - reports_),
+              static_cast<uint8_t>(data),
+              report->bitLength,
+              global.reportSize,
+              global.reportCount,
+              global.usagePage,
+              usage,
+              global.logicalMinimum,
+              logicalMaximum
+            };
+          }
+          ++numFields_;
+          report->bitLength = static_cast<uint16_t>(bitLength);
+        }
+        break;
+
+        case MAIN_COLLECTION:
+          ++collectionDepth;
+        break;
+
+        case MAIN_END_COLLECTION:
+          if (--collectionDepth < 0) {
+            return fail(ERROR_COLLECTION, itemOffset);
+          }
+        break;
+
+        default:
+          return fail(ERROR_UNKNOWN_ITEM, itemOffset);
+      }
+      usage    = 0;
+      hasUsage = false;
+    } else if (type == ITEM_GLOBAL) {
+      switch (tag) {
+        case GLOBAL_USAGE_PAGE:
+          global.usagePage = static_cast<uint16_t>(data);
+        break;
+
+        case GLOBAL_LOGICAL_MINIMUM:
+          global.logicalMinimum    = SignExtend(data, size);
+          global.hasLogicalMinimum = true;
+        break;
+
+        case GLOBAL_LOGICAL_MAXIMUM:
+          global.logicalMaximum     = data;
+          global.logicalMaximumSize = size;
+          global.hasLogicalMaximum  = true;
+        break;
+
+        case GLOBAL_REPORT_SIZE:
+          global.reportSize = static_cast<uint8_t>(data);
+        break;
+
+        case GLOBAL_REPORT_ID:
+          if ((data == 0) || (data > 0xFF)) {
+            return fail(ERROR_REPORT_ID, itemOffset);
+          }
+          global.reportID = static_cast<uint8_t>(data);
+        break;
+
+        case GLOBAL_REPORT_COUNT:
+          global.reportCount = static_cast<uint16_t>(data);
+        break;
+
+        case GLOBAL_PUSH:
+          if (globalStackSize >= kMaxGlobalStack) {
+            return fail(ERROR_GLOBAL_STACK, itemOffset);
+          }
+          globalStack[globalStackSize++] = global;
+        break;
+
+        case GLOBAL_POP:
+          if (globalStackSize <= 0) {
+            return fail(ERROR_GLOBAL_STACK, itemOffset);
+          }
+          global = globalStack[--globalStackSize];
+        break;
+
+        default:
+          // (physical range, units : layout independent)
+        break;
+      }
+    } else if (type == ITEM_LOCAL) {
+      // Only the first usage of a main item is kept.
+      if (!hasUsage && ((tag == LOCAL_USAGE) || (tag == LOCAL_USAGE_MINIMUM))) {
+        usage    = static_cast<uint16_t>(data);
+        hasUsage = true;
+      }
+    } else {
+      // (reserved item type)
+      return fail(ERROR_UNKNOWN_ITEM, itemOffset);
+    }
+  }
+
+  if (collectionDepth != 0) {
+    return fail(ERROR_COLLECTION, length);
+  }
+  return NO_ERROR;
+}
+
+const char* ReportDescriptor::ErrorString(Error error)
+{
+  switch (error) {
+    case NO_ERROR:                return "no error";
+    case ERROR_TRUNCATED:         return "truncated item";
+    case ERROR_UNKNOWN_ITEM:      return "unknown item";
+    case ERROR_COLLECTION:        return "unbalanced collections";
+    case ERROR_GLOBAL_STACK:      return "push / pop mismatch";
+    case ERROR_REPORT_SIZE:       return "missing report size or count";
+    case ERROR_LOGICAL_RANGE:     return "missing or invalid logical range";
+    case ERROR_REPORT_ID:         return "invalid report ID";
+    case ERROR_TOO_MANY_REPORTS:  return "too many reports";
+    case ERROR_REPORT_OVERFLOW:   return "report too long";
+    case ERROR_REPORT_LENGTH:     return "report length mismatch";
+  }
+  return "unknown error";
+}
+
+/* -------------------------------------------------------------------------- */
@@ -0,0 +1,116 @@
+#ifndef REPORT_DESCRIPTOR_H_
+#define REPORT_DESCRIPTOR_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+* Parser for HID report descriptors (report maps), computing the size of each
+* report and, optionally, the layout of their fields.
+*
+* Parsing is done in a single pass without allocation : reports are kept in a
+* fixed table and fields are written to a buffer provided by the caller, so it
+* can run at boot on the MCU, eg. to check a report map against the report
+* buffers of its service.
+*
+* Besides malformed items, the parser reports the mistakes the hosts handle
+* inconsistently : data fields without logical range, reports mixing Report
+* IDs and no Report ID, unbalanced collections, and reports whose length does
+* not fit their 16-bit bit count.
+*/
+class ReportDescriptor {
+  public:
+    static constexpr int kMaxReports      = 8;
+    static constexpr int kMaxGlobalStack  = 4;
+
+    enum ReportType : uint8_t {
+      INPUT,
+      OUTPUT,
+      FEATURE,
+      kNumReportTypes
+    };
+
+    enum Error : uint8_t {
+      NO_ERROR = 0,
+      ERROR_TRUNCATED,              // An item goes past the end of the map.
+      ERROR_UNKNOWN_ITEM,           // Reserved item type or main item tag.
+      ERROR_COLLECTION,             // Unbalanced collections.
+      ERROR_GLOBAL_STACK,           // Push / Pop overflow or underflow.
+      ERROR_REPORT_SIZE,            // Main item without Report Size or Report Count.
+      ERROR_LOGICAL_RANGE,          // Data field without logical range, or min > max.
+      ERROR_REPORT_ID,              // Report ID 0, or reports with and without ID.
+      ERROR_TOO_MANY_REPORTS,
+      ERROR_REPORT_OVERFLOW,        // A report is longer than 65535 bits.
+      ERROR_REPORT_LENGTH,          // A report does not have the expected size (see check()).
+    };
+
+    /** A main item, ie. Report Count fields of Report Size bits. */
+    struct field_t {
+      uint8_t  report;        // Index of the report.
+      uint8_t  flags;         // Main item data (bit 0 : constant, 1 : variable, 2 : relative).
+      uint16_t bitOffset;     // From the start of the report, Report ID excluded.
+      uint8_t  bitSize;
+      uint16_t count;
+      uint16_t usagePage;
+      uint16_t usage;         // First usage, or Usage Minimum.
+      int32_t  logicalMinimum;
+      int32_t  logicalMaximum;
+    };
+
+    struct report_t {
+      ReportType type;
+      uint8_t  id;            // 0 when the map has no Report IDs.
+      uint16_t bitLength;     // Report ID excluded.
+      inline uint16_t size() const { return (bitLength + 7) / 8; }
+    };
+
+    ReportDescriptor() { reset(); }
+
+    /**
+     * Parse @p reportMap. Fields are written to @p fields when given, up to
+     * @p maxFields. Return NO_ERROR or the first error met, whose position is
+     * given by errorOffset().
+     */
+    Error parse(const uint8_t *reportMap, size_t length, field_t *fields = nullptr, int maxFields = 0);
+
+    /** Return the report of @p type with Report ID @p id, or nullptr. */
+    const report_t* find(ReportType type, uint8_t id = 0) const;
+
+    /** Size in bytes of the report of @p type with Report ID @p id, or -1 when it does not exist. */
+    inline int reportSize(ReportType type, uint8_t id = 0) const {
+      const report_t *report = find(type, id);
+      return report ? report->size() : -1;
+    }
+
+    /** Check the report of @p type with Report ID @p id exists and takes @p length bytes. */
+    inline Error check(ReportType type, uint8_t id, size_t length) const {
+      return (reportSize(type, id) == static_cast<int>(length)) ? NO_ERROR : ERROR_REPORT_LENGTH;
+    }
+
+    inline int numReports() const { return numReports_; }
+    inline const report_t& report(int index) const { return reports_[index]; }
+
+    /** Number of fields parsed, including those beyond the caller buffer. */
+    inline int numFields() const { return numFields_; }
+
+    inline Error error() const { return error_; }
+    inline size_t errorOffset() const { return errorOffset_; }
+
+    static const char* ErrorString(Error error);
+
+  private:
+    void reset();
+    report_t* findOrAddReport(ReportType type, uint8_t id);
+
+    report_t reports_[kMaxReports];
+    int numReports_;
+    int numFields_;
+    Error error_;
+    size_t errorOffset_;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // REPORT_DESCRIPTOR_H_
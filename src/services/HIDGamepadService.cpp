@@ -3,29 +3,6 @@
 
 namespace {
 
-// Report Reference
-static report_reference_t input_report_ref = { 0, INPUT_REPORT };
-
-static GattAttribute input_report_ref_desc(
-  ATT_UUID_HID_REPORT_ID_MAPPING,
-  (uint8_t*)&input_report_ref,
-  sizeof(input_report_ref),
-  sizeof(input_report_ref)
-);
-
-static GattAttribute *input_report_ref_descs[] = {
-  &input_report_ref_desc,
-};
-
-// Input Report
-#pragma pack(push, 1)
-struct {
-  uint8_t x;
-  uint8_t y;
-  uint8_t buttons;
-} hid_input_report;
-#pragma pack(pop)
-
 // Report Map
 static uint8_t hid_report_map[] =
 {
@@ -37,6 +14,8 @@ static uint8_t hid_report_map[] =
       USAGE_PAGE(1),      0x01,       // Usage Page (Generic Desktop)
       USAGE(1),           0x30,       // Usage (X)
       USAGE(1),           0x31,       // Usage (Y)
+      LOGICAL_MINIMUM(1), 0x81,       // Logical Minimum (-127)
+      LOGICAL_MAXIMUM(1), 0x7f,       // Logical Maximum (127)
       REPORT_SIZE(1),     0x08,       // Report Size (8)
       REPORT_COUNT(1),    0x02,       // Report Count (2)
       INPUT(1),           0x02,       // Input (Data, Variable, Absolute)
@@ -71,10 +50,9 @@ HIDGamepadService::HIDGamepadService(BLE &_ble)
                sizeof(hid_report_map) / sizeof(*hid_report_map),
 
                // input report
-               (uint8_t*)&hid_input_report,
-               sizeof(hid_input_report),
-               input_report_ref_descs,
-               sizeof(input_report_ref_descs) / sizeof(*input_report_ref_descs))
+               (uint8_t*)&hidInputReport,
+               sizeof(hidInputReport))
+  , hidInputReport{}
 {
 
 }
@@ -83,10 +61,10 @@ void HIDGamepadService::motion(float fx, float fy) {
   uint8_t x = static_cast<int>(0x100 + fx * 0x7f) & 0xff;
   uint8_t y = static_cast<int>(0x100 + fy * 0x7f) & 0xff;
 
-  hid_input_report.x = x;
-  hid_input_report.y = y;
+  hidInputReport.x = x;
+  hidInputReport.y = y;
 }
 
 void HIDGamepadService::button(Button buttons) {
-  hid_input_report.buttons = uint8_t(buttons); 
+  hidInputReport.buttons = uint8_t(buttons); 
 }
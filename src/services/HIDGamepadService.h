@@ -12,12 +12,11 @@
  *
  * @par usage
  *
- * When this class is instantiated, it adds a Game Pad HID service in 
+ * When this class is instantiated, it builds a Game Pad HID service for
  * the GattServer.
  *
  * The GamePad consist of a joystick for X and Y motion and 4 buttons.
  *
- * @attention Multiple instances of this hid service are not supported.
  * @see HIDService
  */
 class HIDGamepadService : public HIDService {
@@ -38,6 +37,16 @@ class HIDGamepadService : public HIDService {
 
   void motion(float fx, float fy);
   void button(Button buttons);
+
+ private:
+  // Input Report.
+#pragma pack(push, 1)
+  struct {
+    uint8_t x;
+    uint8_t y;
+    uint8_t buttons;
+  } hidInputReport;
+#pragma pack(pop)
 };
 
 /* -------------------------------------------------------------------------- */
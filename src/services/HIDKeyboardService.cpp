@@ -222,46 +222,6 @@ KeySym_t::KeySym_t(KeyCode_t _keycode)
 
 namespace {
 
-// Input Report
-struct {
-  uint8_t modifiers;
-  uint8_t reserved;
-  uint8_t key_codes[6];
-} hid_input_report;
-
-// Input Report Reference
-static report_reference_t input_report_ref = { 0, INPUT_REPORT };
-
-static GattAttribute input_report_ref_desc(
-  ATT_UUID_HID_REPORT_ID_MAPPING,
-  (uint8_t*)&input_report_ref,
-  sizeof(input_report_ref),
-  sizeof(input_report_ref)
-);
-
-static GattAttribute *input_report_ref_descs[] = {
-  &input_report_ref_desc,
-};
-
-// Output Report
-struct {
-  uint8_t leds;
-} hid_output_report;
-
-// Output Report Reference
-static report_reference_t output_report_ref = { 0, OUTPUT_REPORT };
-
-static GattAttribute output_report_ref_desc(
-  ATT_UUID_HID_REPORT_ID_MAPPING,
-  (uint8_t*)&output_report_ref,
-  sizeof(output_report_ref),
-  sizeof(output_report_ref)
-);
-
-static GattAttribute *output_report_ref_descs[] = {
-  &output_report_ref_desc,
-};
-
 // Report Map
 // (Example keyboard descriptor from USB HID reference)
 static uint8_t hid_report_map[] =
@@ -318,16 +278,14 @@ HIDKeyboardService::HIDKeyboardService(BLE &_ble) :
              sizeof(hid_report_map) / sizeof(*hid_report_map),
              
              // input report
-             (uint8_t*)&hid_input_report,
-             sizeof(hid_input_report),
-             input_report_ref_descs,
-             sizeof(input_report_ref_descs) / sizeof(*input_report_ref_descs),
+             (uint8_t*)&hidInputReport,
+             sizeof(hidInputReport),
              
              // output report
-             (uint8_t*)&hid_output_report,
-             sizeof(hid_output_report),
-             output_report_ref_descs,
-             sizeof(output_report_ref_descs) / sizeof(*output_report_ref_descs))
+             (uint8_t*)&hidOutputReport,
+             sizeof(hidOutputReport))
+  , hidInputReport{}
+  , hidOutputReport{}
 {}
 
 KeySym_t HIDKeyboardService::charToKeySym(unsigned char c) const {
@@ -344,12 +302,12 @@ void HIDKeyboardService::sendCharacter(unsigned char c) {
 }
 
 void HIDKeyboardService::keydown(KeySym_t keysym) {
-  hid_input_report.modifiers    = keysym.modifiers;
-  hid_input_report.key_codes[0] = keysym.usage;
+  hidInputReport.modifiers    = keysym.modifiers;
+  hidInputReport.key_codes[0] = keysym.usage;
 }
 
 void HIDKeyboardService::keyup() {
-  memset(&hid_input_report, 0, sizeof(hid_input_report));
+  memset(&hidInputReport, 0, sizeof(hidInputReport));
 }
 
 /* -------------------------------------------------------------------------- */
\ No newline at end of file
@@ -66,10 +66,9 @@ struct KeySym_t {
  *
  * @par usage
  *
- * When this class is instantiated, it adds a keyboard HID service in 
+ * When this class is instantiated, it builds a keyboard HID service for
  * the GattServer.
  *
- * @attention Multiple instances of this hid service are not supported.
  * @see HIDService
  */
 class HIDKeyboardService : public HIDService {
@@ -91,6 +90,19 @@ class HIDKeyboardService : public HIDService {
 
   /* Register a release report. */
   void keyup();
+
+ private:
+  // Input Report
+  struct {
+    uint8_t modifiers;
+    uint8_t reserved;
+    uint8_t key_codes[6];
+  } hidInputReport;
+
+  // Output Report
+  struct {
+    uint8_t leds;
+  } hidOutputReport;
 };
 
 /* -------------------------------------------------------------------------- */
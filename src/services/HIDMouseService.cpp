@@ -5,29 +5,6 @@
 
 namespace {
 
-// Input Report.
-#pragma pack(push, 1)
-struct {
-  uint8_t buttons;
-  uint8_t x;
-  uint8_t y;
-} hid_input_report;
-#pragma pack(pop)
-
-// Input report reference.
-static report_reference_t input_report_ref = { 0, INPUT_REPORT };
-
-static GattAttribute input_report_ref_desc(
-  ATT_UUID_HID_REPORT_ID_MAPPING,
-  (uint8_t*)&input_report_ref,
-  sizeof(input_report_ref),
-  sizeof(input_report_ref)
-);
-
-static GattAttribute *input_report_ref_descs[] = {
-  &input_report_ref_desc,
-};
-
 // Report Map.
 // Example mouse descriptor extracted from the official USB HID reference.
 static uint8_t hid_report_map[] =
@@ -76,19 +53,61 @@ HIDMouseService::HIDMouseService(BLE &_ble) :
              sizeof(hid_report_map) / sizeof(*hid_report_map),
 
              // input report
-             (uint8_t*)&hid_input_report,
-             sizeof(hid_input_report),
-             input_report_ref_descs,
-             sizeof(input_report_ref_descs) / sizeof(*input_report_ref_descs))
+             (uint8_t*)&hidInputReport,
+             sizeof(hidInputReport))
+  , hidInputReport{}
+{}
+
+HIDMouseService::HIDMouseService(BLE &_ble, report_map_t reportMap, uint8_t reportMapLength, uint8_t inputReportID) : 
+  HIDService(_ble,
+             HID_MOUSE,
+
+             // report map
+             reportMap,
+             reportMapLength,
+
+             // input report
+             (uint8_t*)&hidInputReport,
+             sizeof(hidInputReport),
+
+             // no output report
+             nullptr,
+             0,
+
+             inputReportID)
+  , hidInputReport{}
 {}
 
 void HIDMouseService::motion(float fx, float fy) {
-  hid_input_report.x = static_cast<uint8_t>(0x100 + fx * 0x7f) & 0xff;
-  hid_input_report.y = static_cast<uint8_t>(0x100 + fy * 0x7f) & 0xff;
+  hidInputReport.x = static_cast<uint8_t>(0x100 + fx * 0x7f) & 0xff;
+  hidInputReport.y = static_cast<uint8_t>(0x100 + fy * 0x7f) & 0xff;
+}
+
+void HIDMouseService::motionCounts(int dx, int dy) {
+  dx = (dx < -0x7f) ? -0x7f : (dx > 0x7f) ? 0x7f : dx;
+  dy = (dy < -0x7f) ? -0x7f : (dy > 0x7f) ? 0x7f : dy;
+  hidInputReport.x = static_cast<uint8_t>(dx & 0xff);
+  hidInputReport.y = static_cast<uint8_t>(dy & 0xff);
 }
 
 void HIDMouseService::button(Button buttons) {
-  hid_input_report.buttons = static_cast<uint8_t>(buttons); 
+  hidInputReport.buttons = static_cast<uint8_t>(buttons); 
+}
+
+void HIDMouseService::processInputEvents() {
+  uint8_t buttons;
+  while (buttonEvents_.peek(buttons)) {
+    // The last motion was already sent with the previous report.
+    hidInputReport.buttons = buttons;
+    hidInputReport.x = 0;
+    hidInputReport.y = 0;
+
+    // Kept in the queue until the stack has room, so no change is lost.
+    if (SendReport() != BLE_ERROR_NONE) {
+      return;
+    }
+    buttonEvents_.pop(buttons);
+  }
 }
 
 /* -------------------------------------------------------------------------- */
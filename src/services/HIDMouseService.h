@@ -4,6 +4,7 @@
 #if BLE_FEATURE_GATT_SERVER
 
 #include "services/HIDService.h"
+#include "spsc_queue.h"
 
 /* -------------------------------------------------------------------------- */
 
@@ -12,10 +13,9 @@
  *
  * @par usage
  *
- * When this class is instantiated, it adds a mouse HID service in 
+ * When this class is instantiated, it builds a mouse HID service for
  * the GattServer.
  *
- * @attention Multiple instances of this hid service are not supported.
  * @see HIDService
  */
 class HIDMouseService : public HIDService {
@@ -35,7 +35,43 @@ class HIDMouseService : public HIDService {
 
   void motion(float fx, float fy);
 
+  /** Set the relative motion in counts, clamped to [-127, 127]. */
+  void motionCounts(int dx, int dy);
+
   void button(Button buttons);
+
+  /**
+   * Queue a change of the buttons, from an interrupt or another thread. It is
+   * applied and sent by the update task, in order, with no motion.
+   *
+   * @return false when the queue is full.
+   */
+  inline bool postButton(Button buttons) { return buttonEvents_.push(static_cast<uint8_t>(buttons)); }
+
+  /* Number of button changes dropped because the queue was full. */
+  inline uint32_t droppedButtonEvents() const { return buttonEvents_.dropped(); }
+
+  void processInputEvents() override;
+
+ protected:
+  /**
+   * For derived services extending the report map, eg. with feature reports.
+   * @p reportMap must declare the same input report, with @p inputReportID.
+   */
+  HIDMouseService(BLE &_ble, report_map_t reportMap, uint8_t reportMapLength, uint8_t inputReportID);
+
+ private:
+  // Input Report.
+#pragma pack(push, 1)
+  struct {
+    uint8_t buttons;
+    uint8_t x;
+    uint8_t y;
+  } hidInputReport;
+#pragma pack(pop)
+
+  // Button changes posted from other threads, drained by the update task.
+  SpscQueue<uint8_t, 16> buttonEvents_;
 };
 
 /* -------------------------------------------------------------------------- */
@@ -0,0 +1,167 @@
+#include <mbed.h>
+#include "services/HIDRawService.h"
+
+/* -------------------------------------------------------------------------- */
+
+namespace {
+
+// Report Map
+static uint8_t hid_report_map[] =
+{
+  USAGE_PAGE(2),      0x00, 0xFF, // Usage Page (Vendor Defined 0xFF00)
+  USAGE(1),           0x01,       // Usage (Vendor Usage 1)
+  COLLECTION(1),      0x01,       // Collection (Application)
+    LOGICAL_MINIMUM(1), 0x00,       // Logical Minimum (0)
+    LOGICAL_MAXIMUM(2), 0xFF, 0x00, // Logical Maximum (255)
+    REPORT_SIZE(1),     0x08,       // Report Size (8)
+    // Device to host
+    USAGE(1),           0x02,       // Usage (Vendor Usage 2)
+    REPORT_COUNT(1),    HIDRawService::kReportSize,
+    INPUT(1),           0x02,       // Input (Data, Variable, Absolute)
+    // Host to device
+    USAGE(1),           0x03,       // Usage (Vendor Usage 3)
+    REPORT_COUNT(1),    HIDRawService::kReportSize,
+    OUTPUT(1),          0x02,       // Output (Data, Variable, Absolute)
+  END_COLLECTION(0),              // End Collection (Application)
+};
+
+} // namespace ""
+
+/* -------------------------------------------------------------------------- */
+
+HIDRawService::HIDRawService(BLE &_ble) :
+  HIDService(_ble,
+             HID_OTHER,
+
+             // report map
+             hid_report_map,
+             sizeof(hid_report_map) / sizeof(*hid_report_map),
+
+             // input report
+             (uint8_t*)&hidInputReport,
+             sizeof(hidInputReport),
+
+             // output report
+             (uint8_t*)&hidOutputReport,
+             sizeof(hidOutputReport))
+  , hidInputReport{}
+  , hidOutputReport{}
+  , txData_(nullptr)
+  , txSize_(0)
+  , txOffset_(0)
+  , txSequence_(0)
+  , rxSize_(0)
+  , rxSequence_(0)
+  , rxActive_(false)
+  , droppedMessages_(0)
+  , abortedMessages_(0)
+{}
+
+bool HIDRawService::send(const uint8_t *data, size_t size) {
+  if (busy() || !data || !size) {
+    return false;
+  }
+  txData_   = data;
+  txSize_   = size;
+  txOffset_ = 0;
+  pump();
+  return true;
+}
+
+void HIDRawService::onDataWritten(const GattWriteCallbackParams &params) {
+  if (params.handle != outputReportChar.getValueHandle()) {
+    HIDService::onDataWritten(params);
+    return;
+  }
+  if ((params.offset != 0) || (params.len < kHeaderSize)) {
+    return;
+  }
+
+  chunk_t chunk{};
+  memcpy(&chunk, params.data, (params.len < sizeof(chunk)) ? params.len : sizeof(chunk));
+
+  // A new message restarts the reassembly, dropping any incomplete one.
+  if (chunk.flags & CHUNK_START) {
+    if (rxActive_) {
+      ++droppedMessages_;
+    }
+    rxActive_ = true;
+    rxSize_   = 0;
+  } else if (!rxActive_) {
+    return;
+  } else if (chunk.sequence != rxSequence_) {
+    rxActive_ = false;
+    ++droppedMessages_;
+    return;
+  }
+  rxSequence_ = chunk.sequence + 1;
+
+  if ((chunk.length > kPayloadSize) || (rxSize_ + chunk.length > kMaxMessageSize)) {
+    rxActive_ = false;
+    ++droppedMessages_;
+    return;
+  }
+  memcpy(rxBuffer_ + rxSize_, chunk.payload, chunk.length);
+  rxSize_ += chunk.length;
+
+  if (chunk.flags & CHUNK_END) {
+    rxActive_ = false;
+    if (receiveCallback_) {
+      receiveCallback_(rxBuffer_, rxSize_);
+    }
+  }
+}
+
+void HIDRawService::onDataSent(const GattDataSentCallbackParams &params) {
+  HIDService::onDataSent(params);
+
+  // Room was made in the stack buffers, resume the transfer.
+  pump();
+}
+
+void HIDRawService::onDisconnection(ble::connection_handle_t handle) {
+  // (unrouted reports went to the single host)
+  if (busy() && (!routed || (handle == connectionHandle))) {
+    abortMessage();
+  }
+}
+
+void HIDRawService::abortMessage() {
+  txData_ = nullptr;
+  ++abortedMessages_;
+}
+
+void HIDRawService::pump() {
+  while (busy()) {
+    const size_t remaining = txSize_ - txOffset_;
+    const uint8_t payloadSize = chunkPayloadSize();
+    const uint8_t length = (remaining < payloadSize) ? remaining : payloadSize;
+
+    // Each notification is filled up to the payload of the link, the last
+    // chunk padded with zeros.
+    hidInputReport.sequence = txSequence_;
+    hidInputReport.flags    = ((txOffset_ == 0) ? CHUNK_START : 0)
+                            | ((length == remaining) ? CHUNK_END : 0);
+    hidInputReport.length   = length;
+    memcpy(hidInputReport.payload, txData_ + txOffset_, length);
+    memset(hidInputReport.payload + length, 0, payloadSize - length);
+
+    // Backpressure : the chunk is sent again once the stack has room.
+    const ble_error_t error = SendReport(kHeaderSize + payloadSize);
+    if (error == BLE_ERROR_NO_MEM) {
+      return;
+    }
+    if (error != BLE_ERROR_NONE) {
+      abortMessage();
+      return;
+    }
+
+    ++txSequence_;
+    txOffset_ += length;
+    if (txOffset_ >= txSize_) {
+      txData_ = nullptr;
+    }
+  }
+}
+
+/* -------------------------------------------------------------------------- */
@@ -0,0 +1,143 @@
+#ifndef BLE_HID_RAW_SERVICE_H__
+#define BLE_HID_RAW_SERVICE_H__
+
+#if BLE_FEATURE_GATT_SERVER
+
+#include "services/HIDService.h"
+
+/* -------------------------------------------------------------------------- */
+
+/* Size of the vendor reports, in bytes. Each report carries one chunk.
+ * The default is the largest notification payload (ATT MTU of 247 bytes),
+ * chunks being sized to the payload negotiated with the host. */
+#ifndef MBED_BLE_HID_RAW_REPORT_SIZE
+#define MBED_BLE_HID_RAW_REPORT_SIZE        244
+#endif
+
+/* Maximum size of a message received from the host, in bytes. */
+#ifndef MBED_BLE_HID_RAW_MAX_MESSAGE_SIZE
+#define MBED_BLE_HID_RAW_MAX_MESSAGE_SIZE   256
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * BLE HID Raw Service
+ *
+ * @par usage
+ *
+ * When this class is instantiated, it builds a vendor-defined (usage page 0xFF00)
+ * HID service for the GattServer, with an input and an output report used as a
+ * bidirectional data channel.
+ *
+ * Messages are split into chunks, one per report, each starting with a header :
+ *  [0] sequence number, incremented for each chunk of a direction,
+ *  [1] flags (CHUNK_START on the first chunk of a message, CHUNK_END on the last),
+ *  [2] payload length.
+ *
+ * Input chunks fill the notification payload of the current link (see
+ * onPayloadSizeChange), up to the report size, padded with zeros. Below the
+ * full payload the reports are shorter than declared in the report map, the
+ * host padding them (only checked with Linux hosts).
+ *
+ * A message waits for room when the stack is out of buffers, and is aborted
+ * on any other send error or when its host disconnects.
+ *
+ * It is meant to be combined with another service, eg.
+ * Nano33BleHID<HIDKeyboardService, HIDRawService>.
+ *
+ * @see HIDService
+ */
+class HIDRawService : public HIDService {
+ public:
+  static constexpr uint8_t kReportSize  = MBED_BLE_HID_RAW_REPORT_SIZE;
+  static constexpr uint8_t kHeaderSize  = 3;
+  static constexpr uint8_t kPayloadSize = kReportSize - kHeaderSize;
+  static constexpr size_t  kMaxMessageSize = MBED_BLE_HID_RAW_MAX_MESSAGE_SIZE;
+
+  static_assert(kReportSize > kHeaderSize, "Raw reports are too small.");
+
+  enum ChunkFlags {
+    CHUNK_START = 1 << 0,
+    CHUNK_END   = 1 << 1,
+  };
+
+  HIDRawService(BLE &_ble);
+
+  ble::adv_data_appearance_t appearance() const override {
+    return ble::adv_data_appearance_t::GENERIC_HID;
+  }
+
+  /**
+   * Start streaming a message to the host.
+   * The buffer is not copied and must remain valid until busy() returns false.
+   *
+   * @return false when the previous message is still being sent.
+   */
+  bool send(const uint8_t *data, size_t size);
+
+  /* Return true while a message is being sent. */
+  inline bool busy() const { return txData_ != nullptr; }
+
+  /* Set the function called with each message fully received from the host. */
+  inline void onReceive(mbed::Callback<void(const uint8_t*, size_t)> callback) {
+    receiveCallback_ = callback;
+  }
+
+  /* Number of received messages dropped on sequence errors or overflows. */
+  inline uint32_t droppedMessages() const { return droppedMessages_; }
+
+  /* Number of sent messages aborted on send errors or disconnections. */
+  inline uint32_t abortedMessages() const { return abortedMessages_; }
+
+  /* Payload of the chunks sent on the current link, in bytes. */
+  inline uint8_t chunkPayloadSize() const {
+    return (maxPayloadSize() < kReportSize) ? maxPayloadSize() - kHeaderSize : kPayloadSize;
+  }
+
+  void onDataWritten(const GattWriteCallbackParams &params) override;
+  void onDataSent(const GattDataSentCallbackParams &params) override;
+  void onDisconnection(ble::connection_handle_t handle) override;
+
+ private:
+  /* Send chunks until the message is complete or the stack is out of buffers. */
+  void pump();
+
+  /* Drop the message being sent. */
+  void abortMessage();
+
+  /* Chunk format of both reports. */
+#pragma pack(push, 1)
+  struct chunk_t {
+    uint8_t sequence;
+    uint8_t flags;
+    uint8_t length;
+    uint8_t payload[kPayloadSize];
+  };
+#pragma pack(pop)
+
+  chunk_t hidInputReport;
+  chunk_t hidOutputReport;
+
+  // Outgoing message.
+  const uint8_t *txData_;
+  size_t txSize_;
+  size_t txOffset_;
+  uint8_t txSequence_;
+
+  // Incoming message reassembly.
+  uint8_t rxBuffer_[kMaxMessageSize];
+  size_t rxSize_;
+  uint8_t rxSequence_;
+  bool rxActive_;
+
+  uint32_t droppedMessages_;
+  uint32_t abortedMessages_;
+  mbed::Callback<void(const uint8_t*, size_t)> receiveCallback_;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // BLE_FEATURE_GATT_SERVER
+
+#endif // BLE_HID_RAW_SERVICE_H__
@@ -3,10 +3,19 @@
 
 #if BLE_FEATURE_GATT_SERVER
 
+#include <cstring>
+#include <type_traits>
+
 #include <platform/mbed_assert.h>
 #include <ble/BLE.h>
 #include <USBHID_Types.h>
 
+#include "inplace.h"
+#include "delay_histogram.h"
+#include "latency_trace.h"
+#include "report_capture.h"
+#include "report_descriptor.h"
+
 /* -------------------------------------------------------------------------- */
 
 /* Main types of Application Usage define in a report map 
@@ -42,7 +51,6 @@ struct report_reference_t {
 
 typedef uint8_t *const report_map_t;
 typedef uint8_t *const report_t;
-typedef GattAttribute* *const report_ref_desc_array_t;
 
 /* -------------------------------------------------------------------------- */
 
@@ -64,16 +72,28 @@ struct hid_information_t {
  *
  * @par usage
  *
- * When this class is instantiated, it adds a human interface device service in 
- * the GattServer.
+ * When this class is instantiated, it builds the characteristics of a human
+ * interface device service, added to the GattServer by registerService() once
+ * the derived service is fully constructed.
+ *
+ * Report buffers are owned by the derived service and the report reference
+ * descriptors by the service itself, so several instances can live side by side.
+ *
+ * Reports are read by the BLE stack on the events thread : they must only be
+ * updated and sent from it (eg. the update task), inputs sampled elsewhere
+ * being passed through a SpscQueue drained by processInputEvents().
  *
  * @note You can find specification of the human interface device service here:
  * https://www.bluetooth.com/specifications/gatt
- *
- * @attention Multiple instances of this hid service are not supported.
  */
 class HIDService {
  public:
+  // Maximum number of feature reports per service.
+  static constexpr int kMaxFeatureReports = 4;
+
+  // Maximum size of a feature report (must fit a default ATT payload).
+  static constexpr int kMaxFeatureReportLength = 20;
+
   enum HIDType {
     HID_OTHER    = 0,
     HID_KEYBOARD = 1 << 0,
@@ -83,11 +103,15 @@ class HIDService {
    /**
    * Instantiate a Human Device Interface service.
    *
-   * The construction of a HIDService adds a GATT human interface device service in @p
-   * _ble GattServer.
+   * The report buffers are only referenced : they can be members of the derived
+   * service, not yet constructed. Feature reports are declared afterwards with
+   * addFeatureReport(), and the service added to the GattServer with
+   * registerService().
    *
    * @param[in] _ble BLE device which will host the HID service.
    * @param[in] type Specify if the device is to be treat as a mouse, a keyboard, or both.
+   * @param[in] inputReportID Report ID of the input report, when the report map uses them.
+   * @param[in] outputReportID Report ID of the output report, when the report map uses them.
    *
    */
   HIDService(BLE &_ble,
@@ -99,18 +123,12 @@ class HIDService {
              
              report_t inputReport,
              uint8_t inputReportLength,
-             report_ref_desc_array_t inputRefDescs,
-             uint8_t inputRefDescsLength,
 
              report_t outputReport = nullptr,
              uint8_t outputReportLength = 0,
-             report_ref_desc_array_t outputRefDescs = nullptr,
-             uint8_t outputRefDescsLength = 0,
 
-             report_t featureReport = nullptr,
-             uint8_t featureReportLength = 0,
-             report_ref_desc_array_t featureRefDescs = nullptr,
-             uint8_t featureRefDescsLength = 0)
+             uint8_t inputReportID = 0,
+             uint8_t outputReportID = 0)
     :ble(_ble)
 
     ,type(type)
@@ -121,18 +139,32 @@ class HIDService {
     ,outputReport(outputReport)
     ,outputReportLength(outputReportLength)
 
-    ,featureReport(featureReport)
-    ,featureReportLength(featureReportLength)
+    ,numFeatureReports(0)
 
     ,protocolMode(REPORT_PROTOCOL)
 
+    ,inputReportRef{ inputReportID, INPUT_REPORT }
+    ,outputReportRef{ outputReportID, OUTPUT_REPORT }
+
+    ,inputReportRefDesc(
+      ATT_UUID_HID_REPORT_ID_MAPPING,
+      (uint8_t*)&inputReportRef, sizeof(inputReportRef), sizeof(inputReportRef)
+    )
+    ,outputReportRefDesc(
+      ATT_UUID_HID_REPORT_ID_MAPPING,
+      (uint8_t*)&outputReportRef, sizeof(outputReportRef), sizeof(outputReportRef)
+    )
+
+    ,inputReportRefDescs{ &inputReportRefDesc }
+    ,outputReportRefDescs{ &outputReportRefDesc }
+
     ,inputReportChar(
       GattCharacteristic::UUID_REPORT_CHAR,
       inputReport, inputReportLength, inputReportLength, 
       GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_READ
     | GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE
     | GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY,
-      inputRefDescs, inputRefDescsLength
+      inputReportRefDescs, 1
     )
 
     ,outputReportChar(
@@ -141,17 +173,10 @@ class HIDService {
       GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_READ
     | GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE_WITHOUT_RESPONSE
     | GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE,
-      outputRefDescs, outputRefDescsLength
+      outputReportRefDescs, 1
     )
 
-    ,featureReportChar(
-      GattCharacteristic::UUID_REPORT_CHAR,
-      featureReport,featureReportLength, featureReportLength, 
-      GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_READ
-    | GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE,
-      featureRefDescs, featureRefDescsLength
-    )
-    
+
     ,protocolModeChar(
       GattCharacteristic::UUID_PROTOCOL_MODE_CHAR, 
       &protocolMode, 1, 1,
@@ -174,8 +199,20 @@ class HIDService {
       &hidControlPoint, 1, 1,
       GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE_WITHOUT_RESPONSE
     )
+  {}
+
+  virtual ~HIDService() {}
+
+  /** Defines how the device will appeared in bluetooth managers. */
+  virtual ble::adv_data_appearance_t appearance() const = 0; 
+
+  /**
+   * Add the service to the GattServer, with the feature reports declared so
+   * far. Called by MbedBleHID once the service is constructed.
+   */
+  ble_error_t registerService()
   {
-    const int kMaxNumCharacteristics = 10;
+    const int kMaxNumCharacteristics = 6 + kMaxFeatureReports;
     GattCharacteristic *characteristics[kMaxNumCharacteristics]{};
     int charindex = 0;
 
@@ -194,11 +231,29 @@ class HIDService {
       outputReportChar.setReadSecurityRequirement(req);
       outputReportChar.setWriteSecurityRequirement(req);
     }
-    // Feature report (if any)
-    if (featureReport) {
-      characteristics[charindex++] = &featureReportChar;
-      featureReportChar.setReadSecurityRequirement(req);
-      featureReportChar.setWriteSecurityRequirement(req);
+    // Feature reports (if any)
+    for (int i = 0; i < numFeatureReports; ++i) {
+      characteristics[charindex++] = features[i].characteristic.get();
+      features[i].characteristic->setReadSecurityRequirement(req);
+      features[i].characteristic->setWriteSecurityRequirement(req);
+    }
+
+    // Check the report map describes the report buffers, as hosts silently
+    // drop the reports whose length does not match it.
+    {
+      ReportDescriptor descriptor;
+      auto &reportMap = reportMapChar.getValueAttribute();
+      reportMapStatus = descriptor.parse(reportMap.getValuePtr(), reportMap.getLength());
+      if (inputReport && (reportMapStatus == ReportDescriptor::NO_ERROR)) {
+        reportMapStatus = descriptor.check(ReportDescriptor::INPUT, inputReportRef.ID, inputReportLength);
+      }
+      if (outputReport && (reportMapStatus == ReportDescriptor::NO_ERROR)) {
+        reportMapStatus = descriptor.check(ReportDescriptor::OUTPUT, outputReportRef.ID, outputReportLength);
+      }
+      for (int i = 0; (i < numFeatureReports) && (reportMapStatus == ReportDescriptor::NO_ERROR); ++i) {
+        reportMapStatus = descriptor.check(ReportDescriptor::FEATURE, features[i].reference.ID, features[i].length);
+      }
+      MBED_ASSERT(reportMapStatus == ReportDescriptor::NO_ERROR);
     }
 
     // Protocol Mode [optional]
@@ -234,23 +289,261 @@ class HIDService {
       GattService::UUID_HUMAN_INTERFACE_DEVICE_SERVICE,
       characteristics, charindex
     );
-    ble.gattServer().addService(hidService);
+    return ble.gattServer().addService(hidService);
   }
 
-  virtual ~HIDService() {}
+  /**
+   * Apply the input events queued from interrupts or other threads, sending a
+   * report for each. Called by the update task, before the sketch task.
+   */
+  virtual void processInputEvents() {}
 
-  /** Defines how the device will appeared in bluetooth managers. */
-  virtual ble::adv_data_appearance_t appearance() const = 0; 
+  /** Send the input report, must be called from the BLE events thread. */
+  inline ble_error_t SendReport() { return SendReport(inputReportLength); }
+
+  /**
+   * Send the first @p length bytes of the input report only, when its end is
+   * unused (eg. a chunk shorter than the report). Hosts pad it with zeros.
+   */
+  ble_error_t SendReport(uint8_t length)
+  {
+    MBED_ASSERT(length <= inputReportLength);
+
+    const uint32_t sendTime = us_ticker_read();
+    const ble_error_t error = routed 
+      ? ble.gattServer().write(
+          connectionHandle,
+          inputReportChar.getValueHandle(),
+          (uint8_t*)inputReport,
+          length
+        )
+      : ble.gattServer().write(
+          inputReportChar.getValueHandle(),
+          (uint8_t*)inputReport,
+          length
+        );
+
+    // Keep the commit time until the report goes on air.
+    const uint8_t next = (sendTimesHead + 1) % kMaxReportsInFlight;
+    if ((error == BLE_ERROR_NONE) && (next != sendTimesTail)) {
+      sendTimes[sendTimesHead] = sendTime;
+      sendTimesHead = next;
+    }
+#if MBED_BLE_HID_LATENCY_TRACE
+    if (error == BLE_ERROR_NONE) {
+      latencyTrace.accepted(sendTime, us_ticker_read());
+    }
+#endif
+    if (recorder && (error == BLE_ERROR_NONE)) {
+      recorder->record(recorderReportMap, inputReport, length, sendTime);
+    }
+    return error;
+  }
+
+  /**
+   * Mark the time the inputs of the next report were sampled, for the
+   * latency trace. @p timestamp can be captured earlier, eg. in an interrupt.
+   */
+  inline void traceSample(uint32_t timestamp = us_ticker_read())
+  {
+#if MBED_BLE_HID_LATENCY_TRACE
+    latencyTrace.sample(timestamp);
+#endif
+  }
+
+#if MBED_BLE_HID_LATENCY_TRACE
+  /** Timestamps and delays of the last reports through each sending stage. */
+  inline const LatencyTrace& latency() const { return latencyTrace; }
+#endif
+
+  /**
+   * Distribution of the delays between the commit of an input report and the
+   * end of the connection event which sent it, in microseconds.
+   */
+  inline const DelayHistogram& sendDelays() const { return sendDelayHistogram; }
+
+  /**
+   * Send the input reports to the connection @p handle only, instead of all
+   * the subscribed hosts. Used by MbedBleHID when several hosts are connected.
+   */
+  inline void routeReports(ble::connection_handle_t handle)
+  {
+    connectionHandle = handle;
+    routed = true;
+  }
+
+  /** Result of the report map validation done at registration. */
+  inline ReportDescriptor::Error reportMapError() const { return reportMapStatus; }
+
+  /**
+   * Record the input reports sent into @p recorder, along with the report map.
+   * nullptr stops the recording.
+   */
+  void setReportRecorder(ReportRecorder *recorder)
+  {
+    auto &reportMap = reportMapChar.getValueAttribute();
+    const int index = recorder
+      ? recorder->addReportMap(reportMap.getValuePtr(), reportMap.getLength(), inputReportRef.ID)
+      : -1;
+    this->recorder          = (index >= 0) ? recorder : nullptr;
+    this->recorderReportMap = index;
+  }
+
+  /**
+   * Register a typed handler called when the host sets the feature report
+   * @p reportID. T must match the layout of the report.
+   *
+   * @return false when the report does not exist or its size mismatch T.
+   */
+  template<typename T>
+  bool setFeatureReportHandler(uint8_t reportID, void (*handler)(const T&))
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "Feature reports must be trivially copyable.");
+
+    auto *feature = findFeatureReport(reportID);
+    if (!feature || (feature->length != sizeof(T))) {
+      return false;
+    }
+    feature->invoke  = &InvokeFeatureHandler<T>;
+    feature->handler = reinterpret_cast<void (*)()>(handler);
+    return true;
+  }
 
-  void SendReport()
+  /**
+   * Push the buffer of the feature report @p reportID to the GATT server, after
+   * the device changed it : hosts read the copy kept by the stack. Must be
+   * called from the BLE events thread, once the service is registered.
+   */
+  ble_error_t updateFeatureReport(uint8_t reportID)
   {
-    ble.gattServer().write(
-      inputReportChar.getValueHandle(),
-      (uint8_t*)inputReport,
-      inputReportLength
+    auto *feature = findFeatureReport(reportID);
+    if (!feature) {
+      return BLE_ERROR_INVALID_PARAM;
+    }
+    return ble.gattServer().write(
+      feature->characteristic->getValueHandle(),
+      feature->data,
+      feature->length,
+      true    // (feature reports are not notified)
     );
   }
 
+  /** Called by the device when a client writes one of the GATT attributes. */
+  virtual void onDataWritten(const GattWriteCallbackParams &params)
+  {
+    for (int i = 0; i < numFeatureReports; ++i) {
+      auto &feature = features[i];
+      if (params.handle != feature.characteristic->getValueHandle()) {
+        continue;
+      }
+      // Applied right away, this runs on the events thread like the
+      // reports updates (the stack may keep its own copy of the value).
+      if (params.offset + params.len <= feature.length) {
+        memcpy(feature.data + params.offset, params.data, params.len);
+        onFeatureReport(feature.reference.ID, feature.data, feature.length);
+      }
+      return;
+    }
+  }
+
+  /** Called by the device when a notification has been sent. */
+  virtual void onDataSent(const GattDataSentCallbackParams &params)
+  {
+    if ((params.attHandle != inputReportChar.getValueHandle())
+     || (routed && (params.connHandle != connectionHandle))
+     || (sendTimesTail == sendTimesHead)) {
+      return;
+    }
+    const uint32_t sentTime = us_ticker_read();
+    sendDelayHistogram.add(sentTime - sendTimes[sendTimesTail]);
+    sendTimesTail = (sendTimesTail + 1) % kMaxReportsInFlight;
+#if MBED_BLE_HID_LATENCY_TRACE
+    latencyTrace.sent(sentTime);
+#endif
+  }
+
+  /** Called by the device when the host on connection @p handle disconnected. */
+  virtual void onDisconnection(ble::connection_handle_t handle) {}
+
+  /** 
+   * Called by the device when the link parameters changed, with the number of
+   * bytes a single notification can carry without fragmentation.
+   */
+  virtual void onPayloadSizeChange(uint16_t size) { payloadSize = size; }
+
+  /** Maximum size of an input report sent in a single link layer packet. */
+  inline uint16_t maxPayloadSize() const { return payloadSize; }
+
+ protected:
+  /**
+   * Declare a feature report of the report map, read and written by the host
+   * from @p data. Called from the derived service constructor, once its
+   * buffers are constructed, and before registerService().
+   *
+   * @return false when there are already kMaxFeatureReports.
+   */
+  bool addFeatureReport(uint8_t reportID, uint8_t *data, uint8_t length)
+  {
+    MBED_ASSERT(length <= kMaxFeatureReportLength);
+    if (numFeatureReports >= kMaxFeatureReports) {
+      return false;
+    }
+    auto &feature = features[numFeatureReports++];
+    feature.reference = { reportID, FEATURE_REPORT };
+    feature.referenceDesc.emplace(
+      ATT_UUID_HID_REPORT_ID_MAPPING,
+      (uint8_t*)&feature.reference, sizeof(feature.reference), sizeof(feature.reference)
+    );
+    feature.referenceDescs[0] = feature.referenceDesc.get();
+    feature.data   = data;
+    feature.length = length;
+    feature.characteristic.emplace(
+      GattCharacteristic::UUID_REPORT_CHAR,
+      feature.data, feature.length, feature.length,
+      GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_READ
+    | GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE,
+      feature.referenceDescs, 1
+    );
+    return true;
+  }
+
+  template<typename T>
+  inline bool addFeatureReport(uint8_t reportID, T *value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "Feature reports must be trivially copyable.");
+    return addFeatureReport(reportID, reinterpret_cast<uint8_t*>(value), sizeof(T));
+  }
+
+  /** Called on the events thread when the host has written a feature report. */
+  virtual void onFeatureReport(uint8_t reportID, const uint8_t *data, uint8_t length)
+  {
+    auto *feature = findFeatureReport(reportID);
+    if (feature && feature->invoke) {
+      feature->invoke(feature->handler, data);
+    }
+  }
+
+ private:
+  struct FeatureReport;
+
+  template<typename T>
+  static void InvokeFeatureHandler(void (*handler)(), const uint8_t *data)
+  {
+    T value;
+    memcpy(&value, data, sizeof(T));
+    reinterpret_cast<void (*)(const T&)>(handler)(value);
+  }
+
+  FeatureReport* findFeatureReport(uint8_t reportID)
+  {
+    for (int i = 0; i < numFeatureReports; ++i) {
+      if (features[i].reference.ID == reportID) {
+        return &features[i];
+      }
+    }
+    return nullptr;
+  }
+
  protected:
   BLE &ble;
 
@@ -263,20 +556,49 @@ class HIDService {
   report_t          outputReport;
   uint8_t           outputReportLength;
   
-  report_t          featureReport;
-  uint8_t           featureReportLength;
+  uint8_t           numFeatureReports;
 
   uint8_t           protocolMode;
 
   hid_information_t hidInfo;
   uint8_t           hidControlPoint;
 
+  uint16_t          payloadSize = 20;
+
+  // Connection receiving the input reports, when routed.
+  ble::connection_handle_t connectionHandle = 0;
+  bool              routed = false;
+
+  // -- Send delays instrumentation
+  static constexpr uint8_t kMaxReportsInFlight = 8;
+  uint32_t          sendTimes[kMaxReportsInFlight];
+  uint8_t           sendTimesHead = 0;
+  uint8_t           sendTimesTail = 0;
+  DelayHistogram    sendDelayHistogram;
+#if MBED_BLE_HID_LATENCY_TRACE
+  LatencyTrace      latencyTrace;
+#endif
+
+  ReportDescriptor::Error reportMapStatus = ReportDescriptor::NO_ERROR;
+
+  // -- Capture of the input reports sent, when set
+  ReportRecorder   *recorder = nullptr;
+  int               recorderReportMap = -1;
+
+  // -- Report References
+  report_reference_t inputReportRef;
+  report_reference_t outputReportRef;
+
+  GattAttribute      inputReportRefDesc;
+  GattAttribute      outputReportRefDesc;
+
+  GattAttribute     *inputReportRefDescs[1];
+  GattAttribute     *outputReportRefDescs[1];
 
   // -- BLE Characteristics
   // Reports (if any)
   GattCharacteristic inputReportChar;
   GattCharacteristic outputReportChar;
-  GattCharacteristic featureReportChar;
 
   // Optionals (if mouse or keyboard)
   GattCharacteristic protocolModeChar;
@@ -287,6 +609,23 @@ class HIDService {
   GattCharacteristic reportMapChar;
   GattCharacteristic hidInformationChar;
   GattCharacteristic hidControlPointChar;
+
+ private:
+  // -- Feature Reports
+  struct FeatureReport {
+    report_reference_t           reference;
+    InPlace<GattAttribute>       referenceDesc;
+    GattAttribute               *referenceDescs[1];
+    InPlace<GattCharacteristic>  characteristic;
+
+    uint8_t *data;
+    uint8_t  length;
+
+    // Typed user handler, called through its type-specific trampoline.
+    void (*invoke)(void (*handler)(), const uint8_t *data) = nullptr;
+    void (*handler)() = nullptr;
+  };
+  FeatureReport features[kMaxFeatureReports];
 };
 
 /* -------------------------------------------------------------------------- */
@@ -1,64 +1,227 @@
 #ifndef SIGNAL_UTILS_H_
 #define SIGNAL_UTILS_H_
 
-/*  
-  Sets of simple signals processing routines used for a smoother user experience. 
+/*
+  Sets of simple signals processing routines used for a smoother user experience.
+
+  The routines are constexpr templates working on floats as well as on the
+  fixed-point types of fixed_point.h, the latter using integer arithmetic only
+  and a lookup table for smoothstep.
 */
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "fixed_point.h"
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include "cmsis.h"
+#define SIGNAL_UTILS_SIMD 1
+#endif
+
 /* -------------------------------------------------------------------------- */
 
-namespace {
+namespace signal_utils {
+
+/* Type of the arguments following the first one, which are converted to it
+   instead of being deduced (eg. for doubles passed with floats). */
+template<typename T> struct Arg { using type = T; };
+template<typename T> using arg_t = typename Arg<T>::type;
+
+} // namespace signal_utils
 
 /* Return the value x clamped between edge0 and edge1. */
-float clamp(float x, float edge0, float edge1) {
-  return min( edge1, max(edge0, x));
+template<typename T>
+constexpr T clamp(T x, signal_utils::arg_t<T> edge0, signal_utils::arg_t<T> edge1) {
+  return (x < edge0) ? edge0 : (edge1 < x) ? edge1 : x;
 }
 
-float step(float a, float x) {
-  return (a <= x) ? 1.0f : 0.0f;
+template<typename T>
+constexpr T step(T a, signal_utils::arg_t<T> x) {
+  return (a <= x) ? T(1.0f) : T(0.0f);
 }
 
 /* Approximate smooth interpolation of value x from [edge0, edge1] to [0, 1]. */
-float smoothstep(float edge0, float edge1, float x) {
-  x = clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f); 
-  return x * x * (3.0f - 2.0f * x);
+template<typename T>
+constexpr T smoothstep(T edge0, signal_utils::arg_t<T> edge1, signal_utils::arg_t<T> x) {
+  x = clamp((x - edge0) / (edge1 - edge0), T(0.0f), T(1.0f));
+  return x * x * (T(3.0f) - T(2.0f) * x);
 }
 
 /* Map a value from [0, 1] to follow a centerd smoothed curve. */
-float smoothcurve(float x) {
-  return smoothstep(0.0f, 0.5f, x) -
-         smoothstep(0.5f, 1.0f, x); 
+template<typename T>
+constexpr T smoothcurve(T x) {
+  return smoothstep(T(0.0f), T(0.5f), x) -
+         smoothstep(T(0.5f), T(1.0f), x);
 }
 
 /* Return the interpolated value between a and b, where x is in [0, 1]. */
-float lerp(float a, float b, float x) {
+template<typename T>
+constexpr T lerp(T a, signal_utils::arg_t<T> b, signal_utils::arg_t<T> x) {
   return a + x*(b-a);
 }
 
 /* Map the value of x in range [a, b] to range [c, d]. */
-float mmap(float x, float a, float b, float c, float d) {
-  x = (x - a) / (b - a);
-  return lerp(c, d, x);
+template<typename T>
+constexpr T mmap(T x, signal_utils::arg_t<T> a, signal_utils::arg_t<T> b,
+                 signal_utils::arg_t<T> c, signal_utils::arg_t<T> d) {
+  return lerp(c, d, (x - a) / (b - a));
+}
+
+/* -------------------------------------------------------------------------- */
+
+//
+// Fixed-point overloads, keeping the intermediate values in 64-bit so that
+// eg. a Q15 range of [-1, 1[ can be mapped without saturating.
+//
+
+namespace signal_utils {
+
+/* smoothstep(0, 1, i / 64) in Q15, i in [0, 64], built at compile time. */
+struct SmoothstepTable {
+  static constexpr int kSegmentBits = 6;
+  static constexpr int kSize = (1 << kSegmentBits) + 1;
+
+  constexpr SmoothstepTable() : values{} {
+    // t^2 (3 - 2t) * 2^15, for t = i / 64.
+    for (int i = 0; i < kSize; ++i) {
+      values[i] = static_cast<uint16_t>((i * i * (96 - i) + 2) / 4);
+    }
+  }
+
+  uint16_t values[kSize];
+};
+
+static constexpr SmoothstepTable kSmoothstepTable{};
+
+/* Convert a positive Q15 value to the format of F, saturated. */
+template<typename F>
+constexpr F FromQ15(int64_t q15) {
+  return F::Saturate((F::kFractionalBits >= 15)
+    ? q15 * (int64_t(1) << ((F::kFractionalBits - 15) & 63))
+    : q15 / (int64_t(1) << ((15 - F::kFractionalBits) & 63))
+  );
+}
+
+} // namespace signal_utils
+
+template<int kFracBits, typename Storage, typename Wide>
+constexpr Fixed<kFracBits, Storage, Wide> lerp(Fixed<kFracBits, Storage, Wide> a,
+                                               Fixed<kFracBits, Storage, Wide> b,
+                                               Fixed<kFracBits, Storage, Wide> x) {
+  return Fixed<kFracBits, Storage, Wide>::Saturate(static_cast<Wide>(
+    a.raw() + ((int64_t(x.raw()) * (int64_t(b.raw()) - a.raw()) + (int64_t(1) << (kFracBits - 1))) >> kFracBits)
+  ));
 }
 
+template<int kFracBits, typename Storage, typename Wide>
+constexpr Fixed<kFracBits, Storage, Wide> mmap(Fixed<kFracBits, Storage, Wide> x,
+                                               Fixed<kFracBits, Storage, Wide> a,
+                                               Fixed<kFracBits, Storage, Wide> b,
+                                               Fixed<kFracBits, Storage, Wide> c,
+                                               Fixed<kFracBits, Storage, Wide> d) {
+  // x mapped with a single rounding, as c + (x - a) (d - c) / (b - a).
+  return (a == b) ? c : Fixed<kFracBits, Storage, Wide>::Saturate(static_cast<Wide>(
+    c.raw() + ((int64_t(x.raw()) - a.raw()) * (int64_t(d.raw()) - c.raw())) / (int64_t(b.raw()) - a.raw())
+  ));
+}
+
+/* Smoothstep interpolated from a 65 entries table, in integer arithmetic only. */
+template<int kFracBits, typename Storage, typename Wide>
+constexpr Fixed<kFracBits, Storage, Wide> smoothstep(Fixed<kFracBits, Storage, Wide> edge0,
+                                                     Fixed<kFracBits, Storage, Wide> edge1,
+                                                     Fixed<kFracBits, Storage, Wide> x) {
+  using signal_utils::SmoothstepTable;
+  using signal_utils::kSmoothstepTable;
+  using F = Fixed<kFracBits, Storage, Wide>;
+
+  // t = (x - edge0) / (edge1 - edge0) in Q16, clamped to [0, 1].
+  const int64_t t = (edge1 <= edge0) ? ((x < edge0) ? 0 : 0x10000)
+                  : (x <= edge0) ? 0
+                  : (x >= edge1) ? 0x10000
+                  : ((int64_t(x.raw()) - edge0.raw()) << 16) / (int64_t(edge1.raw()) - edge0.raw());
+
+  const int kFracShift = 16 - SmoothstepTable::kSegmentBits;
+  const int index      = static_cast<int>(t >> kFracShift);
+  const int64_t frac   = t & ((1 << kFracShift) - 1);
+  const int64_t v0     = kSmoothstepTable.values[index];
+  const int64_t v1     = kSmoothstepTable.values[(index < SmoothstepTable::kSize - 1) ? index + 1 : index];
+
+  return signal_utils::FromQ15<F>(v0 + (((v1 - v0) * frac) >> kFracShift));
+}
+
+/* -------------------------------------------------------------------------- */
+
+//
+// Batch variants processing a buffer of Q15 samples, using the Cortex-M4 SIMD
+// instructions (two samples per instruction) when available.
+//
+
+namespace batch {
+
+/* out[i] = lerp(a[i], b[i], x) for n samples, x in [0, 1[. */
+inline void Lerp(const Q15 *a, const Q15 *b, Q15 x, Q15 *out, size_t n)
+{
+  size_t i = 0;
+#if SIGNAL_UTILS_SIMD
+  // a (1 - x) + b x, as a (2^15 - 1 - x) + b x + a, using a single SMLAD.
+  const uint32_t weights = (uint32_t)(uint16_t)(INT16_MAX - x.raw()) | ((uint32_t)(uint16_t)x.raw() << 16);
+  for (; i + 2 <= n; i += 2) {
+    uint32_t va, vb;
+    memcpy(&va, a + i, sizeof(va));
+    memcpy(&vb, b + i, sizeof(vb));
+    const int32_t a0 = (int16_t)(va & 0xffff);
+    const int32_t a1 = (int16_t)(va >> 16);
+    const int32_t r0 = __SSAT((int32_t)__SMLAD(__PKHBT(va, vb, 16), weights, a0 + (1 << 14)) >> 15, 16);
+    const int32_t r1 = __SSAT((int32_t)__SMLAD(__PKHTB(vb, va, 16), weights, a1 + (1 << 14)) >> 15, 16);
+    const uint32_t vr = __PKHBT(r0, r1, 16);
+    memcpy(static_cast<void*>(out + i), &vr, sizeof(vr));
+  }
+#endif
+  for (; i < n; ++i) {
+    out[i] = lerp(a[i], b[i], x);
+  }
+}
+
+/* out[i] = a[i] + b[i], saturated, for n samples. */
+inline void Add(const Q15 *a, const Q15 *b, Q15 *out, size_t n)
+{
+  size_t i = 0;
+#if SIGNAL_UTILS_SIMD
+  for (; i + 2 <= n; i += 2) {
+    uint32_t va, vb;
+    memcpy(&va, a + i, sizeof(va));
+    memcpy(&vb, b + i, sizeof(vb));
+    const uint32_t vr = __QADD16(va, vb);
+    memcpy(static_cast<void*>(out + i), &vr, sizeof(vr));
+  }
+#endif
+  for (; i < n; ++i) {
+    out[i] = a[i] + b[i];
+  }
+}
+
+} // namespace batch
+
+/* -------------------------------------------------------------------------- */
+
 /* Return an absolute value before next ticks of time delay, in milliseconds. */
-float tick(float delay = 1000.0f) {
+inline float tick(float delay = 1000.0f) {
   return fmodf(millis(), delay) / delay;
 }
 
 /* Animate a signal output to pin following a smooth curve of period delay, in milliseconds. */
-void animateLED(int pin, float delay=1000.0f) {
+inline void animateLED(int pin, float delay=1000.0f) {
   analogWrite(pin, int(255 * smoothcurve(tick(delay))));
 }
 
 /* Returns a random floating point value in a range. */
-float randf(float edge0=0.0f, float edge1=1.0f) {
+inline float randf(float edge0=0.0f, float edge1=1.0f) {
   float n = random(RAND_MAX) / static_cast<float>(RAND_MAX-1);
   return lerp(edge0, edge1, n);
 }
 
-} // namespace
-
 /* -------------------------------------------------------------------------- */
 
-#endif // SIGNAL_UTILS_H_
\ No newline at end of file
+#endif // SIGNAL_UTILS_H_
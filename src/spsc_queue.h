@@ -0,0 +1,78 @@
+#ifndef SPSC_QUEUE_H_
+#define SPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstdint>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+* Lock-free single-producer / single-consumer ring buffer of N items.
+*
+* Used to pass input events from an interrupt or a sampling thread (the
+* producer) to the BLE events thread (the consumer) which updates and sends the
+* reports, so a report is never read while being modified.
+*
+* push() must only be called by the producer, pop() by the consumer.
+*/
+template<typename T, uint32_t N>
+class SpscQueue {
+  static_assert((N >= 2) && ((N & (N - 1)) == 0), "SpscQueue size must be a power of two.");
+
+  public:
+    /** Producer side : enqueue an item, return false when the queue is full. */
+    bool push(const T &item) {
+      const uint32_t head = head_.load(std::memory_order_relaxed);
+      if (head - tail_.load(std::memory_order_acquire) == N) {
+        dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+      }
+      items_[head & (N - 1)] = item;
+      head_.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    /** Consumer side : read the oldest item without dequeuing it, return false when empty. */
+    bool peek(T &item) const {
+      const uint32_t tail = tail_.load(std::memory_order_relaxed);
+      if (head_.load(std::memory_order_acquire) == tail) {
+        return false;
+      }
+      item = items_[tail & (N - 1)];
+      return true;
+    }
+
+    /** Consumer side : dequeue the oldest item, return false when empty. */
+    bool pop(T &item) {
+      const uint32_t tail = tail_.load(std::memory_order_relaxed);
+      if (head_.load(std::memory_order_acquire) == tail) {
+        return false;
+      }
+      item = items_[tail & (N - 1)];
+      tail_.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    inline bool empty() const {
+      return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    inline uint32_t size() const {
+      return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    /** Number of items rejected because the queue was full. */
+    inline uint32_t dropped() const {
+      return dropped_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    T items_[N];
+    std::atomic<uint32_t> head_{0};
+    std::atomic<uint32_t> tail_{0};
+    std::atomic<uint32_t> dropped_{0};
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // SPSC_QUEUE_H_